@@ -0,0 +1,116 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef IG_RPIHAL_BITBANG_H
+#define IG_RPIHAL_BITBANG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define RPIHAL_BITBANG_WIDTH_MAX (16)
+
+//! Clocked bus, e.g. a 74HC595 chain (width 1) or a parallel LCD (width 4/8, clock is the enable strobe).
+typedef struct
+{
+    int clk;                            // clock/strobe pin
+    int data[RPIHAL_BITBANG_WIDTH_MAX]; // data pins, `data[0]` is bit 0
+    int width;                          // number of data pins, __1__ for a serial bus
+    int latch;                          // pin pulsed after the transfer, negative if none
+    int msbFirst;                       // boolean, bit order on a serial bus
+    int clkIdle;                        // clock level while idle, the data is taken on the edge leaving it
+    uint32_t setup;                     // [ns] data valid (and clock idle) before the active clock edge
+    uint32_t hold;                      // [ns] clock active time, the data is held
+    uint32_t latchPulse;                // [ns]
+} RPIHAL_BITBANG_bus_t;
+
+//! Written by `RPIHAL_BITBANG_run()` as GPSET0, GPCLR0 and then waiting `delay`.
+typedef struct
+{
+    uint32_t set;
+    uint32_t clr;
+    uint32_t delay; // [ns]
+} RPIHAL_BITBANG_step_t;
+
+/**
+ * @brief Compiled transfer.
+ *
+ * Zero initialise before the first use, reuse it to avoid reallocations. Do not write to this struct.
+ */
+typedef struct
+{
+    RPIHAL_BITBANG_step_t* steps;
+    size_t count;
+    size_t capacity;
+    uint32_t pins; // all pins of the bus
+} RPIHAL_BITBANG_program_t;
+
+
+
+void RPIHAL_BITBANG_defaultBus(RPIHAL_BITBANG_bus_t* bus);
+
+/**
+ * @brief Compiles the transfer of `data` into a sequence of set/clear masks.
+ *
+ * Each clock cycle takes at most two steps: data and clock idle level, then the active clock edge. Only data pins
+ * which change are written, so an unchanged bit costs one register write less. The pins have to be in GPIO bank 0
+ * (GPIO 0..31), the GPIO module has to be initialised to validate them.
+ *
+ * @param [in,out] program The compiled steps, replaces the previous content
+ * @param bus
+ * @param data One byte per word for `width <= 8` (a whole byte is shifted out on a serial bus), `uint16_t` otherwise
+ * @param count Number of words in `data`
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_BITBANG_compile(RPIHAL_BITBANG_program_t* program, const RPIHAL_BITBANG_bus_t* bus, const void* data, size_t count);
+
+/**
+ * @brief Executes the program on the unchecked register path.
+ *
+ * The registers are written like `RPIHAL_GPIO_fastSet()`, delays are busy waited on `CLOCK_MONOTONIC`. Steps without a
+ * delay follow each other as fast as the bus allows. Like the fast functions it bypasses the register backend, with the
+ * anon backend GPLEV is not updated.
+ *
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_BITBANG_run(const RPIHAL_BITBANG_program_t* program);
+
+//! @brief Frees the steps, the program can be reused afterwards.
+void RPIHAL_BITBANG_free(RPIHAL_BITBANG_program_t* program);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IG_RPIHAL_BITBANG_H
@@ -29,8 +29,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef IG_RPIHAL_GPIO_H
 #define IG_RPIHAL_GPIO_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include <rpihal/rpihal.h>
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -56,7 +59,8 @@ enum RPIHAL_GPIO_PULL
 
 enum RPIHAL_GPIO_DRIVE
 {
-    RPIHAL_GPIO_DRIVE_2mA = 0,
+    RPIHAL_GPIO_DRIVE_KEEP = 0, // the pad control register is not written
+    RPIHAL_GPIO_DRIVE_2mA,
     RPIHAL_GPIO_DRIVE_4mA,
     RPIHAL_GPIO_DRIVE_6mA,
     RPIHAL_GPIO_DRIVE_8mA,
@@ -66,6 +70,12 @@ enum RPIHAL_GPIO_DRIVE
     RPIHAL_GPIO_DRIVE_16mA,
 };
 
+enum RPIHAL_GPIO_SLEW
+{
+    RPIHAL_GPIO_SLEW_LIMITED = 0,
+    RPIHAL_GPIO_SLEW_FAST,
+};
+
 enum RPIHAL_GPIO_AF
 {
     RPIHAL_GPIO_AF_0 = 0,
@@ -77,17 +87,97 @@ enum RPIHAL_GPIO_AF
 };
 
 
+enum RPIHAL_GPIO_EDGE
+{
+    RPIHAL_GPIO_EDGE_NONE = 0,
+    RPIHAL_GPIO_EDGE_RISING = 0x01,
+    RPIHAL_GPIO_EDGE_FALLING = 0x02,
+    RPIHAL_GPIO_EDGE_BOTH = (RPIHAL_GPIO_EDGE_RISING | RPIHAL_GPIO_EDGE_FALLING),
+    RPIHAL_GPIO_EDGE_ASYNC = 0x10, // flag, use the asynchronous detectors (not sampled, catches very short pulses)
+};
+
+
+enum RPIHAL_GPIO_BACKEND
+{
+    RPIHAL_GPIO_BACKEND_MMAP = 0,      // registers mapped from `/dev/gpiomem` (`/dev/gpiomem0` on RP1) or `/dev/mem`
+    RPIHAL_GPIO_BACKEND_ANON = 1,      // register file in anonymous memory, no hardware is accessed
+    RPIHAL_GPIO_BACKEND_TRACE = 0x100, // flag, reports every register access of the selected backend
+};
+
+enum RPIHAL_GPIO_ACCESS
+{
+    RPIHAL_GPIO_ACCESS_AUTO = 0, // barrier (the supported SoCs don't need the erratum)
+    RPIHAL_GPIO_ACCESS_BARRIER,  // single access, memory barrier before writes and after reads
+    RPIHAL_GPIO_ACCESS_RELAXED,  // single access without barriers, same as the fast path
+    RPIHAL_GPIO_ACCESS_ERRATUM,  // every access is done twice (see chapter 1.3 in BCM2835-ARM-Peripherals.pdf), manual only
+};
+
+
 typedef volatile uint32_t RPIHAL_reg_t; // register type
 typedef RPIHAL_reg_t* RPIHAL_regptr_t;  // register pointer
 
+/**
+ * @brief Pin configuration.
+ *
+ * The pad control (`drive`, `slew` and `hysteresis`) is only written if `drive` is not `RPIHAL_GPIO_DRIVE_KEEP`, which
+ * is `0`, so zero initialised structs leave the pads alone. On BCM283x/BCM2711 the pads are controlled per group (GPIO
+ * 0..27, 28..45 and 46..53/57), the configuration of a pin is applied to its whole group and the PADS block is only
+ * accessible through `/dev/mem` (root). If it isn't accessible, the init fails before any register is written. On RP1
+ * each pin has its own pad, the drive strength is rounded up to 2, 4, 8 or 12mA.
+ */
 typedef struct
 {
     int mode;
     int pull;
-    // int drive;
-    int altfunc; // [ANOM1](https://github.com/oblaser/rpihal/blob/main/anomalies.md#anom1---gpio-alternate-function-registers)
+    int altfunc;    // [ANOM1](https://github.com/oblaser/rpihal/blob/main/anomalies.md#anom1---gpio-alternate-function-registers)
+    int drive;      // one of `RPIHAL_GPIO_DRIVE`
+    int slew;       // one of `RPIHAL_GPIO_SLEW`
+    int hysteresis; // boolean, schmitt trigger input
 } RPIHAL_GPIO_init_t;
 
+//! List entry of `RPIHAL_GPIO_initPinList()`
+typedef struct
+{
+    int pin; // BCM GPIO pin number
+    RPIHAL_GPIO_init_t init;
+} RPIHAL_GPIO_pinInit_t;
+
+/**
+ * @brief Pre-validated pin handle for the unchecked fast path.
+ *
+ * Initialised by `RPIHAL_GPIO_getPinHandle()`, don't write to it.
+ */
+typedef struct
+{
+    RPIHAL_regptr_t set; // GPSETn, RP1: SET alias of RIO OUT
+    RPIHAL_regptr_t clr; // GPCLRn, RP1: CLR alias of RIO OUT
+    RPIHAL_regptr_t lev; // GPLEVn, RP1: RIO SYNC_IN
+    RPIHAL_regptr_t tgl; // RP1: XOR alias of RIO OUT, `NULL` on BCM283x/BCM2711 (no toggle register)
+    uint32_t bit;
+} RPIHAL_GPIO_pin_t;
+
+/**
+ * @brief Register image of the pin configuration, see `RPIHAL_GPIO_snapshot()`.
+ *
+ * Only the fields of the SoC the snapshot has been taken on are used.
+ */
+typedef struct
+{
+    RPIHAL_model_t model;
+    uint64_t pins;     // pins in the snapshot (all accessible pins)
+    uint64_t out;      // output latch, only valid for output pins
+    uint32_t fsel[6];  // BCM GPFSELn
+    uint32_t pull[4];  // BCM2711 GPIO_PUP_PDN_CNTRL_REGn, the pull state of BCM283x can't be read
+    uint32_t ctrl[28]; // RP1 GPIO CTRL
+    uint32_t pads[28]; // RP1 PADS
+    uint32_t oe;       // RP1 RIO OE
+} RPIHAL_GPIO_snapshot_t;
+
+//! @param write TRUE (`1`) on register writes, FALSE (`0`) on reads
+//! @param offset Register offset relative to the GPIO base address [bytes]
+//! @param value The written or read value
+typedef void (*RPIHAL_GPIO_trace_cb_t)(int write, uint32_t offset, uint32_t value);
+
 
 //! @return __0__ on success, __negative__ on error
 //!
@@ -95,6 +185,53 @@ typedef struct
 //!
 int RPIHAL_GPIO_init();
 
+/**
+ * @brief Initialises the GPIO module with the specified register backend.
+ *
+ * `RPIHAL_GPIO_init()` is the same as `RPIHAL_GPIO_initBackend(RPIHAL_GPIO_BACKEND_MMAP, RPIHAL_model_unknown)`.
+ *
+ * The anon backend emulates the register block of the specified model in memory: writes to GPSET/GPCLR set/clear the
+ * corresponding bits in GPLEV, all other registers behave like plain memory. For a BCM2712 model (RP1) the XOR, SET and
+ * CLR aliases are emulated and RIO OUT is looped back to SYNC_IN. Together with `RPIHAL_CONFIG_OFFTARGET` it allows to
+ * run and benchmark the register path on any Linux machine.
+ *
+ * On BCM2712 (Pi 5, CM5) the GPIOs are accessed in the RP1 southbridge, only bank 0 (GPIO 0..27) is available.
+ *
+ * Can only be called once, subsequent calls with another backend fail. Concurrent calls are serialised, the module
+ * is visible to other threads as initialised only after it's completely set up.
+ *
+ * @param id One of `RPIHAL_GPIO_BACKEND_MMAP` or `RPIHAL_GPIO_BACKEND_ANON`, optionally combined with
+ * `RPIHAL_GPIO_BACKEND_TRACE` by bitwise or
+ * @param model The model to initialise for, `RPIHAL_model_unknown` to detect the model
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_GPIO_initBackend(int id, RPIHAL_model_t model);
+
+/**
+ * @brief Sets the callback invoked on every register access if `RPIHAL_GPIO_BACKEND_TRACE` is set.
+ *
+ * If no callback is set (`NULL`, default), the accesses are printed to stdout.
+ */
+void RPIHAL_GPIO_setTraceCallback(RPIHAL_GPIO_trace_cb_t cb);
+
+/**
+ * @brief Selects how the registers are accessed by the checked API.
+ *
+ * Can be called before or after `RPIHAL_GPIO_init()`. `RPIHAL_GPIO_ACCESS_AUTO` selects the barrier mode, BCM2835
+ * models are not supported yet, so the erratum mode is never selected automatically. The fast path
+ * (`RPIHAL_GPIO_fast*()`) always accesses the registers relaxed.
+ *
+ * Other threads may access the GPIO meanwhile, the backend is swapped atomically (an access in flight completes with
+ * the previous mode). Concurrent calls of this function are not allowed.
+ *
+ * @param mode One of `RPIHAL_GPIO_ACCESS`
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_GPIO_setAccessMode(int mode);
+
+//! @return The resolved access mode, never `RPIHAL_GPIO_ACCESS_AUTO`
+int RPIHAL_GPIO_getAccessMode();
+
 //! @param pin BCM GPIO pin number
 //! @param initStruct Pin configuration
 //! @return __0__ on success, __negative__ on error
@@ -103,12 +240,60 @@ int RPIHAL_GPIO_initPin(int pin, const RPIHAL_GPIO_init_t* initStruct);
 /**
  * @brief Configures the pins according to `initStruct`.
  *
+ * The pins are configured as a batch, each function select and pull register is written once. On BCM283x the pull
+ * settings are clocked in by a single GPPUD sequence. Invalid pins are skipped and reported as error.
+ *
+ * Pins can be configured from multiple threads, each function select and pull register is modified while holding a
+ * lock of that register (the whole GPPUD sequence on BCM283x). The output path (GPSET/GPCLR) doesn't take these locks.
+ *
  * @param bits Bits coresponding to the pins to be configured
  * @param initStruct Pin configuration
  * @return __0__ on success, __negative__ on error
  */
 int RPIHAL_GPIO_initPins(uint64_t bits, const RPIHAL_GPIO_init_t* initStruct);
 
+/**
+ * @brief Configures each pin in the list according to its own configuration.
+ *
+ * Same as `RPIHAL_GPIO_initPins()`, but with a configuration per pin. On BCM283x one GPPUD sequence is done per
+ * distinct pull setting. If a pin is listed more than once, the last entry wins.
+ *
+ * @param list Array of pins and their configuration
+ * @param count Number of elements in `list`
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_GPIO_initPinList(const RPIHAL_GPIO_pinInit_t* list, size_t count);
+
+/**
+ * @brief Arms the hardware edge detection (GPREN/GPFEN or GPAREN/GPAFEN) of the pins.
+ *
+ * Detected edges are latched in GPEDS until they are fetched by `RPIHAL_GPIO_fetchEvents()`, so pulses shorter than
+ * the polling interval are not missed. Events latched before arming are discarded.
+ *
+ * __Caution:__ on Linux the GPIO interrupts belong to the kernel. Enabling edge detection on a pin which is not
+ * requested by a kernel driver (gpio-keys, libgpiod events, etc.) raises the GPIO bank interrupt without a handler
+ * clearing it, the kernel then disables the interrupt line ("nobody cared") or the system stalls. Only use it on
+ * systems where the bank interrupts are not used, otherwise use the GPIO character device events.
+ *
+ * Not implemented for RP1.
+ *
+ * @param bits Bits coresponding to the pins
+ * @param edge One of `RPIHAL_GPIO_EDGE`, optionally combined with `RPIHAL_GPIO_EDGE_ASYNC` by bitwise or
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_GPIO_setEdgeDetect(uint64_t bits, int edge);
+
+/**
+ * @brief Fetches and clears the latched edge events of the pins.
+ *
+ * Only the returned bits are cleared, an edge detected in between is returned by the next call. The direction of the
+ * edge is not latched, read the level if both edges are armed.
+ *
+ * @param bits Bits coresponding to the pins
+ * @return Bits of the pins on which an edge has been detected
+ */
+uint64_t RPIHAL_GPIO_fetchEvents(uint64_t bits);
+
 //! @param pin BCM GPIO pin number
 //! @return __0__ LOW / __1__ HIGH / __negative__ on error
 int RPIHAL_GPIO_readPin(int pin);
@@ -128,10 +313,48 @@ int RPIHAL_GPIO_set(uint32_t bits);
 //! @return __0__ on success, __negative__ on error
 int RPIHAL_GPIO_clr(uint32_t bits);
 
-//! @param pin BCM GPIO pin number
-//! @return __0__ on success, __negative__ on error
+/**
+ * @brief Writes the pins selected by `mask` to the state of the corresponding bit in `value`.
+ *
+ * Only the GPSET0/1 and GPCLR0/1 registers with at least one bit to be changed are written, the set registers are
+ * written first. Bits of non user pins are masked, no error is reported on them.
+ *
+ * @param mask Bits coresponding to the pins to be written
+ * @param value Pin states, one bit per pin
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_GPIO_write64(uint64_t mask, uint64_t value);
+
+/**
+ * @brief Toggles the pin by one GPSET/GPCLR write.
+ *
+ * The new level is computed from the output shadow (see `RPIHAL_GPIO_readOutput64()`), GPLEV is not read. Concurrent
+ * toggles of the same pin from multiple threads are not lost in the shadow, but on BCM the register writes may land in
+ * the opposite order, the pin level is then last-writer-wins (on RP1 the toggle is a single XOR write).
+ *
+ * @param pin BCM GPIO pin number
+ * @return __0__ on success, __negative__ on error
+ */
 int RPIHAL_GPIO_togglePin(int pin);
 
+//! @brief Toggles the pins, one GPSET and one GPCLR write per bank. Bits of non user pins are masked.
+//! @param bits Bits coresponding to the pins
+//! @return __0__ on success, __negative__ on error
+int RPIHAL_GPIO_toggle64(uint64_t bits);
+
+/**
+ * @brief Returns the output shadow, the levels last written to the pins.
+ *
+ * The shadow is updated atomically (lock-free) by all checked write functions, GPSET/GPCLR are written without a lock.
+ * Concurrent writes to the same pin are last-writer-wins, the register writes of two threads may land in the opposite
+ * order of their shadow updates. It's loaded from GPLEV at init and when pins are configured as outputs. Writes by the
+ * fast path (`RPIHAL_GPIO_fast*()`), `RPIHAL_BITBANG_run()` and DMA are not seen by it, the next set/clear write of the
+ * pin brings it back in sync.
+ *
+ * @return Bits of the pins, the bits of pins never written or configured as output are undefined
+ */
+uint64_t RPIHAL_GPIO_readOutput64();
+
 //! @return __0__ on success, __negative__ on error
 //!
 //! Resets all user pins to their default setups.
@@ -145,6 +368,35 @@ int RPIHAL_GPIO_reset();
 //!
 int RPIHAL_GPIO_resetPin(int pin);
 
+/**
+ * @brief Reads the function select, pull and output registers of all accessible pins.
+ *
+ * @param [out] snapshot
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_GPIO_snapshot(RPIHAL_GPIO_snapshot_t* snapshot);
+
+/**
+ * @brief Restores the configuration and output levels of a snapshot.
+ *
+ * The current registers are read and only the registers which differ are written, only the fields of the pins in the
+ * snapshot are changed. The output levels are restored first, so that pins which become outputs start with their
+ * snapshot level. The pull state of BCM283x pins is not restored (see `RPIHAL_GPIO_snapshot_t`).
+ *
+ * @param snapshot Snapshot taken on the same model
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_GPIO_restore(const RPIHAL_GPIO_snapshot_t* snapshot);
+
+/**
+ * @brief Compares two snapshots.
+ *
+ * A pin differs if its function, pull or pad differs or if it's an output in `a` and the output level differs.
+ *
+ * @return Bits of the pins which differ, all pins of both snapshots if they have been taken on different models
+ */
+uint64_t RPIHAL_GPIO_diffSnapshot(const RPIHAL_GPIO_snapshot_t* a, const RPIHAL_GPIO_snapshot_t* b);
+
 //! @param [out] initStruct
 void RPIHAL_GPIO_defaultInitStruct(RPIHAL_GPIO_init_t* initStruct);
 
@@ -155,6 +407,31 @@ void RPIHAL_GPIO_defaultInitStruct(RPIHAL_GPIO_init_t* initStruct);
 //!
 int RPIHAL_GPIO_defaultInitStructPin(int pin, RPIHAL_GPIO_init_t* initStruct);
 
+/**
+ * @brief Validates the pin and initialises the handle for the `RPIHAL_GPIO_fast..` functions.
+ *
+ * The fast functions are not checked, they compile down to one volatile register access. Toggle is a single write to
+ * the XOR alias on RP1, on BCM283x/BCM2711 it's a GPLEV read followed by a GPSET/GPCLR write (there is no toggle
+ * register). They bypass the register backend, so accesses are not traced and with the anon backend neither GPLEV nor
+ * RIO OUT is updated.
+ *
+ * @param [out] handle
+ * @param pin BCM GPIO pin number
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_GPIO_getPinHandle(RPIHAL_GPIO_pin_t* handle, int pin);
+
+static inline void RPIHAL_GPIO_fastSet(const RPIHAL_GPIO_pin_t* pin) { *(pin->set) = pin->bit; }
+static inline void RPIHAL_GPIO_fastClr(const RPIHAL_GPIO_pin_t* pin) { *(pin->clr) = pin->bit; }
+static inline void RPIHAL_GPIO_fastWrite(const RPIHAL_GPIO_pin_t* pin, int state) { *(state ? pin->set : pin->clr) = pin->bit; }
+static inline int RPIHAL_GPIO_fastRead(const RPIHAL_GPIO_pin_t* pin) { return ((*(pin->lev) & pin->bit) ? 1 : 0); }
+static inline void RPIHAL_GPIO_fastToggle(const RPIHAL_GPIO_pin_t* pin)
+{
+    if (pin->tgl) { *(pin->tgl) = pin->bit; }
+    else { RPIHAL_GPIO_fastWrite(pin, !RPIHAL_GPIO_fastRead(pin)); }
+}
+
+//! @return Base of the mapped register block, on RP1 IO_BANK0 (followed by SYS_RIO0 and PADS_BANK0)
 RPIHAL_regptr_t RPIHAL_GPIO_getMemBasePtr();
 
 //! @return TRUE (`1`), FALSE (`0`) or unknown (`-1`)
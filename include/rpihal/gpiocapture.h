@@ -0,0 +1,151 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef IG_RPIHAL_GPIOCAPTURE_H
+#define IG_RPIHAL_GPIOCAPTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//! Run-length compressed sample, the levels are valid until the next change. Fixed size and without padding, an array
+//! of changes can be written to a file as is (compact binary format).
+typedef struct
+{
+    uint64_t timestamp; // [ns] since the start of the capture
+    uint64_t level;     // pin levels as returned by `RPIHAL_GPIO_read64()`, masked by the captured bits
+} RPIHAL_GPIOCAPTURE_change_t;
+
+typedef struct
+{
+    uint64_t bits;     // pins to capture
+    uint32_t rate;     // sample rate [Hz], __0__ to sample as fast as possible, max 1GHz
+    uint64_t nSamples; // number of samples to take, __0__ to sample until `RPIHAL_GPIOCAPTURE_stop()` is called
+    size_t capacity;   // number of changes the buffer can hold, rounded up to the next power of two
+    int cpu;           // CPU to pin the sampling thread to, negative to not pin it
+    int priority;      // `SCHED_FIFO` priority of the sampling thread, __0__ to keep `SCHED_OTHER`
+} RPIHAL_GPIOCAPTURE_config_t;
+
+typedef struct
+{
+    uint64_t samples;     // number of samples taken
+    uint64_t changes;     // number of changes put into the buffer
+    uint64_t overflows;   // number of changes dropped because the buffer was full
+    uint64_t late;        // number of sample slots missed because the thread was too late
+    uint64_t maxLateness; // [ns]
+    int running;
+} RPIHAL_GPIOCAPTURE_stats_t;
+
+/**
+ * @brief GPIO capture instance.
+ *
+ * Do not write to this struct.
+ */
+typedef struct
+{
+    RPIHAL_GPIOCAPTURE_config_t config;
+    void* capture;     // internal
+    uint64_t vcdLevel; // internal, last level written by `RPIHAL_GPIOCAPTURE_writeVcd()`
+    int vcdStarted;    // internal
+} RPIHAL_GPIOCAPTURE_instance_t;
+
+
+
+void RPIHAL_GPIOCAPTURE_defaultConfig(RPIHAL_GPIOCAPTURE_config_t* config);
+
+/**
+ * @brief Starts a thread which samples the pins at a fixed rate (logic analyzer).
+ *
+ * Samples by `RPIHAL_GPIO_read64()`, the GPIO module has to be initialised. Only samples which differ from the
+ * previous one are put into the buffer (run-length compression), so the memory is bounded by the number of changes,
+ * not by the duration. The buffer is a lock-free ring which is drained by `RPIHAL_GPIOCAPTURE_read()`, so a capture can
+ * be streamed to a file while it's running.
+ *
+ * Below 10kHz the thread sleeps between the samples, above it busy waits. For high rates pin the thread to an isolated
+ * CPU (`isolcpus`) and give it a realtime priority.
+ *
+ * @param [out] inst
+ * @param config
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIOCAPTURE_start(RPIHAL_GPIOCAPTURE_instance_t* inst, const RPIHAL_GPIOCAPTURE_config_t* config);
+
+/**
+ * @brief Moves the captured changes out of the buffer, must only be called by one thread at a time.
+ *
+ * The first change of a capture is the initial level at timestamp __0__.
+ *
+ * @param inst
+ * @param [out] changes
+ * @param count Size of `changes`
+ * @return Number of changes moved to `changes`
+ */
+size_t RPIHAL_GPIOCAPTURE_read(RPIHAL_GPIOCAPTURE_instance_t* inst, RPIHAL_GPIOCAPTURE_change_t* changes, size_t count);
+
+//! @param [out] stats
+//! @return __0__ on success, __negative__ if no capture has been started
+int RPIHAL_GPIOCAPTURE_getStats(const RPIHAL_GPIOCAPTURE_instance_t* inst, RPIHAL_GPIOCAPTURE_stats_t* stats);
+
+/**
+ * @brief Stops the sampling thread and frees the buffer, the changes not yet read are lost.
+ *
+ * @param [in,out] inst
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIOCAPTURE_stop(RPIHAL_GPIOCAPTURE_instance_t* inst);
+
+/**
+ * @brief Writes the header of a Value Change Dump (IEEE 1364) for the captured pins.
+ *
+ * The VCD can be opened with e.g. GTKWave or PulseView.
+ *
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIOCAPTURE_writeVcdHeader(RPIHAL_GPIOCAPTURE_instance_t* inst, FILE* fp);
+
+/**
+ * @brief Appends the changes to the Value Change Dump.
+ *
+ * Can be called repeatedly with the output of `RPIHAL_GPIOCAPTURE_read()` to stream the capture.
+ *
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIOCAPTURE_writeVcd(RPIHAL_GPIOCAPTURE_instance_t* inst, FILE* fp, const RPIHAL_GPIOCAPTURE_change_t* changes, size_t count);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IG_RPIHAL_GPIOCAPTURE_H
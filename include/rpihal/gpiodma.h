@@ -0,0 +1,137 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef IG_RPIHAL_GPIODMA_H
+#define IG_RPIHAL_GPIODMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rpihal/gpiowave.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define RPIHAL_GPIODMA_MEM_MAX (16u * 1024u * 1024u) // [bytes] max DMA memory (control blocks and data) of one playback
+
+
+/**
+ * @brief Called by the monitor thread after each pass through the buffer.
+ *
+ * @param arg `RPIHAL_GPIODMA_config_t::arg`
+ * @param pass Number of completed passes
+ * @param done TRUE (`1`) if the playback has ended
+ */
+typedef void (*RPIHAL_GPIODMA_cb_t)(void* arg, uint64_t pass, int done);
+
+typedef struct
+{
+    int backend;                  // `RPIHAL_GPIO_BACKEND_MMAP` or `RPIHAL_GPIO_BACKEND_ANON`, same as the GPIO and PWM module
+    int channel;                  // DMA channel, must not be used by the kernel
+    uint32_t tick;                // [ns] delay resolution, the time one PWM FIFO word takes
+    uint32_t loops;               // number of passes, __0__ to play the buffer until `RPIHAL_GPIODMA_stop()` is called
+    uint32_t poll;                // [us] poll interval of the monitor thread
+    RPIHAL_GPIODMA_cb_t callback; // may be `NULL`
+    void* arg;
+} RPIHAL_GPIODMA_config_t;
+
+typedef struct
+{
+    uint64_t pass; // number of completed passes, may miss passes shorter than the poll interval if looping forever
+    size_t step;   // index of the entry currently being played
+    uint32_t tick; // [ns] the actual delay resolution
+    int running;
+} RPIHAL_GPIODMA_status_t;
+
+/**
+ * @brief DMA playback instance.
+ *
+ * Do not write to this struct.
+ */
+typedef struct
+{
+    void* dma; // internal
+} RPIHAL_GPIODMA_instance_t;
+
+
+
+void RPIHAL_GPIODMA_defaultConfig(RPIHAL_GPIODMA_config_t* config);
+
+/**
+ * @brief Plays the waveform by a DMA control block chain, paced by the PWM DREQ.
+ *
+ * Each entry becomes one control block writing GPSET0..GPCLR1 (the reserved register inbetween is written with 0),
+ * followed by control blocks writing `delay / tick` words to the PWM FIFO. The DMA engine has to wait for the PWM to
+ * take each word, so the timing is given by the PWM clock and not by the CPU. The delays are rounded on the absolute
+ * timeline, the rounding error doesn't accumulate.
+ *
+ * Like with `RPIHAL_GPIOWAVE_play()` `set` wins over `clr`. `wave` is copied into uncached memory allocated by the VideoCore mailbox, it can
+ * be freed after this call. Only one pass is built, with `loops > 1` a small patch control block per pass (32 + 4 bytes)
+ * counts the passes. `play` fails if the waveform needs more than `RPIHAL_GPIODMA_MEM_MAX` bytes.
+ *
+ * The GPIO and PWM modules have to be initialised with `config->backend`, the pins configured as outputs. PWM channel
+ * 0 and the PWM clock are used by this module. With the anon backend the DMA engine is emulated by a thread executing
+ * the control blocks.
+ *
+ * @param [out] inst
+ * @param wave Waveform entries
+ * @param count Number of entries in `wave`
+ * @param config
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIODMA_play(RPIHAL_GPIODMA_instance_t* inst, const RPIHAL_GPIOWAVE_entry_t* wave, size_t count, const RPIHAL_GPIODMA_config_t* config);
+
+//! @param [out] status
+//! @return __0__ on success, __negative__ if no playback has been started
+int RPIHAL_GPIODMA_getStatus(const RPIHAL_GPIODMA_instance_t* inst, RPIHAL_GPIODMA_status_t* status);
+
+/**
+ * @brief Waits until the playback has ended and frees the instance.
+ *
+ * @param [in,out] inst
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIODMA_wait(RPIHAL_GPIODMA_instance_t* inst);
+
+/**
+ * @brief Aborts the DMA transfer and frees the instance.
+ *
+ * @param [in,out] inst
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIODMA_stop(RPIHAL_GPIODMA_instance_t* inst);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IG_RPIHAL_GPIODMA_H
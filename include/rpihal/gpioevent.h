@@ -0,0 +1,189 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef IG_RPIHAL_GPIOEVENT_H
+#define IG_RPIHAL_GPIOEVENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rpihal/gpio.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define RPIHAL_GPIOEVENT_CFG_DEFAULT   (0)      // bias kept as it is (e.g. set by `RPIHAL_GPIO_initPin()`), timestamps from `CLOCK_MONOTONIC`
+#define RPIHAL_GPIOEVENT_CFG_PULL_UP   (0x0001) // Enable the pull up resistor
+#define RPIHAL_GPIOEVENT_CFG_PULL_DOWN (0x0002) // Enable the pull down resistor
+#define RPIHAL_GPIOEVENT_CFG_REALTIME  (0x0004) // Timestamps from `CLOCK_REALTIME`
+#define RPIHAL_GPIOEVENT_CFG_PULL_NONE (0x0008) // Disable the pull up/down resistors
+
+
+#define RPIHAL_GPIOEVENT_INSTANCE_DEV_SIZE (64)
+
+#define RPIHAL_GPIOEVENT_READ_MAX (64) // max number of events returned by one `RPIHAL_GPIOEVENT_read()` call
+
+
+
+typedef struct
+{
+    uint64_t timestamp; // [ns]
+    int pin;            // line offset on the chip, on Raspberry Pis the BCM GPIO pin number
+    int edge;           // `RPIHAL_GPIO_EDGE_RISING` or `RPIHAL_GPIO_EDGE_FALLING`
+    uint32_t seqno;     // sequence number of the event within the instance
+    uint32_t lineSeqno; // sequence number of the event on this pin
+} RPIHAL_GPIOEVENT_event_t;
+
+typedef struct
+{
+    uint64_t events;          // number of events put into the ring
+    uint64_t overflows;       // number of events dropped because the ring was full
+    uint64_t kernelOverflows; // number of events dropped by the kernel (detected by gaps in the sequence number)
+    size_t highWater;         // max number of events in the ring
+    size_t capacity;          // capacity of the ring
+    int error;                // TRUE (`1`) if the reader thread has stopped because of an error
+} RPIHAL_GPIOEVENT_stats_t;
+
+/**
+ * @brief GPIO event instance.
+ *
+ * Do not write to this struct. `fd` may be added to `poll()`/`epoll` sets, it becomes readable if events are pending.
+ */
+typedef struct
+{
+    char dev[RPIHAL_GPIOEVENT_INSTANCE_DEV_SIZE];
+    int fd; // line request fd
+    uint64_t bits;
+    void* reader; // internal, see `RPIHAL_GPIOEVENT_startReader()`
+} RPIHAL_GPIOEVENT_instance_t;
+
+
+
+/**
+ * @brief Requests the pins from the GPIO character device and starts the edge detection.
+ *
+ * Uses the GPIO v2 character device ABI (Linux 5.10 and newer). The kernel timestamps the edges in the interrupt
+ * handler and queues them until they are read, the interrupt is owned by the kernel (unlike with
+ * `RPIHAL_GPIO_setEdgeDetect()`).
+ *
+ * Does not need `RPIHAL_GPIO_init()`, but the pins should not be configured as outputs by `RPIHAL_GPIO_..` functions.
+ *
+ * Off target the module can be used with the `gpio-sim` kernel module, see
+ * [test/system/gpioevent](../../test/system/gpioevent/readme.md).
+ *
+ * `errno` is cleared by this function. If the function fails, `errno` might be non 0, depending on the error.
+ *
+ * @param [out] inst rpihal GPIO event instance
+ * @param dev Path to the GPIO chip (e.g. `/dev/gpiochip0`)
+ * @param bits Bits coresponding to the pins
+ * @param edge One of `RPIHAL_GPIO_EDGE`, `RPIHAL_GPIO_EDGE_ASYNC` is ignored
+ * @param config Configuration, one or more `RPIHAL_GPIOEVENT_CFG_..` combined by bitwise or
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIOEVENT_open(RPIHAL_GPIOEVENT_instance_t* inst, const char* dev, uint64_t bits, int edge, uint32_t config);
+
+/**
+ * @brief Waits until events are pending.
+ *
+ * @param inst
+ * @param timeout_ms Timeout [ms], negative to wait infinitely
+ * @return __1__ if events are pending, __0__ on timeout, __negative__ on failure
+ */
+int RPIHAL_GPIOEVENT_wait(const RPIHAL_GPIOEVENT_instance_t* inst, int timeout_ms);
+
+/**
+ * @brief Reads the pending events by a single `read()` call.
+ *
+ * Blocks if no event is pending, call `RPIHAL_GPIOEVENT_wait()` or poll `inst->fd` before to avoid this. If `O_NONBLOCK`
+ * has been set on `inst->fd`, __0__ is returned instead.
+ *
+ * @param inst
+ * @param [out] events Event buffer
+ * @param count Size of `events`, at most `RPIHAL_GPIOEVENT_READ_MAX` events are read
+ * @return Number of events read, __negative__ on failure
+ */
+int RPIHAL_GPIOEVENT_read(const RPIHAL_GPIOEVENT_instance_t* inst, RPIHAL_GPIOEVENT_event_t* events, size_t count);
+
+/**
+ * @brief Starts a thread which reads the events into a lock-free single-producer/single-consumer ring.
+ *
+ * The application thread then drains the ring by `RPIHAL_GPIOEVENT_drain()` without any syscall. While the reader is
+ * running, `RPIHAL_GPIOEVENT_wait()`, `RPIHAL_GPIOEVENT_read()` and polling `inst->fd` must not be used, wait on the fd
+ * of `RPIHAL_GPIOEVENT_getReaderFd()` instead.
+ *
+ * @param inst
+ * @param capacity Number of events the ring can hold, rounded up to the next power of two, max `SIZE_MAX / 2 / sizeof(RPIHAL_GPIOEVENT_event_t)`
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIOEVENT_startReader(RPIHAL_GPIOEVENT_instance_t* inst, size_t capacity);
+
+//! @return __0__ on success, __negative__ on failure
+int RPIHAL_GPIOEVENT_stopReader(RPIHAL_GPIOEVENT_instance_t* inst);
+
+/**
+ * @brief Moves the events out of the ring, must only be called by one thread at a time.
+ *
+ * @param inst
+ * @param [out] events Event buffer
+ * @param count Size of `events`
+ * @return Number of events moved to `events`
+ */
+size_t RPIHAL_GPIOEVENT_drain(RPIHAL_GPIOEVENT_instance_t* inst, RPIHAL_GPIOEVENT_event_t* events, size_t count);
+
+/**
+ * @brief Returns an `eventfd` which is signaled when the ring of the reader becomes non empty.
+ *
+ * The file descriptor can be used with `poll()`/`epoll`. After it became readable, `read()` 8 bytes to reset it and
+ * then call `RPIHAL_GPIOEVENT_drain()` until it returns __0__, otherwise a wake-up may be lost. So one wake-up handles
+ * all events which arrive meanwhile. It's non blocking and owned by the reader, don't close it.
+ *
+ * @return File descriptor, __negative__ if the reader is not running
+ */
+int RPIHAL_GPIOEVENT_getReaderFd(const RPIHAL_GPIOEVENT_instance_t* inst);
+
+//! @param [out] stats
+//! @return __0__ on success, __negative__ if the reader is not running
+int RPIHAL_GPIOEVENT_getStats(const RPIHAL_GPIOEVENT_instance_t* inst, RPIHAL_GPIOEVENT_stats_t* stats);
+
+/**
+ * @brief Stops the reader if running and releases the pins.
+ *
+ * @param [in,out] inst
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIOEVENT_close(RPIHAL_GPIOEVENT_instance_t* inst);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IG_RPIHAL_GPIOEVENT_H
@@ -0,0 +1,124 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef IG_RPIHAL_GPIOWAVE_H
+#define IG_RPIHAL_GPIOWAVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct
+{
+    uint64_t set;   // pins to be set, wins over `clr`
+    uint64_t clr;   // pins to be cleared
+    uint32_t delay; // [ns] time until the next entry is applied
+} RPIHAL_GPIOWAVE_entry_t;
+
+typedef struct
+{
+    uint32_t loops; // number of times the waveform is played, __0__ to play it until `RPIHAL_GPIOWAVE_stop()` is called
+    uint32_t spin;  // [ns] busy wait time before each entry, the thread sleeps before
+    int cpu;        // CPU to pin the playback thread to, negative to not pin it
+    int priority;   // `SCHED_FIFO` priority of the playback thread, __0__ to keep `SCHED_OTHER`
+} RPIHAL_GPIOWAVE_config_t;
+
+//! Timing error of the entries, the difference between the scheduled and the actual time right before the registers are
+//! written. The register write itself is not included.
+typedef struct
+{
+    uint64_t entries;  // number of entries played
+    uint64_t late;     // number of entries with an error above 10us
+    uint64_t maxError; // [ns]
+    double meanError;  // [ns]
+    double stdDev;     // [ns]
+    int running;
+} RPIHAL_GPIOWAVE_stats_t;
+
+/**
+ * @brief Waveform playback instance.
+ *
+ * Do not write to this struct.
+ */
+typedef struct
+{
+    void* wave; // internal
+} RPIHAL_GPIOWAVE_instance_t;
+
+
+
+void RPIHAL_GPIOWAVE_defaultConfig(RPIHAL_GPIOWAVE_config_t* config);
+
+/**
+ * @brief Starts a thread which plays the waveform.
+ *
+ * The entries are applied by `RPIHAL_GPIO_write64()` on an absolute schedule (`CLOCK_MONOTONIC`), so the error of
+ * one entry doesn't accumulate. The GPIO module has to be initialised and the pins configured as outputs.
+ *
+ * `wave` is not copied, it has to stay valid until the playback has ended. For low jitter pin the thread to an
+ * isolated CPU (`isolcpus`), give it a realtime priority and lock the memory of the process (`mlockall()`).
+ *
+ * @param [out] inst
+ * @param wave Waveform entries
+ * @param count Number of entries in `wave`
+ * @param config
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIOWAVE_play(RPIHAL_GPIOWAVE_instance_t* inst, const RPIHAL_GPIOWAVE_entry_t* wave, size_t count, const RPIHAL_GPIOWAVE_config_t* config);
+
+//! @param [out] stats
+//! @return __0__ on success, __negative__ if no playback has been started
+int RPIHAL_GPIOWAVE_getStats(const RPIHAL_GPIOWAVE_instance_t* inst, RPIHAL_GPIOWAVE_stats_t* stats);
+
+/**
+ * @brief Waits until the playback has ended and frees the instance.
+ *
+ * @param [in,out] inst
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIOWAVE_wait(RPIHAL_GPIOWAVE_instance_t* inst);
+
+/**
+ * @brief Stops the playback after the current entry and frees the instance.
+ *
+ * @param [in,out] inst
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_GPIOWAVE_stop(RPIHAL_GPIOWAVE_instance_t* inst);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IG_RPIHAL_GPIOWAVE_H
@@ -0,0 +1,179 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef IG_RPIHAL_PWM_H
+#define IG_RPIHAL_PWM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rpihal/rpihal.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Hardware PWM (BCM PWM0 block and its clock manager). The pins are muxed by the GPIO module:
+//
+// | channel | GPIO 12 | GPIO 13 | GPIO 18 | GPIO 19 | GPIO 40 | GPIO 41 | GPIO 45 |
+// |:-------:|:-------:|:-------:|:-------:|:-------:|:-------:|:-------:|:-------:|
+// | 0       | AF0     |         | AF5     |         | AF0     |         |         |
+// | 1       |         | AF0     |         | AF5     |         | AF0     | AF0     |
+
+
+#define RPIHAL_PWM_FIFO_SIZE (8) // [words]
+
+enum RPIHAL_PWM_MODE
+{
+    RPIHAL_PWM_MODE_PWM = 0, // pulses distributed over the range (N/M algorithm)
+    RPIHAL_PWM_MODE_MS,      // mark-space, high for data clocks then low for the rest of the range
+    RPIHAL_PWM_MODE_SERIAL,  // serialiser, shifts out the data MSB first, range is the number of bits (max 32)
+};
+
+typedef struct
+{
+    int mode;       // one of `RPIHAL_PWM_MODE`
+    uint32_t range; // period [PWM clock cycles], number of bits in serialiser mode
+    int useFifo;    // boolean, take the data from the FIFO instead of the data register
+    int repeat;     // boolean, repeat the last FIFO word while the FIFO is empty
+    int silence;    // output level while not transmitting
+    int invert;     // boolean, invert the output polarity
+} RPIHAL_PWM_chConfig_t;
+
+typedef struct
+{
+    int fifoFull;
+    int fifoEmpty;
+    int writeError; // the FIFO was written while full
+    int readError;  // the FIFO was read while empty
+    int gap[2];     // a channel ran out of FIFO data (gap in the output), per channel
+    int busError;
+    int running[2]; // per channel
+} RPIHAL_PWM_status_t;
+
+
+//! @return __0__ on success, __negative__ on error
+//!
+//! Same as `RPIHAL_PWM_initBackend(RPIHAL_GPIO_BACKEND_MMAP, RPIHAL_model_unknown)`.
+//!
+int RPIHAL_PWM_init();
+
+/**
+ * @brief Maps the PWM and the clock manager registers.
+ *
+ * The mmap backend maps `/dev/mem` (root access needed). The anon backend emulates both register blocks in memory, the
+ * FIFO is then never full and the clock never busy.
+ *
+ * @param id One of `RPIHAL_GPIO_BACKEND_MMAP` or `RPIHAL_GPIO_BACKEND_ANON`
+ * @param model The model to initialise for, `RPIHAL_model_unknown` to detect the model
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_PWM_initBackend(int id, RPIHAL_model_t model);
+
+/**
+ * @brief Sets the PWM clock, sourced from the oscillator (19.2MHz on BCM283x, 54MHz on BCM2711).
+ *
+ * The channels are disabled while the clock is switched and enabled again afterwards.
+ *
+ * @param frequency Requested frequency [Hz]
+ * @param [out] actual The frequency set by the integer divider [Hz], may be `NULL`
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_PWM_setClock(uint32_t frequency, uint32_t* actual);
+
+void RPIHAL_PWM_defaultChConfig(RPIHAL_PWM_chConfig_t* config);
+
+/**
+ * @brief Configures a channel, the channel is disabled afterwards.
+ *
+ * @param ch Channel __0__ or __1__
+ * @param config
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_PWM_configChannel(int ch, const RPIHAL_PWM_chConfig_t* config);
+
+//! @param ch Channel __0__ or __1__
+//! @param enable Boolean
+//! @return __0__ on success, __negative__ on error
+int RPIHAL_PWM_enable(int ch, int enable);
+
+//! @brief Writes the data register, the duty cycle in PWM modes. Not used if the channel takes its data from the FIFO.
+//! @param ch Channel __0__ or __1__
+//! @return __0__ on success, __negative__ on error
+int RPIHAL_PWM_setData(int ch, uint32_t data);
+
+/**
+ * @brief Writes as many words to the FIFO as fit, without blocking.
+ *
+ * The FIFO is shared by the channels, if both use it the words are taken alternately.
+ *
+ * @return Number of words written, __negative__ on error
+ */
+int RPIHAL_PWM_writeFifo(const uint32_t* data, size_t count);
+
+/**
+ * @brief Writes the whole buffer to the FIFO.
+ *
+ * While the FIFO is full, the calling thread sleeps for about half of the time the hardware needs to drain it, so it
+ * wakes up about every 4 words instead of once per period.
+ *
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_PWM_streamFifo(const uint32_t* data, size_t count);
+
+//! @return __0__ on success, __negative__ on error
+int RPIHAL_PWM_clearFifo();
+
+/**
+ * @brief Enables the DMA request of the FIFO.
+ *
+ * DREQ is asserted while less than 7 words are in the FIFO, so a DMA channel paced by it (PERMAP 5) writes one word
+ * each time the PWM takes one.
+ *
+ * @param enable Boolean
+ * @return __0__ on success, __negative__ on error
+ */
+int RPIHAL_PWM_setDma(int enable);
+
+//! @brief Reads the status and clears the error flags.
+//! @param [out] status
+//! @return __0__ on success, __negative__ on error
+int RPIHAL_PWM_getStatus(RPIHAL_PWM_status_t* status);
+
+//! @brief Disables both channels, stops the clock and unmaps the registers.
+//! @return __0__ on success, __negative__ on error
+int RPIHAL_PWM_deinit();
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IG_RPIHAL_PWM_H
@@ -138,9 +138,10 @@ static inline int RPIHAL_model_header_is_40pin(RPIHAL_model_t model)
 {
     return (
         // ADDHW
-        // (model ==RPIHAL_model_1Ap) || (model ==RPIHAL_model_1Bp) || (model ==RPIHAL_model_z) || (model ==RPIHAL_model_zW) || (model == RPIHAL_model_5) ||
+        // (model ==RPIHAL_model_1Ap) || (model ==RPIHAL_model_1Bp) || (model ==RPIHAL_model_z) || (model ==RPIHAL_model_zW) ||
         (model == RPIHAL_model_2B) || (model == RPIHAL_model_2B_v1_2) || (model == RPIHAL_model_3B) || (model == RPIHAL_model_z2W) ||
-        (model == RPIHAL_model_3Ap) || (model == RPIHAL_model_3Bp) || (model == RPIHAL_model_4B) || (model == RPIHAL_model_400));
+        (model == RPIHAL_model_3Ap) || (model == RPIHAL_model_3Bp) || (model == RPIHAL_model_4B) || (model == RPIHAL_model_400) ||
+        (model == RPIHAL_model_5) || (model == RPIHAL_model_500));
 }
 
 
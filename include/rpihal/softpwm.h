@@ -0,0 +1,130 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef IG_RPIHAL_SOFTPWM_H
+#define IG_RPIHAL_SOFTPWM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define RPIHAL_SOFTPWM_DUTY_MAX (10000) // 100.00%
+
+
+
+typedef struct
+{
+    uint64_t bits;       // pins to drive
+    uint32_t frequency;  // PWM frequency [Hz], common to all channels
+    uint32_t resolution; // [ns] edge times are rounded to multiples of it, so that close edges are merged into one write
+    uint32_t spin;       // [ns] busy wait time before each edge, the thread sleeps before
+    int cpu;             // CPU to pin the timing thread to, negative to not pin it
+    int priority;        // `SCHED_FIFO` priority of the timing thread, __0__ to keep `SCHED_OTHER`
+} RPIHAL_SOFTPWM_config_t;
+
+//! Timing error of the register writes, see `RPIHAL_GPIOWAVE_stats_t`.
+typedef struct
+{
+    uint64_t periods;  // number of periods played
+    uint64_t writes;   // number of register writes (period starts and merged edges)
+    uint64_t late;     // number of writes with an error above 10us
+    uint64_t skipped;  // number of periods skipped because the thread was too late
+    uint64_t maxError; // [ns]
+    double meanError;  // [ns]
+    int running;
+} RPIHAL_SOFTPWM_stats_t;
+
+/**
+ * @brief Software PWM instance.
+ *
+ * Do not write to this struct.
+ */
+typedef struct
+{
+    void* pwm; // internal
+} RPIHAL_SOFTPWM_instance_t;
+
+
+
+void RPIHAL_SOFTPWM_defaultConfig(RPIHAL_SOFTPWM_config_t* config);
+
+/**
+ * @brief Starts the timing thread which drives all channels.
+ *
+ * Each period begins with one write setting all channels with a non zero duty cycle. The falling edges of all channels
+ * are merged into a sorted schedule, channels with the same (rounded) edge time are cleared by one write. The writes go
+ * through `RPIHAL_GPIO_write64()`, the GPIO module has to be initialised and the pins configured as outputs.
+ *
+ * All channels start with a duty cycle of 0.
+ *
+ * @param [out] inst
+ * @param config
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_SOFTPWM_start(RPIHAL_SOFTPWM_instance_t* inst, const RPIHAL_SOFTPWM_config_t* config);
+
+/**
+ * @brief Sets the duty cycle of one or more channels.
+ *
+ * The new schedule is built by the calling thread and handed over lock-free, the timing thread applies it at the next
+ * period boundary. Can be called from multiple threads.
+ *
+ * @param inst
+ * @param bits Bits coresponding to the channels (pins)
+ * @param duty Duty cycle, `0..RPIHAL_SOFTPWM_DUTY_MAX`
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_SOFTPWM_setDuty(RPIHAL_SOFTPWM_instance_t* inst, uint64_t bits, uint32_t duty);
+
+//! Sets the PWM frequency, applied like `RPIHAL_SOFTPWM_setDuty()`.
+//! @return __0__ on success, __negative__ on failure
+int RPIHAL_SOFTPWM_setFrequency(RPIHAL_SOFTPWM_instance_t* inst, uint32_t frequency);
+
+//! @param [out] stats
+//! @return __0__ on success, __negative__ if not started
+int RPIHAL_SOFTPWM_getStats(const RPIHAL_SOFTPWM_instance_t* inst, RPIHAL_SOFTPWM_stats_t* stats);
+
+/**
+ * @brief Stops the timing thread, clears all channels and frees the instance.
+ *
+ * @param [in,out] inst
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_SOFTPWM_stop(RPIHAL_SOFTPWM_instance_t* inst);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IG_RPIHAL_SOFTPWM_H
@@ -55,6 +55,19 @@ extern "C" {
 
 #define RPIHAL_SPI_INSTANCE_DEV_SIZE (300)
 
+#define RPIHAL_SPI_SEGMENTS_MAX (32) // max number of segments of a transaction
+
+#define RPIHAL_SPI_BUFSIZ_DEFAULT (4096) // default of the spidev module parameter `bufsiz`
+
+#define RPIHAL_SPI_POOL_BUFFERS_MAX (64)
+
+
+enum RPIHAL_SPI_BACKEND
+{
+    RPIHAL_SPI_BACKEND_SPIDEV = 0, // Linux spidev driver
+    RPIHAL_SPI_BACKEND_LOOPBACK,   // no device is opened, MISO is connected to MOSI (received data = transmitted data)
+};
+
 
 
 #ifdef RPIHAL_EMU
@@ -72,11 +85,43 @@ typedef struct
     int fd;
     uint32_t speed;
     uint8_t bits;
+    uint32_t mode; // spidev mode flags, applied to the device before a transfer if another instance changed them
+    int backend;
+    int device;    // internal, index of the device table
+    size_t bufsiz; // max number of bytes per message (spidev module parameter)
 #ifdef RPIHAL_EMU
     RPIHAL_EMU_spi_transfer_cb_t transfer_cb;
 #endif
 } RPIHAL_SPI_instance_t;
 
+/**
+ * @brief Segment of a transaction, see `RPIHAL_SPI_transaction()`.
+ */
+typedef struct
+{
+    const uint8_t* txData; // `NULL` to transmit zeros
+    uint8_t* rxBuffer;     // `NULL` to discard the received data
+    size_t count;          // number of bytes
+    uint32_t speed;        // clock speed [Hz], __0__ for the speed of the instance
+    uint16_t delay;        // delay after the segment [us], before chip select is changed or the next segment starts
+    uint8_t bits;          // bits per word, __0__ for the bits of the instance
+    uint8_t csChange;      // boolean, deassert chip select after this segment (after the last segment: leave asserted)
+} RPIHAL_SPI_segment_t;
+
+/**
+ * @brief Pool of page aligned buffers of the size of a message, see `RPIHAL_SPI_poolCreate()`.
+ *
+ * Do not write to this struct.
+ */
+typedef struct
+{
+    uint8_t* memory;
+    size_t bufferSize; // usable size of each buffer
+    size_t stride;     // distance between the buffers, multiple of the page size
+    size_t count;
+    uint64_t free; // bit mask of the free buffers
+} RPIHAL_SPI_pool_t;
+
 
 
 /**
@@ -84,7 +129,8 @@ typedef struct
  *
  * `errno` is cleared by this function. If the function fails, `errno` might be non 0, depending on the error.
  *
- * If multiple instances are used on the same device, read
+ * Multiple instances can be opened on the same device with different configurations. The mode is a setting of the
+ * device, it's re-applied (one ioctl) when an instance transfers after an instance with a different mode. See
  * [ANOM2](https://github.com/oblaser/rpihal/blob/main/anomalies.md#anom2---multiple-spi-instances-on-the-same-device).
  *
  * The clock speed is a maximum value, the driver selects the highest possible clock but not higher than `maxSpeed` (see
@@ -100,9 +146,21 @@ typedef struct
  */
 int RPIHAL_SPI_open(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSpeed, uint32_t config);
 
+/**
+ * @brief Same as `RPIHAL_SPI_open()` with the specified backend.
+ *
+ * `RPIHAL_SPI_open()` is the same as `RPIHAL_SPI_openBackend(..., RPIHAL_SPI_BACKEND_SPIDEV)`. The loopback backend
+ * doesn't open `dev`, it allows to run the SPI code on any Linux machine.
+ *
+ * @param backend One of `RPIHAL_SPI_BACKEND`
+ */
+int RPIHAL_SPI_openBackend(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSpeed, uint32_t config, int backend);
+
 /**
  * @brief
  *
+ * Transfers larger than `inst->bufsiz` are split into multiple messages, chip select is deasserted in between.
+ *
  * `errno` is cleared by this function. If the function fails, `errno` might be non 0, depending on the error.
  *
  * On the emulator this function returns the return value of the `inst->transfer_cb` call.
@@ -115,6 +173,26 @@ int RPIHAL_SPI_open(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSp
  */
 int RPIHAL_SPI_transfer(const RPIHAL_SPI_instance_t* inst, const uint8_t* txData, uint8_t* rxBuffer, size_t count);
 
+/**
+ * @brief Transfers the segments in one message (one `SPI_IOC_MESSAGE(n)` ioctl).
+ *
+ * Chip select stays asserted across the segments, unless `csChange` of a segment is set. E.g. a flash read is one
+ * transaction of a command/address segment and a payload segment.
+ *
+ * The spidev driver limits the sum of the segments to `inst->bufsiz`, larger transactions fail without an ioctl.
+ *
+ * `errno` is cleared by this function. If the function fails, `errno` might be non 0, depending on the error.
+ *
+ * On the emulator `inst->transfer_cb` is called for each segment, the transaction is aborted on the first callback
+ * returning non 0.
+ *
+ * @param inst
+ * @param segments
+ * @param count Number of segments, max `RPIHAL_SPI_SEGMENTS_MAX`
+ * @return __0__ on success, negative on failure
+ */
+int RPIHAL_SPI_transaction(const RPIHAL_SPI_instance_t* inst, const RPIHAL_SPI_segment_t* segments, size_t count);
+
 /**
  * @brief
  *
@@ -127,6 +205,33 @@ int RPIHAL_SPI_transfer(const RPIHAL_SPI_instance_t* inst, const uint8_t* txData
  */
 int RPIHAL_SPI_close(RPIHAL_SPI_instance_t* inst);
 
+//! @return Number of times the mode of the device of the instance had to be re-applied because it was changed by another
+//! instance (`SPI_IOC_WR_MODE32` ioctls, excluding the ones of `RPIHAL_SPI_open()`)
+uint64_t RPIHAL_SPI_getModeSwitches(const RPIHAL_SPI_instance_t* inst);
+
+/**
+ * @brief Allocates a pool of reusable transfer buffers.
+ *
+ * The buffers are `inst->bufsiz` bytes, page aligned and faulted in. Getting and putting a buffer is lock-free and
+ * can be done from any thread. The spidev driver copies the data into its own buffer anyway, but a transfer from a pool
+ * buffer needs no allocation and never has to be split.
+ *
+ * @param [out] pool
+ * @param inst Opened instance, only used to get the buffer size
+ * @param count Number of buffers, max `RPIHAL_SPI_POOL_BUFFERS_MAX`
+ * @return __0__ on success, negative on failure
+ */
+int RPIHAL_SPI_poolCreate(RPIHAL_SPI_pool_t* pool, const RPIHAL_SPI_instance_t* inst, size_t count);
+
+//! @return A free buffer of `pool->bufferSize` bytes, `NULL` if all buffers are in use
+uint8_t* RPIHAL_SPI_poolGet(RPIHAL_SPI_pool_t* pool);
+
+//! @param buffer Buffer returned by `RPIHAL_SPI_poolGet()`
+void RPIHAL_SPI_poolPut(RPIHAL_SPI_pool_t* pool, uint8_t* buffer);
+
+//! Frees the memory of the pool, the buffers must not be used anymore.
+void RPIHAL_SPI_poolDestroy(RPIHAL_SPI_pool_t* pool);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,144 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef IG_RPIHAL_SPIADC_H
+#define IG_RPIHAL_SPIADC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rpihal/spi.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define RPIHAL_SPIADC_CHANNELS_MAX (8)
+
+enum RPIHAL_SPIADC_DEVICE
+{
+    RPIHAL_SPIADC_DEVICE_MCP3208 = 0, // MCP3204, MCP3208 (12bit)
+    RPIHAL_SPIADC_DEVICE_MCP3008,     // MCP3004, MCP3008 (10bit)
+};
+
+//! Result of one scan over the channel list. Fixed size, an array of scans can be written to a file as is.
+typedef struct
+{
+    uint64_t timestamp;                         // [ns] since the start of the sampling, see `RPIHAL_SPIADC_start()`
+    uint16_t value[RPIHAL_SPIADC_CHANNELS_MAX]; // raw conversion results in the order of `config.channels`
+} RPIHAL_SPIADC_scan_t;
+
+typedef struct
+{
+    const RPIHAL_SPI_instance_t* spi; // opened SPI instance, must not be used by other threads while sampling
+    int device;                       // one of `RPIHAL_SPIADC_DEVICE`
+    uint8_t channels[RPIHAL_SPIADC_CHANNELS_MAX]; // single ended input channels to convert per scan
+    size_t nChannels;
+    size_t scansPerMessage; // number of scans submitted per ioctl, `nChannels * scansPerMessage` must not exceed `RPIHAL_SPI_SEGMENTS_MAX`
+    uint32_t rate;          // scan rate [Hz], __0__ to scan as fast as possible, max `scansPerMessage` GHz
+    uint64_t nScans;        // number of scans to take, __0__ to scan until `RPIHAL_SPIADC_stop()` is called
+    size_t capacity;        // number of scans the buffer can hold, rounded up to the next power of two
+    int cpu;                // CPU to pin the sampling thread to, negative to not pin it
+    int priority;           // `SCHED_FIFO` priority of the sampling thread, __0__ to keep `SCHED_OTHER`
+} RPIHAL_SPIADC_config_t;
+
+typedef struct
+{
+    uint64_t scans;       // number of scans taken
+    uint64_t messages;    // number of SPI messages (ioctls)
+    uint64_t overflows;   // number of scans dropped because the buffer was full
+    uint64_t late;        // number of message slots missed because the thread was too late
+    uint64_t maxLateness; // [ns]
+    int error;            // the sampling stopped because a transfer failed
+    int running;
+} RPIHAL_SPIADC_stats_t;
+
+/**
+ * @brief SPI ADC sampling instance.
+ *
+ * Do not write to this struct.
+ */
+typedef struct
+{
+    RPIHAL_SPIADC_config_t config;
+    void* sampler; // internal
+} RPIHAL_SPIADC_instance_t;
+
+
+
+void RPIHAL_SPIADC_defaultConfig(RPIHAL_SPIADC_config_t* config);
+
+/**
+ * @brief Starts a thread which scans the channel list of the ADC at a fixed rate.
+ *
+ * The command frames are computed once at start. Each conversion is a segment with chip select change, `scansPerMessage`
+ * scans are submitted as one SPI transaction (one syscall instead of one per channel). The scans are put into a
+ * lock-free ring which is drained by `RPIHAL_SPIADC_read()`.
+ *
+ * The timestamps of the scans of a message are interpolated between the start and the end of the message. The rate
+ * applies to the scans, the thread wakes up once per message. For high rates pin the thread to an isolated CPU
+ * (`isolcpus`) and give it a realtime priority.
+ *
+ * @param [out] inst
+ * @param config
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_SPIADC_start(RPIHAL_SPIADC_instance_t* inst, const RPIHAL_SPIADC_config_t* config);
+
+/**
+ * @brief Moves the scans out of the buffer, must only be called by one thread at a time.
+ *
+ * @param inst
+ * @param [out] scans
+ * @param count Size of `scans`
+ * @return Number of scans moved to `scans`
+ */
+size_t RPIHAL_SPIADC_read(RPIHAL_SPIADC_instance_t* inst, RPIHAL_SPIADC_scan_t* scans, size_t count);
+
+//! @param [out] stats
+//! @return __0__ on success, __negative__ if no sampling has been started
+int RPIHAL_SPIADC_getStats(const RPIHAL_SPIADC_instance_t* inst, RPIHAL_SPIADC_stats_t* stats);
+
+/**
+ * @brief Stops the sampling thread and frees the buffer, the scans not yet read are lost.
+ *
+ * The SPI instance is not closed.
+ *
+ * @param [in,out] inst
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_SPIADC_stop(RPIHAL_SPIADC_instance_t* inst);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IG_RPIHAL_SPIADC_H
@@ -0,0 +1,158 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef IG_RPIHAL_SPIQUEUE_H
+#define IG_RPIHAL_SPIQUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rpihal/spi.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct RPIHAL_SPIQUEUE_request RPIHAL_SPIQUEUE_request_t;
+
+/**
+ * @brief Completion callback, called from the worker thread.
+ *
+ * Must not call `RPIHAL_SPIQUEUE_flush()` or `RPIHAL_SPIQUEUE_destroy()`, they fail if called from the worker thread.
+ *
+ * @param request Copy of the submitted request, only valid during the call
+ * @param result __0__ on success, __negative__ if the transfer failed
+ */
+typedef void (*RPIHAL_SPIQUEUE_callback_t)(const RPIHAL_SPIQUEUE_request_t* request, int result);
+
+//! The buffers have to stay valid until the request is completed.
+struct RPIHAL_SPIQUEUE_request
+{
+    const RPIHAL_SPI_instance_t* spi; // opened instance on the bus of the queue
+
+    // transfer, used if `segments` is `NULL`
+    const uint8_t* txData;
+    uint8_t* rxBuffer;
+    size_t count;
+
+    // transaction
+    const RPIHAL_SPI_segment_t* segments;
+    size_t nSegments;
+
+    RPIHAL_SPIQUEUE_callback_t callback; // may be `NULL`
+    void* user;                          // not used by rpihal
+};
+
+typedef struct
+{
+    size_t capacity; // max number of pending requests
+    int cpu;         // CPU to pin the worker thread to, negative to not pin it
+    int priority;    // `SCHED_FIFO` priority of the worker thread, __0__ to keep `SCHED_OTHER`
+} RPIHAL_SPIQUEUE_config_t;
+
+typedef struct
+{
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t errors;   // number of completed requests which failed
+    uint64_t rejected; // number of requests not submitted because the queue was full
+    size_t highWater;  // max number of pending requests
+} RPIHAL_SPIQUEUE_stats_t;
+
+/**
+ * @brief SPI request queue instance.
+ *
+ * Do not write to this struct.
+ */
+typedef struct
+{
+    void* queue; // internal
+} RPIHAL_SPIQUEUE_instance_t;
+
+
+
+void RPIHAL_SPIQUEUE_defaultConfig(RPIHAL_SPIQUEUE_config_t* config);
+
+/**
+ * @brief Starts the worker thread of a bus.
+ *
+ * Create one queue per bus (e.g. `/dev/spidev0.x`) and submit the requests of all instances on that bus to it. The
+ * worker executes them one after the other in the order of submission, so the transfers of the instances don't
+ * interleave.
+ *
+ * @param [out] inst
+ * @param config
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_SPIQUEUE_create(RPIHAL_SPIQUEUE_instance_t* inst, const RPIHAL_SPIQUEUE_config_t* config);
+
+/**
+ * @brief Puts a copy of the request into the queue, doesn't block.
+ *
+ * Can be called from any thread, also from a completion callback.
+ *
+ * @return __0__ on success, __negative__ if the queue is full or stopped
+ */
+int RPIHAL_SPIQUEUE_submit(RPIHAL_SPIQUEUE_instance_t* inst, const RPIHAL_SPIQUEUE_request_t* request);
+
+/**
+ * @brief Returns an `eventfd` which is incremented by every completed request.
+ *
+ * The file descriptor can be used with `poll()`/`epoll`, a `read()` of 8 bytes returns the number of completions since
+ * the last read. It's non blocking and owned by the queue, don't close it.
+ *
+ * @return File descriptor, __negative__ if no queue has been created
+ */
+int RPIHAL_SPIQUEUE_getFd(const RPIHAL_SPIQUEUE_instance_t* inst);
+
+//! Blocks until all submitted requests are completed.
+//! @return __0__ on success, __negative__ if no queue has been created or if called from a completion callback
+int RPIHAL_SPIQUEUE_flush(RPIHAL_SPIQUEUE_instance_t* inst);
+
+//! @param [out] stats
+//! @return __0__ on success, __negative__ if no queue has been created
+int RPIHAL_SPIQUEUE_getStats(const RPIHAL_SPIQUEUE_instance_t* inst, RPIHAL_SPIQUEUE_stats_t* stats);
+
+/**
+ * @brief Completes the pending requests and stops the worker thread.
+ *
+ * The SPI instances are not closed. Fails if called from a completion callback.
+ *
+ * @param [in,out] inst
+ * @return __0__ on success, __negative__ on failure
+ */
+int RPIHAL_SPIQUEUE_destroy(RPIHAL_SPIQUEUE_instance_t* inst);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IG_RPIHAL_SPIQUEUE_H
@@ -0,0 +1,228 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal/platform_check.h"
+#include "internal/util.h"
+#include "rpihal/bitbang.h"
+#include "rpihal/gpio.h"
+
+#include <time.h>
+
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INF
+#define LOG_MODULE_NAME  BITBANG
+#include "internal/log.h"
+
+
+
+static int checkPin(int pin);
+static int reserve(RPIHAL_BITBANG_program_t* program, size_t count);
+static inline void push(RPIHAL_BITBANG_program_t* program, uint32_t set, uint32_t clr, uint32_t delay);
+
+
+
+void RPIHAL_BITBANG_defaultBus(RPIHAL_BITBANG_bus_t* bus)
+{
+    bus->clk = -1;
+    for (int i = 0; i < RPIHAL_BITBANG_WIDTH_MAX; ++i) { bus->data[i] = -1; }
+    bus->width = 1;
+    bus->latch = -1;
+    bus->msbFirst = 1;
+    bus->clkIdle = 0;
+    bus->setup = 0;
+    bus->hold = 0;
+    bus->latchPulse = 0;
+}
+
+int RPIHAL_BITBANG_compile(RPIHAL_BITBANG_program_t* program, const RPIHAL_BITBANG_bus_t* bus, const void* data, size_t count)
+{
+    program->count = 0;
+
+    if ((bus->width < 1) || (bus->width > RPIHAL_BITBANG_WIDTH_MAX))
+    {
+        LOG_ERR("invalid width %i", bus->width);
+        return -(__LINE__);
+    }
+
+    if (!checkPin(bus->clk)) { return -(__LINE__); }
+    if ((bus->latch >= 0) && !checkPin(bus->latch)) { return -(__LINE__); }
+
+    const uint32_t clk = (1u << bus->clk);
+    const uint32_t latch = (bus->latch >= 0 ? (1u << bus->latch) : 0);
+
+    uint32_t dataBit[RPIHAL_BITBANG_WIDTH_MAX];
+    uint32_t dataPins = 0;
+
+    for (int i = 0; i < bus->width; ++i)
+    {
+        if (!checkPin(bus->data[i])) { return -(__LINE__); }
+
+        dataBit[i] = (1u << bus->data[i]);
+        dataPins |= dataBit[i];
+    }
+
+    program->pins = clk | latch | dataPins;
+
+    const int clocksPerWord = (bus->width == 1 ? 8 : 1);
+    if (reserve(program, (count * clocksPerWord * 2) + 2) != 0) { return -(__LINE__); }
+
+    // clock to idle and active edge
+    const uint32_t idleSet = (bus->clkIdle ? clk : 0);
+    const uint32_t idleClr = (bus->clkIdle ? 0 : clk);
+
+    uint32_t level = 0;
+    uint32_t known = 0; // the data pins are written completely on the first clock
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint32_t word = (bus->width <= 8 ? ((const uint8_t*)data)[i] : ((const uint16_t*)data)[i]);
+
+        for (int c = 0; c < clocksPerWord; ++c)
+        {
+            uint32_t value = 0;
+
+            if (bus->width == 1)
+            {
+                const int shift = (bus->msbFirst ? (7 - c) : c);
+                if ((word >> shift) & 0x01) { value = dataBit[0]; }
+            }
+            else
+            {
+                for (int k = 0; k < bus->width; ++k)
+                {
+                    if ((word >> k) & 0x01) { value |= dataBit[k]; }
+                }
+            }
+
+            const uint32_t changed = (value ^ level) | (dataPins & ~known);
+
+            push(program, (value & changed) | idleSet, (~value & changed & dataPins) | idleClr, bus->setup);
+            push(program, idleClr, idleSet, bus->hold);
+
+            level = value;
+            known = dataPins;
+        }
+    }
+
+    // back to idle, then the latch pulse
+    push(program, idleSet | latch, idleClr, (latch ? bus->latchPulse : 0));
+    if (latch) { push(program, 0, latch, 0); }
+
+    return 0;
+}
+
+int RPIHAL_BITBANG_run(const RPIHAL_BITBANG_program_t* program)
+{
+    RPIHAL_GPIO_pin_t handle;
+
+    if (program->count == 0) { return 0; }
+
+    // all pins are in bank 0, the handle of any of them has the bank's set and clear registers (RIO aliases on RP1)
+    if (RPIHAL_GPIO_getPinHandle(&handle, RPIHAL_GPIO_bittopin(program->pins)) != 0) { return -(__LINE__); }
+
+    RPIHAL_regptr_t set = handle.set;
+    RPIHAL_regptr_t clr = handle.clr;
+
+    const RPIHAL_BITBANG_step_t* step = program->steps;
+    const RPIHAL_BITBANG_step_t* const end = program->steps + program->count;
+
+    for (; step < end; ++step)
+    {
+        if (step->set) { *set = step->set; }
+        if (step->clr) { *clr = step->clr; }
+
+        if (step->delay)
+        {
+            const uint64_t deadline = UTIL_time_ns(CLOCK_MONOTONIC) + step->delay;
+            while (UTIL_time_ns(CLOCK_MONOTONIC) < deadline) {}
+        }
+    }
+
+    return 0;
+}
+
+void RPIHAL_BITBANG_free(RPIHAL_BITBANG_program_t* program)
+{
+    free(program->steps);
+
+    program->steps = NULL;
+    program->count = 0;
+    program->capacity = 0;
+}
+
+
+
+int checkPin(int pin)
+{
+    RPIHAL_GPIO_pin_t handle;
+
+    // validated by the GPIO module
+    if (RPIHAL_GPIO_getPinHandle(&handle, pin) != 0) { return 0; }
+
+    if (pin >= 32)
+    {
+        LOG_ERR("pin %i is not in bank 0", pin);
+        return 0;
+    }
+
+    return 1;
+}
+
+int reserve(RPIHAL_BITBANG_program_t* program, size_t count)
+{
+    if (count <= program->capacity) { return 0; }
+
+    RPIHAL_BITBANG_step_t* tmp = (RPIHAL_BITBANG_step_t*)realloc(program->steps, count * sizeof(RPIHAL_BITBANG_step_t));
+
+    if (!tmp)
+    {
+        LOG_ERR("failed to allocate %zu steps", count);
+        return -(__LINE__);
+    }
+
+    program->steps = tmp;
+    program->capacity = count;
+
+    return 0;
+}
+
+void push(RPIHAL_BITBANG_program_t* program, uint32_t set, uint32_t clr, uint32_t delay)
+{
+    RPIHAL_BITBANG_step_t* step = program->steps + program->count;
+
+    step->set = set;
+    step->clr = clr;
+    step->delay = delay;
+
+    ++(program->count);
+}
@@ -120,7 +120,10 @@ public:
     {
         m_config.mode = RPIHAL_GPIO_MODE_IN;
         m_config.pull = RPIHAL_GPIO_PULL_NONE;
+        m_config.drive = RPIHAL_GPIO_DRIVE_KEEP;
         m_config.altfunc = RPIHAL_GPIO_AF_0;
+        m_config.slew = RPIHAL_GPIO_SLEW_FAST;
+        m_config.hysteresis = 1;
     }
 
     Gpio(const RPIHAL_GPIO_init_t& config, bool state = false)
@@ -646,18 +649,29 @@ bool EmuPge::OnUserDestroy() { return true; }
 //######################################################################################################################
 // clang-format on
 
+#include "../../include/rpihal/bitbang.h"
 #include "../../include/rpihal/defs.h"
 #include "../../include/rpihal/emu/emu.h"
 #include "../../include/rpihal/gpio.h"
+#include "../../include/rpihal/gpiocapture.h"
+#include "../../include/rpihal/gpiodma.h"
+#include "../../include/rpihal/gpioevent.h"
+#include "../../include/rpihal/gpiowave.h"
 #include "../../include/rpihal/i2c.h"
+#include "../../include/rpihal/pwm.h"
 #include "../../include/rpihal/rpihal.h"
+#include "../../include/rpihal/softpwm.h"
 #include "../../include/rpihal/spi.h"
+#include "../../include/rpihal/spiadc.h"
+#include "../../include/rpihal/spiqueue.h"
 #include "../../include/rpihal/sys.h"
 #include "../../include/rpihal/uart.h"
 #include "../internal/gpio.h"
+#include "../internal/spi.h"
 
 
 static RPIHAL_model_t rpihal_emu_model = RPIHAL_model_unknown;
+static iGPIO_platform_t rpihal_emu_platform;
 
 
 static void emuMain()
@@ -682,6 +696,7 @@ int RPIHAL_EMU_init(RPIHAL_model_t model)
     int r = -1;
 
     rpihal_emu_model = model;
+    iGPIO_initPlatform(&rpihal_emu_platform, model, 1);
     thread_pge_sd.setModelStr(RPIHAL_dt_model());
 
     try
@@ -703,8 +718,8 @@ int RPIHAL_EMU_init(RPIHAL_model_t model)
 
 void RPIHAL_EMU_setInitialGpioState(uint64_t mask)
 {
-    // const uint64_t pinsMask = iGPIO_getBcmPinsMask();
-    const uint64_t pinsMask = iGPIO_getUserPinsMask();
+    // const uint64_t pinsMask = iGPIO_getBcmPinsMask(rpihal_emu_model);
+    const uint64_t pinsMask = rpihal_emu_platform.userPinsMask;
 
     for (int pin = 0; pin < 64; ++pin)
     {
@@ -726,19 +741,72 @@ void RPIHAL_EMU_cleanup()
 
 int RPIHAL_EMU_isRunning() { return thread_pge_sd.isRunning(); }
 
+//======================================================================================================================
+// bitbang.h
+
+void RPIHAL_BITBANG_defaultBus(RPIHAL_BITBANG_bus_t* bus)
+{
+    bus->clk = -1;
+    for (int i = 0; i < RPIHAL_BITBANG_WIDTH_MAX; ++i) { bus->data[i] = -1; }
+    bus->width = 1;
+    bus->latch = -1;
+    bus->msbFirst = 1;
+    bus->clkIdle = 0;
+    bus->setup = 0;
+    bus->hold = 0;
+    bus->latchPulse = 0;
+}
+
+int RPIHAL_BITBANG_compile(RPIHAL_BITBANG_program_t* program, const RPIHAL_BITBANG_bus_t* bus, const void* data, size_t count)
+{
+    program->count = 0;
+
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+int RPIHAL_BITBANG_run(const RPIHAL_BITBANG_program_t* program) { return -1; }
+
+void RPIHAL_BITBANG_free(RPIHAL_BITBANG_program_t* program)
+{
+    free(program->steps);
+
+    program->steps = NULL;
+    program->count = 0;
+    program->capacity = 0;
+}
+
 //======================================================================================================================
 // gpio.h
 
-static const int sysGpioLocked = 1;
 static constexpr /*RPIHAL_regptr_t*/ bool gpio_base = true; // dummy to make copy-paste more easy
 
 int RPIHAL_GPIO_init() { return 0; } // nop
 
+int RPIHAL_GPIO_initBackend(int id, RPIHAL_model_t model)
+{
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+void RPIHAL_GPIO_setTraceCallback(RPIHAL_GPIO_trace_cb_t cb)
+{
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+}
+
+int RPIHAL_GPIO_setAccessMode(int mode)
+{
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+int RPIHAL_GPIO_getAccessMode() { return RPIHAL_GPIO_ACCESS_BARRIER; } // no registers are accessed in EMU
+
 int RPIHAL_GPIO_initPin(int pin, const RPIHAL_GPIO_init_t* initStruct)
 {
     int r = 0;
 
-    if (gpio_base && initStruct && iGPIO_checkPin(pin, sysGpioLocked)) { thread_pge_sd.setGpioConfig(pin, emu::Gpio(*initStruct)); }
+    if (gpio_base && initStruct && iGPIO_checkPin(pin, &rpihal_emu_platform)) { thread_pge_sd.setGpioConfig(pin, emu::Gpio(*initStruct)); }
     else { r = 1; }
 
     return r;
@@ -764,11 +832,64 @@ int RPIHAL_GPIO_initPins(uint64_t bits, const RPIHAL_GPIO_init_t* initStruct)
     return r;
 }
 
+int RPIHAL_GPIO_initPinList(const RPIHAL_GPIO_pinInit_t* list, size_t count)
+{
+    int r = 0;
+
+    if (!list && count) { return -(__LINE__); }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const int err = RPIHAL_GPIO_initPin(list[i].pin, &list[i].init);
+        if (err) { r = -(__LINE__); }
+    }
+
+    return r;
+}
+
+// The emulator has no latch, edges are detected by comparing the levels at the time of the calls.
+static uint64_t rpihal_emu_gpio_ren = 0;
+static uint64_t rpihal_emu_gpio_fen = 0;
+static uint64_t rpihal_emu_gpio_edgeLevel = 0;
+static uint64_t rpihal_emu_gpio_events = 0;
+
+static void rpihal_emu_gpio_updateEvents()
+{
+    const uint64_t level = RPIHAL_GPIO_read64();
+    rpihal_emu_gpio_events |= ((level & ~rpihal_emu_gpio_edgeLevel & rpihal_emu_gpio_ren) | (~level & rpihal_emu_gpio_edgeLevel & rpihal_emu_gpio_fen));
+    rpihal_emu_gpio_edgeLevel = level;
+}
+
+int RPIHAL_GPIO_setEdgeDetect(uint64_t bits, int edge)
+{
+    rpihal_emu_gpio_updateEvents();
+
+    if (edge & RPIHAL_GPIO_EDGE_RISING) { rpihal_emu_gpio_ren |= bits; }
+    else { rpihal_emu_gpio_ren &= ~bits; }
+
+    if (edge & RPIHAL_GPIO_EDGE_FALLING) { rpihal_emu_gpio_fen |= bits; }
+    else { rpihal_emu_gpio_fen &= ~bits; }
+
+    rpihal_emu_gpio_events &= ~bits;
+
+    return 0;
+}
+
+uint64_t RPIHAL_GPIO_fetchEvents(uint64_t bits)
+{
+    rpihal_emu_gpio_updateEvents();
+
+    const uint64_t events = rpihal_emu_gpio_events & bits;
+    rpihal_emu_gpio_events &= ~events;
+
+    return events;
+}
+
 int RPIHAL_GPIO_readPin(int pin)
 {
     int r = 0;
 
-    if (gpio_base && iGPIO_checkPin(pin, sysGpioLocked)) { r = thread_pge_sd.getGpioState(pin); }
+    if (gpio_base && iGPIO_checkPin(pin, &rpihal_emu_platform)) { r = thread_pge_sd.getGpioState(pin); }
     else { r = -1; }
 
     return r;
@@ -807,7 +928,7 @@ int RPIHAL_GPIO_writePin(int pin, int state)
 {
     int r = 0;
 
-    if (gpio_base && iGPIO_checkPin(pin, sysGpioLocked)) { thread_pge_sd.setGpioState(pin, state != 0); }
+    if (gpio_base && iGPIO_checkPin(pin, &rpihal_emu_platform)) { thread_pge_sd.setGpioState(pin, state != 0); }
     else { r = 1; }
 
     return r;
@@ -825,16 +946,49 @@ int RPIHAL_GPIO_clr(uint32_t bits)
     return -1;
 }
 
+int RPIHAL_GPIO_write64(uint64_t mask, uint64_t value)
+{
+    const uint64_t pinsMask = rpihal_emu_platform.userPinsMask;
+    if (pinsMask == 0) { return -1; }
+
+    mask &= pinsMask;
+
+    for (int pin = 0; pin < 64; ++pin)
+    {
+        const uint64_t m = (1llu << pin);
+        if (m & mask) { thread_pge_sd.setGpioState(pin, (value & m) != 0); }
+    }
+
+    return 0;
+}
+
 int RPIHAL_GPIO_togglePin(int pin)
 {
     int r = 0;
 
-    if (gpio_base && iGPIO_checkPin(pin, sysGpioLocked)) { thread_pge_sd.setGpioState(pin, !thread_pge_sd.getGpioState(pin)); }
+    if (gpio_base && iGPIO_checkPin(pin, &rpihal_emu_platform)) { thread_pge_sd.setGpioState(pin, !thread_pge_sd.getGpioState(pin)); }
     else { r = -1; }
 
     return r;
 }
 
+int RPIHAL_GPIO_toggle64(uint64_t bits)
+{
+    const uint64_t pinsMask = rpihal_emu_platform.userPinsMask;
+    if (pinsMask == 0) { return -1; }
+
+    bits &= pinsMask;
+
+    for (int pin = 0; pin < 64; ++pin)
+    {
+        if (bits & (1llu << pin)) { thread_pge_sd.setGpioState(pin, !thread_pge_sd.getGpioState(pin)); }
+    }
+
+    return 0;
+}
+
+uint64_t RPIHAL_GPIO_readOutput64() { return RPIHAL_GPIO_read64(); }
+
 int RPIHAL_GPIO_reset()
 {
     LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
@@ -847,11 +1001,137 @@ int RPIHAL_GPIO_resetPin(int pin)
     return -1;
 }
 
+int RPIHAL_GPIO_snapshot(RPIHAL_GPIO_snapshot_t* snapshot)
+{
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+int RPIHAL_GPIO_restore(const RPIHAL_GPIO_snapshot_t* snapshot)
+{
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+uint64_t RPIHAL_GPIO_diffSnapshot(const RPIHAL_GPIO_snapshot_t* a, const RPIHAL_GPIO_snapshot_t* b)
+{
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return (a->pins | b->pins);
+}
+
 void RPIHAL_GPIO_defaultInitStruct(RPIHAL_GPIO_init_t* initStruct) { iGPIO_defaultInitStruct(initStruct); }
-int RPIHAL_GPIO_defaultInitStructPin(int pin, RPIHAL_GPIO_init_t* initStruct) { return iGPIO_defaultInitStructPin(pin, initStruct); }
+int RPIHAL_GPIO_defaultInitStructPin(int pin, RPIHAL_GPIO_init_t* initStruct) { return iGPIO_defaultInitStructPin(pin, initStruct, rpihal_emu_model); }
+
+int RPIHAL_GPIO_getPinHandle(RPIHAL_GPIO_pin_t* handle, int pin)
+{
+    if (handle) { *handle = RPIHAL_GPIO_pin_t(); }
+
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
 
 int RPIHAL_GPIO_bittopin(uint64_t bit) { return iGPIO_bittopin(bit); }
 
+//======================================================================================================================
+// gpiocapture.h
+
+void RPIHAL_GPIOCAPTURE_defaultConfig(RPIHAL_GPIOCAPTURE_config_t* config)
+{
+    config->bits = 0x0FFFFFFF;
+    config->rate = 1000000;
+    config->nSamples = 0;
+    config->capacity = 65536;
+    config->cpu = -1;
+    config->priority = 0;
+}
+
+int RPIHAL_GPIOCAPTURE_start(RPIHAL_GPIOCAPTURE_instance_t* inst, const RPIHAL_GPIOCAPTURE_config_t* config)
+{
+    inst->config = *config;
+    inst->capture = NULL;
+
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+size_t RPIHAL_GPIOCAPTURE_read(RPIHAL_GPIOCAPTURE_instance_t* inst, RPIHAL_GPIOCAPTURE_change_t* changes, size_t count) { return 0; }
+int RPIHAL_GPIOCAPTURE_getStats(const RPIHAL_GPIOCAPTURE_instance_t* inst, RPIHAL_GPIOCAPTURE_stats_t* stats) { return -1; }
+int RPIHAL_GPIOCAPTURE_stop(RPIHAL_GPIOCAPTURE_instance_t* inst) { return -1; }
+int RPIHAL_GPIOCAPTURE_writeVcdHeader(RPIHAL_GPIOCAPTURE_instance_t* inst, FILE* fp) { return -1; }
+int RPIHAL_GPIOCAPTURE_writeVcd(RPIHAL_GPIOCAPTURE_instance_t* inst, FILE* fp, const RPIHAL_GPIOCAPTURE_change_t* changes, size_t count) { return -1; }
+
+//======================================================================================================================
+// gpiodma.h
+
+void RPIHAL_GPIODMA_defaultConfig(RPIHAL_GPIODMA_config_t* config)
+{
+    config->backend = RPIHAL_GPIO_BACKEND_MMAP;
+    config->channel = 10;
+    config->tick = 1000;
+    config->loops = 1;
+    config->poll = 1000;
+    config->callback = NULL;
+    config->arg = NULL;
+}
+
+int RPIHAL_GPIODMA_play(RPIHAL_GPIODMA_instance_t* inst, const RPIHAL_GPIOWAVE_entry_t* wave, size_t count, const RPIHAL_GPIODMA_config_t* config)
+{
+    inst->dma = NULL;
+
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+int RPIHAL_GPIODMA_getStatus(const RPIHAL_GPIODMA_instance_t* inst, RPIHAL_GPIODMA_status_t* status) { return -1; }
+int RPIHAL_GPIODMA_wait(RPIHAL_GPIODMA_instance_t* inst) { return -1; }
+int RPIHAL_GPIODMA_stop(RPIHAL_GPIODMA_instance_t* inst) { return -1; }
+
+//======================================================================================================================
+// gpioevent.h
+
+int RPIHAL_GPIOEVENT_open(RPIHAL_GPIOEVENT_instance_t* inst, const char* dev, uint64_t bits, int edge, uint32_t config)
+{
+    inst->dev[0] = 0;
+    inst->fd = -1;
+    inst->bits = 0;
+    inst->reader = NULL;
+
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+int RPIHAL_GPIOEVENT_wait(const RPIHAL_GPIOEVENT_instance_t* inst, int timeout_ms) { return -1; }
+int RPIHAL_GPIOEVENT_read(const RPIHAL_GPIOEVENT_instance_t* inst, RPIHAL_GPIOEVENT_event_t* events, size_t count) { return -1; }
+int RPIHAL_GPIOEVENT_startReader(RPIHAL_GPIOEVENT_instance_t* inst, size_t capacity) { return -1; }
+int RPIHAL_GPIOEVENT_stopReader(RPIHAL_GPIOEVENT_instance_t* inst) { return -1; }
+size_t RPIHAL_GPIOEVENT_drain(RPIHAL_GPIOEVENT_instance_t* inst, RPIHAL_GPIOEVENT_event_t* events, size_t count) { return 0; }
+int RPIHAL_GPIOEVENT_getReaderFd(const RPIHAL_GPIOEVENT_instance_t* inst) { return -1; }
+int RPIHAL_GPIOEVENT_getStats(const RPIHAL_GPIOEVENT_instance_t* inst, RPIHAL_GPIOEVENT_stats_t* stats) { return -1; }
+int RPIHAL_GPIOEVENT_close(RPIHAL_GPIOEVENT_instance_t* inst) { return 0; }
+
+//======================================================================================================================
+// gpiowave.h
+
+void RPIHAL_GPIOWAVE_defaultConfig(RPIHAL_GPIOWAVE_config_t* config)
+{
+    config->loops = 1;
+    config->spin = 100000;
+    config->cpu = -1;
+    config->priority = 0;
+}
+
+int RPIHAL_GPIOWAVE_play(RPIHAL_GPIOWAVE_instance_t* inst, const RPIHAL_GPIOWAVE_entry_t* wave, size_t count, const RPIHAL_GPIOWAVE_config_t* config)
+{
+    inst->wave = NULL;
+
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+int RPIHAL_GPIOWAVE_getStats(const RPIHAL_GPIOWAVE_instance_t* inst, RPIHAL_GPIOWAVE_stats_t* stats) { return -1; }
+int RPIHAL_GPIOWAVE_wait(RPIHAL_GPIOWAVE_instance_t* inst) { return -1; }
+int RPIHAL_GPIOWAVE_stop(RPIHAL_GPIOWAVE_instance_t* inst) { return -1; }
+
 //======================================================================================================================
 // i2c.h
 
@@ -899,6 +1179,39 @@ int RPIHAL_I2C_close(RPIHAL_I2C_instance_t* inst)
     return 0;
 }
 
+//======================================================================================================================
+// pwm.h
+
+int RPIHAL_PWM_init() { return RPIHAL_PWM_initBackend(RPIHAL_GPIO_BACKEND_MMAP, RPIHAL_model_unknown); }
+
+int RPIHAL_PWM_initBackend(int id, RPIHAL_model_t model)
+{
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+int RPIHAL_PWM_setClock(uint32_t frequency, uint32_t* actual) { return -1; }
+
+void RPIHAL_PWM_defaultChConfig(RPIHAL_PWM_chConfig_t* config)
+{
+    config->mode = RPIHAL_PWM_MODE_MS;
+    config->range = 1024;
+    config->useFifo = 0;
+    config->repeat = 0;
+    config->silence = 0;
+    config->invert = 0;
+}
+
+int RPIHAL_PWM_configChannel(int ch, const RPIHAL_PWM_chConfig_t* config) { return -1; }
+int RPIHAL_PWM_enable(int ch, int enable) { return -1; }
+int RPIHAL_PWM_setData(int ch, uint32_t data) { return -1; }
+int RPIHAL_PWM_writeFifo(const uint32_t* data, size_t count) { return -1; }
+int RPIHAL_PWM_streamFifo(const uint32_t* data, size_t count) { return -1; }
+int RPIHAL_PWM_clearFifo() { return -1; }
+int RPIHAL_PWM_setDma(int enable) { return -1; }
+int RPIHAL_PWM_getStatus(RPIHAL_PWM_status_t* status) { return -1; }
+int RPIHAL_PWM_deinit() { return 0; }
+
 //======================================================================================================================
 // rpihal.h
 
@@ -972,10 +1285,41 @@ const char* RPIHAL_dt_model()
     return r;
 }
 
+//======================================================================================================================
+// softpwm.h
+
+void RPIHAL_SOFTPWM_defaultConfig(RPIHAL_SOFTPWM_config_t* config)
+{
+    config->bits = 0;
+    config->frequency = 1000;
+    config->resolution = 1000;
+    config->spin = 100000;
+    config->cpu = -1;
+    config->priority = 0;
+}
+
+int RPIHAL_SOFTPWM_start(RPIHAL_SOFTPWM_instance_t* inst, const RPIHAL_SOFTPWM_config_t* config)
+{
+    inst->pwm = NULL;
+
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+int RPIHAL_SOFTPWM_setDuty(RPIHAL_SOFTPWM_instance_t* inst, uint64_t bits, uint32_t duty) { return -1; }
+int RPIHAL_SOFTPWM_setFrequency(RPIHAL_SOFTPWM_instance_t* inst, uint32_t frequency) { return -1; }
+int RPIHAL_SOFTPWM_getStats(const RPIHAL_SOFTPWM_instance_t* inst, RPIHAL_SOFTPWM_stats_t* stats) { return -1; }
+int RPIHAL_SOFTPWM_stop(RPIHAL_SOFTPWM_instance_t* inst) { return -1; }
+
 //======================================================================================================================
 // spi.h
 
 int RPIHAL_SPI_open(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSpeed, uint32_t config)
+{
+    return RPIHAL_SPI_openBackend(inst, dev, maxSpeed, config, RPIHAL_SPI_BACKEND_SPIDEV);
+}
+
+int RPIHAL_SPI_openBackend(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSpeed, uint32_t config, int backend)
 {
     const uint8_t nBits = 8; // see `RPIHAL_SPI_open()` in rpihal/src/spi.c
 
@@ -986,6 +1330,10 @@ int RPIHAL_SPI_open(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSp
     inst->dev[RPIHAL_SPI_INSTANCE_DEV_SIZE - 1] = 0;
 
     inst->fd = -1;
+    inst->mode = config;
+    inst->backend = backend;
+    inst->device = -1;
+    inst->bufsiz = RPIHAL_SPI_BUFSIZ_DEFAULT;
 
     inst->transfer_cb = NULL;
 
@@ -1001,6 +1349,20 @@ int RPIHAL_SPI_transfer(const RPIHAL_SPI_instance_t* inst, const uint8_t* txData
     return r;
 }
 
+int RPIHAL_SPI_transaction(const RPIHAL_SPI_instance_t* inst, const RPIHAL_SPI_segment_t* segments, size_t count)
+{
+    int r = -1;
+
+    if (inst->transfer_cb && (count > 0) && (count <= RPIHAL_SPI_SEGMENTS_MAX))
+    {
+        r = 0;
+
+        for (size_t i = 0; (i < count) && (r == 0); ++i) { r = inst->transfer_cb(segments[i].txData, segments[i].rxBuffer, segments[i].count); }
+    }
+
+    return r;
+}
+
 int RPIHAL_SPI_close(RPIHAL_SPI_instance_t* inst)
 {
     inst->dev[0] = 0;
@@ -1011,6 +1373,67 @@ int RPIHAL_SPI_close(RPIHAL_SPI_instance_t* inst)
     return 0;
 }
 
+uint64_t RPIHAL_SPI_getModeSwitches(const RPIHAL_SPI_instance_t* inst) { return 0; }
+
+int RPIHAL_SPI_poolCreate(RPIHAL_SPI_pool_t* pool, const RPIHAL_SPI_instance_t* inst, size_t count) { return iSPI_poolCreate(pool, inst->bufsiz, count); }
+uint8_t* RPIHAL_SPI_poolGet(RPIHAL_SPI_pool_t* pool) { return iSPI_poolGet(pool); }
+void RPIHAL_SPI_poolPut(RPIHAL_SPI_pool_t* pool, uint8_t* buffer) { iSPI_poolPut(pool, buffer); }
+void RPIHAL_SPI_poolDestroy(RPIHAL_SPI_pool_t* pool) { iSPI_poolDestroy(pool); }
+
+//======================================================================================================================
+// spiadc.h
+
+void RPIHAL_SPIADC_defaultConfig(RPIHAL_SPIADC_config_t* config)
+{
+    config->spi = NULL;
+    config->device = RPIHAL_SPIADC_DEVICE_MCP3208;
+    for (size_t i = 0; i < RPIHAL_SPIADC_CHANNELS_MAX; ++i) { config->channels[i] = (uint8_t)i; }
+    config->nChannels = RPIHAL_SPIADC_CHANNELS_MAX;
+    config->scansPerMessage = RPIHAL_SPI_SEGMENTS_MAX / RPIHAL_SPIADC_CHANNELS_MAX;
+    config->rate = 1000;
+    config->nScans = 0;
+    config->capacity = 4096;
+    config->cpu = -1;
+    config->priority = 0;
+}
+
+int RPIHAL_SPIADC_start(RPIHAL_SPIADC_instance_t* inst, const RPIHAL_SPIADC_config_t* config)
+{
+    inst->config = *config;
+    inst->sampler = NULL;
+
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+size_t RPIHAL_SPIADC_read(RPIHAL_SPIADC_instance_t* inst, RPIHAL_SPIADC_scan_t* scans, size_t count) { return 0; }
+int RPIHAL_SPIADC_getStats(const RPIHAL_SPIADC_instance_t* inst, RPIHAL_SPIADC_stats_t* stats) { return -1; }
+int RPIHAL_SPIADC_stop(RPIHAL_SPIADC_instance_t* inst) { return -1; }
+
+//======================================================================================================================
+// spiqueue.h
+
+void RPIHAL_SPIQUEUE_defaultConfig(RPIHAL_SPIQUEUE_config_t* config)
+{
+    config->capacity = 64;
+    config->cpu = -1;
+    config->priority = 0;
+}
+
+int RPIHAL_SPIQUEUE_create(RPIHAL_SPIQUEUE_instance_t* inst, const RPIHAL_SPIQUEUE_config_t* config)
+{
+    inst->queue = NULL;
+
+    LOG_ERR("%s is not yet implemented in EMU", __func__); // TODO
+    return -1;
+}
+
+int RPIHAL_SPIQUEUE_submit(RPIHAL_SPIQUEUE_instance_t* inst, const RPIHAL_SPIQUEUE_request_t* request) { return -1; }
+int RPIHAL_SPIQUEUE_getFd(const RPIHAL_SPIQUEUE_instance_t* inst) { return -1; }
+int RPIHAL_SPIQUEUE_flush(RPIHAL_SPIQUEUE_instance_t* inst) { return -1; }
+int RPIHAL_SPIQUEUE_getStats(const RPIHAL_SPIQUEUE_instance_t* inst, RPIHAL_SPIQUEUE_stats_t* stats) { return -1; }
+int RPIHAL_SPIQUEUE_destroy(RPIHAL_SPIQUEUE_instance_t* inst) { return -1; }
+
 //======================================================================================================================
 // sys.h
 
@@ -1053,3 +1476,6 @@ int RPIHAL_UART_open(RPIHAL_UART_port_t* port, const char* name, int baud /*, pa
 
 #define iGPIO_DEFINE_FUNCTIONS
 #include "../internal/gpio.h"
+
+#define iSPI_DEFINE_FUNCTIONS
+#include "../internal/spi.h"
@@ -31,12 +31,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <stdint.h>
 #include <string.h>
 
+#include "internal/bcm.h"
 #include "internal/gpio.h"
 #include "internal/platform_check.h"
 #include "rpihal/gpio.h"
 #include "rpihal/rpihal.h"
 
 #include <fcntl.h>
+#include <sched.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -51,20 +53,6 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //======================================================================================================================
 //  BCM abstraction
 
-#define BCM_REGISTER_PASSWORD (0x5A000000u)
-#define BCM_BLOCK_SIZE        (4 * 1024)
-// #define BCM_PAGE_SIZE      (4 * 1024)
-
-#define PERI_ADR_BASE_BCM2835   (0x20000000u)
-#define PERI_ADR_BASE_BCM2836_7 (0x3F000000u)
-#define PERI_ADR_BASE_BCM2836   PERI_ADR_BASE_BCM2836_7
-#define PERI_ADR_BASE_BCM2837   PERI_ADR_BASE_BCM2836_7
-#define PERI_ADR_BASE_BCM2711   (0xFE000000u)
-
-#define PERI_ADR_OFFSET_GPIO (0x00200000u) // BCM283x and BCM2711
-
-
-
 // GPIO register offsets
 
 #define GPFSEL0 (0x0000)
@@ -135,134 +123,361 @@ static const uint32_t FSEL_AF_LUT[] = { FSEL_AF0, FSEL_AF1, FSEL_AF2, FSEL_AF3,
 #define BCM2711_GPIO_PUP_PDN_UP   (0x01)
 #define BCM2711_GPIO_PUP_PDN_DOWN (0x02)
 
+// PADS register offsets (relative to PERI_ADR_OFFSET_PADS), one register per group
+
+#define PADS_GPIO_0_27  (0x002C)
+#define PADS_GPIO_28_45 (0x0030)
+#define PADS_GPIO_46_53 (0x0034) // 46..57 on BCM2711
+
+#define PADS_SLEW       (0x10) // slew rate not limited
+#define PADS_HYST       (0x08) // hysteresis enabled
+#define PADS_DRIVE_MASK (0x07) // 2mA steps, 0 = 2mA
+
+
+
+// end BCM abstraction
+//======================================================================================================================
+
+
+
+//======================================================================================================================
+//  RP1 abstraction
+//
+// On BCM2712 (Pi 5, CM5) the GPIOs are in the RP1 southbridge. Each pin has its own CTRL register selecting the
+// function, the outputs are driven by the registered IO block (RIO) and pull/drive are set in the PADS block. Every RP1
+// register has atomic XOR, SET and CLR aliases, so no read-modify-write is needed to change single bits.
+
+#define RP1_ADR_IO_BANK0 (0x1F000D0000ll) // physical address, `/dev/gpiomem0` maps the same block at offset 0
+
+// register offsets relative to IO_BANK0
+#define RP1_IO_BANK0   (0x00000)
+#define RP1_SYS_RIO0   (0x10000)
+#define RP1_PADS_BANK0 (0x20000)
+#define RP1_BLOCK_SIZE (0x30000)
+
+#define RP1_ALIAS_XOR (0x1000)
+#define RP1_ALIAS_SET (0x2000)
+#define RP1_ALIAS_CLR (0x3000)
+
+#define RP1_GPIO_CTRL(_pin) (RP1_IO_BANK0 + ((_pin) * 8) + 4)
+#define RP1_RIO_OUT         (RP1_SYS_RIO0 + 0x0000)
+#define RP1_RIO_OE          (RP1_SYS_RIO0 + 0x0004)
+#define RP1_RIO_SYNC_IN     (RP1_SYS_RIO0 + 0x0008)
+#define RP1_PADS_GPIO(_pin) (RP1_PADS_BANK0 + 0x0004 + ((_pin) * 4))
+
+#define RP1_NPINS (28) // bank 0, the 40 pin header
+
+#define RP1_CTRL_FUNCSEL_MASK (0x1F)
+#define RP1_FUNCSEL_SYS_RIO   (0x05)
+
+#define RP1_PADS_SLEWFAST   (0x01)
+#define RP1_PADS_SCHMITT    (0x02)
+#define RP1_PADS_PDE        (0x04)
+#define RP1_PADS_PUE        (0x08)
+#define RP1_PADS_DRIVE_MASK (0x30) // 0 = 2mA, 1 = 4mA, 2 = 8mA, 3 = 12mA
+#define RP1_PADS_DRIVE_POS  (4)
+#define RP1_PADS_IE         (0x40)
+#define RP1_PADS_OD         (0x80)
+
+static int rp1 = 0; // RP1 register layout, resolved at init
+
+// end RP1 abstraction
+//======================================================================================================================
+
+
+
+//======================================================================================================================
+//  register backends
+//
+// Every register access goes through the selected backend. The mmap backend accesses the hardware, the anon backend
+// emulates the register block in anonymous memory and the trace backend wraps one of the other two.
+//
+// The mmap backend is the access policy itself (see `RPIHAL_GPIO_ACCESS`). The anon backend uses the policy for the
+// register file too, so that its cost shows up in off-target benchmarks.
+
+typedef struct
+{
+    uint32_t (*read)(RPIHAL_regptr_t addr);
+    void (*write)(RPIHAL_regptr_t addr, uint32_t value);
+} backend_t;
+
+static const backend_t access_relaxed = { .read = BCM_reg_read_relaxed, .write = BCM_reg_write_relaxed };
+static const backend_t access_barrier = { .read = BCM_reg_read_mb, .write = BCM_reg_write_mb };
+static const backend_t access_erratum = { .read = BCM2835_reg_read, .write = BCM2835_reg_write };
+
+static RPIHAL_regptr_t gpio_base = NULL; // = PERI_ADR_BASE_x + PERI_ADR_OFFSET_GPIO
+
+// The backend pointers may be swapped by `RPIHAL_GPIO_setAccessMode()` while other threads access the registers. They
+// point to constant tables, so they are stored with release and loaded with acquire, an access in flight completes with
+// the previous table.
+static const backend_t* regAccess = &access_barrier;
+
+static inline const backend_t* getRegAccess() { return __atomic_load_n(&regAccess, __ATOMIC_ACQUIRE); }
+
+static uint32_t ANON_reg_read(RPIHAL_regptr_t addr) { return getRegAccess()->read(addr); }
+
+// GPSET/GPCLR and the GPEDS clear are atomic in hardware, the output path writes them without a lock. So the emulation
+// modifies GPLEV and GPEDS atomically as well.
+static void ANON_setLevel(int bank, uint32_t set, uint32_t clr)
+{
+    RPIHAL_regptr_t lev = gpio_base + (GPLEV0 / 4) + bank;
+
+    uint32_t old = getRegAccess()->read(lev);
+    uint32_t level;
+
+    do
+    {
+        level = (old | set) & ~clr;
+    }
+    while (!__atomic_compare_exchange_n(lev, &old, level, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    // latch the edges armed in GPREN/GPFEN/GPAREN/GPAFEN
+    const uint32_t ren = gpio_base[(GPREN0 / 4) + bank] | gpio_base[(GPAREN0 / 4) + bank];
+    const uint32_t fen = gpio_base[(GPFEN0 / 4) + bank] | gpio_base[(GPAFEN0 / 4) + bank];
+    __atomic_fetch_or(gpio_base + (GPEDS0 / 4) + bank, ((level & ~old & ren) | (~level & old & fen)), __ATOMIC_RELAXED);
+}
 
+static void ANON_reg_write(RPIHAL_regptr_t addr, uint32_t value)
+{
+    // GPSET and GPCLR are write only, setting a bit sets/clears the corresponding bit in GPLEV. GPEDS bits are cleared by
+    // writing 1.
 
-// the following functions are the same for bcm2835 and bcm2711
+    // clang-format off
+    switch ((addr - gpio_base) * 4)
+    {
+    case GPSET0: ANON_setLevel(0, value, 0); break;
+    case GPSET1: ANON_setLevel(1, value, 0); break;
+    case GPCLR0: ANON_setLevel(0, 0, value); break;
+    case GPCLR1: ANON_setLevel(1, 0, value); break;
+    case GPEDS0:
+    case GPEDS1: __atomic_fetch_and(addr, ~value, __ATOMIC_RELAXED); break;
+    default: getRegAccess()->write(addr, value); break;
+    }
+    // clang-format on
+}
 
-static inline void BCM2835_wait_cycles(size_t cycleCount)
+// The RP1 aliases modify the register they alias atomically (like the hardware), RIO OUT is looped back to SYNC_IN.
+static void ANON_RP1_reg_write(RPIHAL_regptr_t addr, uint32_t value)
 {
-    while (--cycleCount) { asm volatile("nop"); }
+    const uint32_t offset = (uint32_t)((addr - gpio_base) * 4);
+    const uint32_t alias = (offset & 0x3000);
+    RPIHAL_regptr_t reg = gpio_base + ((offset & ~0x3000u) / 4);
+
+    // clang-format off
+    switch (alias)
+    {
+    case RP1_ALIAS_XOR: value = __atomic_xor_fetch(reg, value, __ATOMIC_RELAXED); break;
+    case RP1_ALIAS_SET: value = __atomic_or_fetch(reg, value, __ATOMIC_RELAXED); break;
+    case RP1_ALIAS_CLR: value = __atomic_and_fetch(reg, ~value, __ATOMIC_RELAXED); break;
+    default: getRegAccess()->write(reg, value); break;
+    }
+    // clang-format on
+
+    if (reg == (gpio_base + (RP1_RIO_OUT / 4))) { getRegAccess()->write(gpio_base + (RP1_RIO_SYNC_IN / 4), value); }
 }
 
-// clang-format off
-#ifdef __GNUC__
-#pragma GCC push_options
-#pragma GCC optimize ("O0")
-#else // __GNUC__
-#error "compiler yet not supported, please open an issue on GitHub"
-#endif // __GNUC__
-// clang-format on
+static const backend_t backend_anon = { .read = ANON_reg_read, .write = ANON_reg_write };
+static const backend_t backend_anon_rp1 = { .read = ANON_reg_read, .write = ANON_RP1_reg_write };
+
+static const backend_t* traceTarget = NULL;
+static RPIHAL_GPIO_trace_cb_t traceCallback = NULL;
+
+static inline const backend_t* getTraceTarget() { return __atomic_load_n(&traceTarget, __ATOMIC_ACQUIRE); }
+
+static void traceAccess(int write, RPIHAL_regptr_t addr, uint32_t value)
+{
+    const uint32_t offset = (uint32_t)((addr - gpio_base) * 4);
+
+    if (traceCallback) { traceCallback(write, offset, value); }
+    else { printf("[rpihal] GPIO <TRC> %c 0x%04x 0x%08x\n", (write ? 'W' : 'R'), offset, value); }
+}
 
-static uint32_t BCM2835_reg_read(RPIHAL_regptr_t addr)
+static uint32_t TRACE_reg_read(RPIHAL_regptr_t addr)
 {
-    // the last read could potentially go wrong (see chapter 1.3 in BCM2835-ARM-Peripherals.pdf).
-    uint32_t value = *addr;
-    uint32_t garbage __attribute__((unused)) = *addr;
+    const uint32_t value = getTraceTarget()->read(addr);
+    traceAccess(0, addr, value);
     return value;
 }
 
-static void BCM2835_reg_write(RPIHAL_regptr_t addr, uint32_t value)
+static void TRACE_reg_write(RPIHAL_regptr_t addr, uint32_t value)
+{
+    traceAccess(1, addr, value);
+    getTraceTarget()->write(addr, value);
+}
+
+static const backend_t backend_trace = { .read = TRACE_reg_read, .write = TRACE_reg_write };
+
+static const backend_t* backend = &access_barrier;
+static int backendId = -1;
+
+static void selectBackend()
 {
-    // the first write could potentially go wrong (see chapter 1.3 in BCM2835-ARM-Peripherals.pdf).
-    *addr = value;
-    *addr = value;
+    const backend_t* target;
+
+    if ((backendId & ~RPIHAL_GPIO_BACKEND_TRACE) == RPIHAL_GPIO_BACKEND_ANON) { target = (rp1 ? &backend_anon_rp1 : &backend_anon); }
+    else { target = getRegAccess(); }
+
+    __atomic_store_n(&traceTarget, target, __ATOMIC_RELEASE);
+    __atomic_store_n(&backend, ((backendId & RPIHAL_GPIO_BACKEND_TRACE) ? &backend_trace : target), __ATOMIC_RELEASE);
 }
 
-#ifdef __GNUC__
-#pragma GCC pop_options
-#endif // __GNUC__
+static inline uint32_t reg_read(RPIHAL_regptr_t addr) { return __atomic_load_n(&backend, __ATOMIC_ACQUIRE)->read(addr); }
+static inline void reg_write(RPIHAL_regptr_t addr, uint32_t value) { __atomic_load_n(&backend, __ATOMIC_ACQUIRE)->write(addr, value); }
 
-static void BCM2835_reg_write_bits(RPIHAL_regptr_t addr, uint32_t value, uint32_t mask)
+static void reg_write_bits(RPIHAL_regptr_t addr, uint32_t value, uint32_t mask)
 {
-    uint32_t regval = BCM2835_reg_read(addr);
+    uint32_t regval = reg_read(addr);
     regval &= ~mask;
     regval |= (value & mask);
-    BCM2835_reg_write(addr, regval);
+    reg_write(addr, regval);
 }
 
-
-// end BCM abstraction
+// end register backends
 //======================================================================================================================
 
 
 
-static RPIHAL_regptr_t gpio_base = NULL; // = PERI_ADR_BASE_x + PERI_ADR_OFFSET_GPIO
+static iGPIO_platform_t platform; // resolved at init, read only afterwards
 static int usingGpiomem = -1;
-static int sysGpioLocked = 1; // ADDHW check for const RPIHAL_model_t hwModel = RPIHAL_getModel(); before unlocking!
+static RPIHAL_regptr_t pads_base = NULL; // BCM PADS block, NULL if not accessible (no root)
+static int sysGpioLocked = 1; // ADDHW check for the model before unlocking!
                               // may be unlocked on compute modules, illegal to unlock on other models
 
 
 
-static int initPin(int pin, const RPIHAL_GPIO_init_t* initStruct);
-static int readPin(int pin);
-static void writePin(int pin, int state);
+// The registers can't be modified atomically (no exclusive access to device memory), so every read-modify-write of a
+// register shared by multiple pins is done while holding the lock of that register. GPSET/GPCLR/GPEDS are write one to
+// act and need no lock of their own. The locks are only held for a few register accesses.
+static char initLock = 0;
+static char fselLock[6] = { 0 };
+static char pudLock = 0; // BCM2835 GPPUD/GPPUDCLK sequence, shared by all pins
+static char pupLock[4] = { 0 };
+static char edgeLock[2] = { 0 };
+
+static inline void spinLock(char* lock)
+{
+    while (__atomic_test_and_set(lock, __ATOMIC_ACQUIRE)) { sched_yield(); }
+}
 
+static inline void spinUnlock(char* lock) { __atomic_clear(lock, __ATOMIC_RELEASE); }
 
+// Commanded output levels. Every checked write updates the shadow of the bank with one atomic compare and swap and
+// then writes GPSET/GPCLR without a lock (the output path is also used by realtime threads). Toggles are computed from
+// the shadow, GPLEV is not read. Concurrent writes to the same pin are last-writer-wins on the pin, the register writes
+// of two threads may land in the opposite order of their shadow updates.
+static uint32_t outShadow[2] = { 0, 0 };
 
-int RPIHAL_GPIO_init() // TODO make internal (each function has to check gpio_base)
+// Output and level registers of the banks, resolved at init. RP1 has only bank 0 (the registers of bank 1 are `NULL`),
+// the outputs are written through the aliases of RIO OUT.
+typedef struct
 {
-    int r = 0;
+    RPIHAL_regptr_t set[2]; // GPSETn
+    RPIHAL_regptr_t clr[2]; // GPCLRn
+    RPIHAL_regptr_t tgl[2]; // RP1 only, XOR alias
+    RPIHAL_regptr_t out[2]; // output latch, GPLEVn on BCM
+    RPIHAL_regptr_t lev[2]; // GPLEVn
+} regmap_t;
 
-    const RPIHAL_model_t hwModel = RPIHAL_getModel();
-    off_t mmapoffs;
+static regmap_t regs;
 
-    // ADDHW bcm2835, bcm2712
-    if (RPIHAL_model_SoC_is_bcm2836(hwModel)) { mmapoffs = PERI_ADR_BASE_BCM2836 + PERI_ADR_OFFSET_GPIO; }
-    else if (RPIHAL_model_SoC_is_bcm2837_any(hwModel)) { mmapoffs = PERI_ADR_BASE_BCM2837 + PERI_ADR_OFFSET_GPIO; }
-    else if (RPIHAL_model_SoC_is_bcm2711(hwModel)) { mmapoffs = PERI_ADR_BASE_BCM2711 + PERI_ADR_OFFSET_GPIO; }
-    else
-    {
-        const char* dt = RPIHAL_dt_model();
-        if (!dt) { dt = RPIHAL_dt_compatible(); }
-        if (!dt) { dt = "UNKNOWN MODEL"; }
 
-        LOG_ERR("GPIO for %s is not yet supported", dt);
 
-        return -(__LINE__);
-    }
+typedef struct
+{
+    uint32_t fselValue[6];
+    uint32_t fselMask[6];
+    uint64_t outPins;            // pins configured as output, their shadow is loaded from the output latch
+    uint64_t pudPins[3];         // BCM2835, pins to be clocked in, indexed by the GPPUD value
+    uint32_t pupValue[4];        // BCM2711
+    uint32_t pupMask[4];         // BCM2711
+    uint64_t pins;               // RP1, all pins of the batch
+    uint8_t funcsel[RP1_NPINS];  // RP1, CTRL.FUNCSEL indexed by the pin
+    uint8_t pads[RP1_NPINS];     // RP1, PADS bits indexed by the pin
+    uint8_t padsMask[RP1_NPINS]; // RP1, drive/slew/schmitt bits to be written (PUE, PDE, IE and OD always are)
+    uint32_t padsValue[3];       // BCM, PADS register value of the group
+    uint32_t padsGroups;         // BCM, bit per group to be written
+} batch_t;
+
+static int initBackend(int id, RPIHAL_model_t model);
+static void initRegmap(RPIHAL_regptr_t base);
+static int initPin(int pin, const RPIHAL_GPIO_init_t* initStruct);
+static int checkPads(const RPIHAL_GPIO_init_t* initStruct);
+static void batchAdd(batch_t* batch, int pin, const RPIHAL_GPIO_init_t* initStruct);
+static int batchApply(const batch_t* batch);
+static int batchApplyRp1(const batch_t* batch);
+static int readPin(int pin);
+static void writePin(int pin, int state);
+static void writeOutputs(int bank, uint32_t setBits, uint32_t clrBits, uint32_t toggleBits);
+static void loadOutputs(uint64_t pins);
+static uint64_t snapshotOutPins(const RPIHAL_GPIO_snapshot_t* snapshot);
+static uint32_t fieldMask(uint64_t pins, int firstPin, int nPins, int width);
 
-    if (!gpio_base)
-    {
-        int fd;
 
-        fd = open("/dev/gpiomem", O_RDWR | O_SYNC | O_CLOEXEC); // no root access needed
 
-        if (fd >= 0)
-        {
-            mmapoffs = 0;
-            usingGpiomem = 1;
-        }
-        else
-        {
-            usingGpiomem = 0;
+int RPIHAL_GPIO_init() { return RPIHAL_GPIO_initBackend(RPIHAL_GPIO_BACKEND_MMAP, RPIHAL_model_unknown); }
 
-            fd = open("/dev/mem", O_RDWR | O_SYNC | O_CLOEXEC); // root access needed
+int RPIHAL_GPIO_initBackend(int id, RPIHAL_model_t model) // TODO make internal (each function has to check gpio_base)
+{
+    spinLock(&initLock);
+    const int r = initBackend(id, model);
+    spinUnlock(&initLock);
 
-            if (fd < 0) r = -(__LINE__);
-        }
+    return r;
+}
 
-        if (r == 0)
-        {
-            gpio_base = (RPIHAL_regptr_t)mmap(0, BCM_BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, mmapoffs);
+int RPIHAL_GPIO_setAccessMode(int mode)
+{
+    int r = 0;
+    const backend_t* tmp;
 
-            if (gpio_base == MAP_FAILED)
-            {
-                r = -(__LINE__);
-                gpio_base = NULL;
-            }
-        }
+    // BCM2835 is not supported by `RPIHAL_GPIO_init()` (no peripheral base), so the erratum is never needed automatically
+    switch (mode)
+    {
+    case RPIHAL_GPIO_ACCESS_AUTO:
+    case RPIHAL_GPIO_ACCESS_BARRIER:
+        tmp = &access_barrier;
+        break;
+
+    case RPIHAL_GPIO_ACCESS_RELAXED:
+        tmp = &access_relaxed;
+        break;
+
+    case RPIHAL_GPIO_ACCESS_ERRATUM:
+        tmp = &access_erratum;
+        break;
 
-        if (close(fd) != 0) { LOG_WRN("failed to close fd from mmap (%i %s)", errno, strerror(errno)); }
+    default:
+        LOG_ERR("invalid access mode %i", mode);
+        r = -(__LINE__);
+        break;
+    }
+
+    if (r == 0)
+    {
+        __atomic_store_n(&regAccess, tmp, __ATOMIC_RELEASE);
+
+        if (gpio_base) { selectBackend(); }
     }
 
     return r;
 }
 
+int RPIHAL_GPIO_getAccessMode()
+{
+    const backend_t* const access = getRegAccess();
+
+    if (access == &access_relaxed) { return RPIHAL_GPIO_ACCESS_RELAXED; }
+    if (access == &access_erratum) { return RPIHAL_GPIO_ACCESS_ERRATUM; }
+    return RPIHAL_GPIO_ACCESS_BARRIER;
+}
+
+void RPIHAL_GPIO_setTraceCallback(RPIHAL_GPIO_trace_cb_t cb) { traceCallback = cb; }
+
 int RPIHAL_GPIO_initPin(int pin, const RPIHAL_GPIO_init_t* initStruct)
 {
     int r = 0;
 
-    if (gpio_base && initStruct && iGPIO_checkPin(pin, sysGpioLocked)) { r = initPin(pin, initStruct); }
+    if (gpio_base && initStruct && iGPIO_checkPin(pin, &platform)) { r = initPin(pin, initStruct); }
     else { r = -(__LINE__); }
 
     return r;
@@ -272,27 +487,142 @@ int RPIHAL_GPIO_initPins(uint64_t bits, const RPIHAL_GPIO_init_t* initStruct)
 {
     int r = 0;
 
+    if (!gpio_base || !initStruct) { return -(__LINE__); }
+    if (checkPads(initStruct) != 0) { return -(__LINE__); }
+
+    batch_t batch;
+    memset(&batch, 0, sizeof(batch));
+
     uint64_t mask = 0x01ull;
 
     while (mask)
     {
         if (mask & bits)
         {
-            const int err = RPIHAL_GPIO_initPin(RPIHAL_GPIO_bittopin(mask), initStruct);
-            if (err) { r = -(__LINE__); }
+            const int pin = RPIHAL_GPIO_bittopin(mask);
+
+            if (iGPIO_checkPin(pin, &platform)) { batchAdd(&batch, pin, initStruct); }
+            else { r = -(__LINE__); }
         }
 
         mask <<= 1;
     }
 
+    const int err = batchApply(&batch);
+    if (err) { r = err; }
+
+    LOG_INF("init pins 0x%016llx", (unsigned long long)bits);
+
+    return r;
+}
+
+int RPIHAL_GPIO_initPinList(const RPIHAL_GPIO_pinInit_t* list, size_t count)
+{
+    int r = 0;
+
+    if (!gpio_base || (!list && count)) { return -(__LINE__); }
+
+    // nothing is written if one of the pad configurations can't be applied
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (checkPads(&list[i].init) != 0) { return -(__LINE__); }
+    }
+
+    batch_t batch;
+    memset(&batch, 0, sizeof(batch));
+
+    uint64_t bits = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (iGPIO_checkPin(list[i].pin, &platform))
+        {
+            batchAdd(&batch, list[i].pin, &list[i].init);
+            bits |= RPIHAL_GPIO_BIT(list[i].pin);
+        }
+        else { r = -(__LINE__); }
+    }
+
+    const int err = batchApply(&batch);
+    if (err) { r = err; }
+
+    LOG_INF("init pins 0x%016llx", (unsigned long long)bits);
+
     return r;
 }
 
+int RPIHAL_GPIO_setEdgeDetect(uint64_t bits, int edge)
+{
+    if (!gpio_base) { return -(__LINE__); }
+
+    if (rp1)
+    {
+        LOG_ERR("edge detect is not implemented for RP1");
+        return -(__LINE__);
+    }
+
+    if (bits & ~platform.accessMask)
+    {
+        LOG_ERR("invalid pins: 0x%016llx", (unsigned long long)(bits & ~platform.accessMask));
+        return -(__LINE__);
+    }
+
+    const int async = (edge & RPIHAL_GPIO_EDGE_ASYNC);
+    const uint32_t ren = ((edge & RPIHAL_GPIO_EDGE_RISING) && !async) ? 0xFFFFFFFF : 0;
+    const uint32_t fen = ((edge & RPIHAL_GPIO_EDGE_FALLING) && !async) ? 0xFFFFFFFF : 0;
+    const uint32_t aren = ((edge & RPIHAL_GPIO_EDGE_RISING) && async) ? 0xFFFFFFFF : 0;
+    const uint32_t afen = ((edge & RPIHAL_GPIO_EDGE_FALLING) && async) ? 0xFFFFFFFF : 0;
+
+    for (int bank = 0; bank < 2; ++bank)
+    {
+        const uint32_t mask = (uint32_t)(bits >> (32 * bank));
+        if (!mask) { continue; }
+
+        spinLock(&edgeLock[bank]);
+
+        reg_write_bits(gpio_base + (GPREN0 / 4) + bank, ren, mask);
+        reg_write_bits(gpio_base + (GPFEN0 / 4) + bank, fen, mask);
+        reg_write_bits(gpio_base + (GPAREN0 / 4) + bank, aren, mask);
+        reg_write_bits(gpio_base + (GPAFEN0 / 4) + bank, afen, mask);
+
+        spinUnlock(&edgeLock[bank]);
+
+        // discard events latched before
+        reg_write(gpio_base + (GPEDS0 / 4) + bank, mask);
+    }
+
+    return 0;
+}
+
+uint64_t RPIHAL_GPIO_fetchEvents(uint64_t bits)
+{
+    uint64_t events = 0;
+
+    if (gpio_base && !rp1)
+    {
+        for (int bank = 0; bank < 2; ++bank)
+        {
+            const uint32_t mask = (uint32_t)(bits >> (32 * bank));
+            if (!mask) { continue; }
+
+            RPIHAL_regptr_t addr = gpio_base + (GPEDS0 / 4) + bank;
+
+            // only the fetched bits are cleared, events latched in between stay pending
+            const uint32_t value = reg_read(addr) & mask;
+            if (value) { reg_write(addr, value); }
+
+            events |= ((uint64_t)value << (32 * bank));
+        }
+    }
+
+    return events;
+}
+
 int RPIHAL_GPIO_readPin(int pin)
 {
     int r = 0;
 
-    if (gpio_base && iGPIO_checkPin(pin, sysGpioLocked)) { r = readPin(pin); }
+    if (gpio_base && iGPIO_checkPin(pin, &platform)) { r = readPin(pin); }
     else { r = -1; }
 
     return r;
@@ -302,11 +632,7 @@ uint32_t RPIHAL_GPIO_read()
 {
     uint32_t value = 0;
 
-    if (gpio_base)
-    {
-        RPIHAL_regptr_t addr = gpio_base + (GPLEV0 / 4);
-        value = BCM2835_reg_read(addr);
-    }
+    if (gpio_base) { value = reg_read(regs.lev[0]); }
 
     return value;
 }
@@ -315,11 +641,7 @@ uint32_t RPIHAL_GPIO_readHi()
 {
     uint32_t value = 0;
 
-    if (gpio_base)
-    {
-        RPIHAL_regptr_t addr = gpio_base + (GPLEV1 / 4);
-        value = BCM2835_reg_read(addr);
-    }
+    if (gpio_base && regs.lev[1]) { value = reg_read(regs.lev[1]); }
 
     return value;
 }
@@ -339,7 +661,7 @@ int RPIHAL_GPIO_writePin(int pin, int state)
 {
     int r = 0;
 
-    if (gpio_base && iGPIO_checkPin(pin, sysGpioLocked)) { writePin(pin, state); }
+    if (gpio_base && iGPIO_checkPin(pin, &platform)) { writePin(pin, state); }
     else { r = -1; }
 
     return r;
@@ -353,12 +675,10 @@ int RPIHAL_GPIO_set(uint32_t bits)
     {
         // bits are masked, but no error is reported on bits outside of mask
 
-        RPIHAL_regptr_t addr = gpio_base + (GPSET0 / 4);
-
-        const uint32_t mask = (uint32_t)iGPIO_getUserPinsMask();
+        const uint32_t mask = (uint32_t)platform.userPinsMask;
         if (mask == 0) { return -(__LINE__); }
 
-        BCM2835_reg_write(addr, (bits & mask));
+        writeOutputs(0, (bits & mask), 0, 0);
     }
     else { r = -(__LINE__); }
 
@@ -373,28 +693,78 @@ int RPIHAL_GPIO_clr(uint32_t bits)
     {
         // bits are masked, but no error is reported on bits outside of mask
 
-        RPIHAL_regptr_t addr = gpio_base + (GPCLR0 / 4);
-
-        const uint32_t mask = (uint32_t)iGPIO_getUserPinsMask();
+        const uint32_t mask = (uint32_t)platform.userPinsMask;
         if (mask == 0) { return -(__LINE__); }
 
-        BCM2835_reg_write(addr, (bits & mask));
+        writeOutputs(0, 0, (bits & mask), 0);
     }
     else r = -(__LINE__);
 
     return r;
 }
 
+int RPIHAL_GPIO_write64(uint64_t mask, uint64_t value)
+{
+    int r = 0;
+
+    if (gpio_base)
+    {
+        // bits are masked, but no error is reported on bits outside of mask
+
+        if (platform.userPinsMask == 0) { return -(__LINE__); }
+
+        mask &= platform.userPinsMask;
+
+        const uint64_t setBits = (mask & value);
+        const uint64_t clrBits = (mask & ~value);
+
+        // only registers with at least one bit to be changed are written
+        if (mask & 0x00000000FFFFFFFFull) { writeOutputs(0, (uint32_t)setBits, (uint32_t)clrBits, 0); }
+        if (mask & 0xFFFFFFFF00000000ull) { writeOutputs(1, (uint32_t)(setBits >> 32), (uint32_t)(clrBits >> 32), 0); }
+    }
+    else { r = -(__LINE__); }
+
+    return r;
+}
+
 int RPIHAL_GPIO_togglePin(int pin)
 {
     int r = 0;
 
-    if (gpio_base && iGPIO_checkPin(pin, sysGpioLocked)) { writePin(pin, !readPin(pin)); }
+    if (gpio_base && iGPIO_checkPin(pin, &platform)) { writeOutputs(pin / 32, 0, 0, (1u << (pin % 32))); }
     else { r = -1; }
 
     return r;
 }
 
+int RPIHAL_GPIO_toggle64(uint64_t bits)
+{
+    int r = 0;
+
+    if (gpio_base)
+    {
+        // bits are masked, but no error is reported on bits outside of mask
+
+        if (platform.userPinsMask == 0) { return -(__LINE__); }
+
+        bits &= platform.userPinsMask;
+
+        if ((uint32_t)bits) { writeOutputs(0, 0, 0, (uint32_t)bits); }
+        if ((uint32_t)(bits >> 32)) { writeOutputs(1, 0, 0, (uint32_t)(bits >> 32)); }
+    }
+    else { r = -(__LINE__); }
+
+    return r;
+}
+
+uint64_t RPIHAL_GPIO_readOutput64()
+{
+    const uint64_t lo = __atomic_load_n(&outShadow[0], __ATOMIC_RELAXED);
+    const uint64_t hi = __atomic_load_n(&outShadow[1], __ATOMIC_RELAXED);
+
+    return ((hi << 32) | lo);
+}
+
 int RPIHAL_GPIO_reset()
 {
     int r = 0;
@@ -403,8 +773,8 @@ int RPIHAL_GPIO_reset()
     {
         RPIHAL_GPIO_init_t initStruct;
 
-        const uint64_t userPinsMask = iGPIO_getUserPinsMask();
-        const uint64_t bcmPinsMask = iGPIO_getBcmPinsMask();
+        const uint64_t userPinsMask = platform.userPinsMask;
+        const uint64_t bcmPinsMask = platform.bcmPinsMask;
         if ((userPinsMask == 0) || (bcmPinsMask == 0)) { return -(__LINE__); }
 
         uint64_t pinBit = 0x01;
@@ -440,7 +810,7 @@ int RPIHAL_GPIO_resetPin(int pin)
 {
     int r = 0;
 
-    if (gpio_base && iGPIO_checkPin(pin, sysGpioLocked))
+    if (gpio_base && iGPIO_checkPin(pin, &platform))
     {
         RPIHAL_GPIO_init_t initStruct;
 
@@ -457,54 +827,239 @@ int RPIHAL_GPIO_resetPin(int pin)
     return r;
 }
 
-void RPIHAL_GPIO_defaultInitStruct(RPIHAL_GPIO_init_t* initStruct) { iGPIO_defaultInitStruct(initStruct); }
-
-int RPIHAL_GPIO_defaultInitStructPin(int pin, RPIHAL_GPIO_init_t* initStruct) { return iGPIO_defaultInitStructPin(pin, initStruct); }
+int RPIHAL_GPIO_snapshot(RPIHAL_GPIO_snapshot_t* snapshot)
+{
+    if (!gpio_base || !snapshot) { return -(__LINE__); }
 
-RPIHAL_regptr_t RPIHAL_GPIO_getMemBasePtr() { return gpio_base; }
+    memset(snapshot, 0, sizeof(RPIHAL_GPIO_snapshot_t));
 
-int RPIHAL_GPIO_isUsingGpiomem() { return usingGpiomem; }
+    snapshot->model = platform.model;
+    snapshot->pins = platform.accessMask;
 
-int RPIHAL_GPIO_bittopin(uint64_t bit) { return iGPIO_bittopin(bit); }
+    if (rp1)
+    {
+        for (int pin = 0; pin < RP1_NPINS; ++pin)
+        {
+            snapshot->ctrl[pin] = reg_read(gpio_base + (RP1_GPIO_CTRL(pin) / 4));
+            snapshot->pads[pin] = reg_read(gpio_base + (RP1_PADS_GPIO(pin) / 4));
+        }
 
+        snapshot->oe = reg_read(gpio_base + (RP1_RIO_OE / 4));
+    }
+    else
+    {
+        for (int i = 0; i < 6; ++i) { snapshot->fsel[i] = reg_read(gpio_base + (GPFSEL0 / 4) + i); }
 
+        if (platform.pullReg == iGPIO_pullReg_bcm2711)
+        {
+            for (int i = 0; i < 4; ++i) { snapshot->pull[i] = reg_read(gpio_base + (BCM2711_GPIO_PUP_PDN_CNTRL_REG0 / 4) + i); }
+        }
+    }
 
-#include <stdio.h>
-void RPIHAL_GPIO_dumpAltFuncReg(uint64_t pins)
-{
-    if (!gpio_base) RPIHAL_GPIO_init();
+    for (int bank = 0; bank < 2; ++bank)
+    {
+        if (regs.out[bank]) { snapshot->out |= ((uint64_t)reg_read(regs.out[bank]) << (32 * bank)); }
+    }
 
-    const RPIHAL_model_t hwModel = RPIHAL_getModel();
+    return 0;
+}
 
+int RPIHAL_GPIO_restore(const RPIHAL_GPIO_snapshot_t* snapshot)
+{
+    RPIHAL_GPIO_snapshot_t cur;
     RPIHAL_regptr_t addr;
-    int shift;
-    uint32_t regValue;
-    const uint64_t userPinsMask = iGPIO_getUserPinsMask();
 
-    printf("========================================\n");
-    printf("%s selected pins: 0x%04x'%04x'%04x'%04x\n", __func__, (int)((pins >> 48) & 0x0FFFFull), (int)((pins >> 32) & 0x0FFFFull),
-           (int)((pins >> 16) & 0x0FFFFull), (int)((pins >> 0) & 0x0FFFFull));
+    if (!snapshot || (RPIHAL_GPIO_snapshot(&cur) != 0)) { return -(__LINE__); }
 
-    for (int i = 0; i <= 5; ++i)
+    if (snapshot->model != cur.model)
     {
-        const uint64_t regPinsMask = (0x03FFull << (i * 10)); // 10 pins per register
+        LOG_ERR("snapshot of model %08x can't be restored on %08x", snapshot->model, cur.model);
+        return -(__LINE__);
+    }
 
-        addr = gpio_base + (GPFSEL0 / 4) + i;
-        regValue = BCM2835_reg_read(addr);
+    const uint64_t pins = snapshot->pins & cur.pins;
+    const uint64_t outPins = snapshotOutPins(snapshot) & pins;
 
-        if (pins & regPinsMask) printf("\033[96mGPFSEL%i: 0x%08x\033[39m\n", i, regValue);
 
-        int jMax = 9;
-        if (i == 5)
-        {
-            if (hwModel < RPIHAL_model_bcm2711) jMax = 3;
-            else jMax = 7;
-        }
 
-        for (int j = 0; j <= jMax; ++j)
-        {
-            const int pin = (i * 10) + j;
-            const uint64_t pinBit = RPIHAL_GPIO_BIT(pin);
+    // output levels, pins which are currently inputs are always written (their latch can't be read)
+
+    const uint64_t levelPins = outPins & ~(snapshotOutPins(&cur) & ~(cur.out ^ snapshot->out));
+
+    for (int bank = 0; bank < 2; ++bank)
+    {
+        const uint32_t mask = (uint32_t)(levelPins >> (32 * bank));
+        const uint32_t level = (uint32_t)(snapshot->out >> (32 * bank));
+
+        if (mask) { writeOutputs(bank, (level & mask), (~level & mask), 0); }
+    }
+
+
+
+    if (rp1)
+    {
+        for (int pin = 0; pin < RP1_NPINS; ++pin)
+        {
+            if (!(pins & RPIHAL_GPIO_BIT(pin))) { continue; }
+
+            if (cur.pads[pin] != snapshot->pads[pin]) { reg_write(gpio_base + (RP1_PADS_GPIO(pin) / 4), snapshot->pads[pin]); }
+        }
+
+        const uint32_t oeDiff = (cur.oe ^ snapshot->oe) & (uint32_t)pins;
+        if (oeDiff & snapshot->oe) { reg_write(gpio_base + ((RP1_RIO_OE + RP1_ALIAS_SET) / 4), oeDiff & snapshot->oe); }
+        if (oeDiff & ~snapshot->oe) { reg_write(gpio_base + ((RP1_RIO_OE + RP1_ALIAS_CLR) / 4), oeDiff & ~snapshot->oe); }
+
+        for (int pin = 0; pin < RP1_NPINS; ++pin)
+        {
+            if (!(pins & RPIHAL_GPIO_BIT(pin))) { continue; }
+
+            if (cur.ctrl[pin] != snapshot->ctrl[pin]) { reg_write(gpio_base + (RP1_GPIO_CTRL(pin) / 4), snapshot->ctrl[pin]); }
+        }
+    }
+    else
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            const uint32_t mask = fieldMask(pins, 10 * i, 10, 3);
+
+            if ((cur.fsel[i] ^ snapshot->fsel[i]) & mask)
+            {
+                addr = gpio_base + (GPFSEL0 / 4) + i;
+
+                spinLock(&fselLock[i]);
+                reg_write_bits(addr, snapshot->fsel[i], mask);
+                spinUnlock(&fselLock[i]);
+            }
+        }
+
+        if (platform.pullReg == iGPIO_pullReg_bcm2711)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                const uint32_t mask = fieldMask(pins, 16 * i, 16, 2);
+
+                if ((cur.pull[i] ^ snapshot->pull[i]) & mask)
+                {
+                    addr = gpio_base + (BCM2711_GPIO_PUP_PDN_CNTRL_REG0 / 4) + i;
+
+                    spinLock(&pupLock[i]);
+                    reg_write_bits(addr, snapshot->pull[i], mask);
+                    spinUnlock(&pupLock[i]);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+uint64_t RPIHAL_GPIO_diffSnapshot(const RPIHAL_GPIO_snapshot_t* a, const RPIHAL_GPIO_snapshot_t* b)
+{
+    const uint64_t pins = a->pins | b->pins;
+
+    if (a->model != b->model) { return pins; }
+
+    uint64_t diff = (a->pins ^ b->pins) | ((a->out ^ b->out) & snapshotOutPins(a));
+
+    for (int pin = 0; pin < 60; ++pin) // 6 GPFSEL registers
+    {
+        const uint64_t bit = RPIHAL_GPIO_BIT(pin);
+        if (!(pins & bit) || (diff & bit)) { continue; }
+
+        int differs;
+
+        if (RPIHAL_model_SoC_is_bcm2712(a->model))
+        {
+            differs = (pin >= RP1_NPINS) || (a->ctrl[pin] != b->ctrl[pin]) || (a->pads[pin] != b->pads[pin]) ||
+                      ((a->oe ^ b->oe) & (1u << pin));
+        }
+        else
+        {
+            const uint32_t fsel = fieldMask(bit, 10 * (pin / 10), 10, 3);
+            const uint32_t pull = fieldMask(bit, 16 * (pin / 16), 16, 2);
+
+            differs = ((a->fsel[pin / 10] ^ b->fsel[pin / 10]) & fsel) || ((a->pull[pin / 16] ^ b->pull[pin / 16]) & pull);
+        }
+
+        if (differs) { diff |= bit; }
+    }
+
+    return (diff & pins);
+}
+
+void RPIHAL_GPIO_defaultInitStruct(RPIHAL_GPIO_init_t* initStruct) { iGPIO_defaultInitStruct(initStruct); }
+
+int RPIHAL_GPIO_defaultInitStructPin(int pin, RPIHAL_GPIO_init_t* initStruct)
+{
+    const RPIHAL_model_t model = (gpio_base ? platform.model : RPIHAL_getModel());
+    return iGPIO_defaultInitStructPin(pin, initStruct, model);
+}
+
+int RPIHAL_GPIO_getPinHandle(RPIHAL_GPIO_pin_t* handle, int pin)
+{
+    int r = 0;
+
+    if (gpio_base && handle && iGPIO_checkPin(pin, &platform))
+    {
+        handle->set = regs.set[pin / 32];
+        handle->clr = regs.clr[pin / 32];
+        handle->lev = regs.lev[pin / 32];
+        handle->tgl = regs.tgl[pin / 32];
+        handle->bit = (1u << (pin % 32));
+    }
+    else { r = -(__LINE__); }
+
+    return r;
+}
+
+RPIHAL_regptr_t RPIHAL_GPIO_getMemBasePtr() { return gpio_base; }
+
+int RPIHAL_GPIO_isUsingGpiomem() { return usingGpiomem; }
+
+int RPIHAL_GPIO_bittopin(uint64_t bit) { return iGPIO_bittopin(bit); }
+
+
+
+#include <stdio.h>
+void RPIHAL_GPIO_dumpAltFuncReg(uint64_t pins)
+{
+    if (!gpio_base) RPIHAL_GPIO_init();
+
+    if (rp1)
+    {
+        LOG_ERR("%s not available on model %08x", __func__, platform.model);
+        return;
+    }
+
+    RPIHAL_regptr_t addr;
+    int shift;
+    uint32_t regValue;
+    const uint64_t userPinsMask = platform.userPinsMask;
+
+    printf("========================================\n");
+    printf("%s selected pins: 0x%04x'%04x'%04x'%04x\n", __func__, (int)((pins >> 48) & 0x0FFFFull), (int)((pins >> 32) & 0x0FFFFull),
+           (int)((pins >> 16) & 0x0FFFFull), (int)((pins >> 0) & 0x0FFFFull));
+
+    for (int i = 0; i <= 5; ++i)
+    {
+        const uint64_t regPinsMask = (0x03FFull << (i * 10)); // 10 pins per register
+
+        addr = gpio_base + (GPFSEL0 / 4) + i;
+        regValue = reg_read(addr);
+
+        if (pins & regPinsMask) printf("\033[96mGPFSEL%i: 0x%08x\033[39m\n", i, regValue);
+
+        int jMax = 9;
+        if (i == 5)
+        {
+            if (platform.soc < iGPIO_soc_bcm2711) jMax = 3;
+            else jMax = 7;
+        }
+
+        for (int j = 0; j <= jMax; ++j)
+        {
+            const int pin = (i * 10) + j;
+            const uint64_t pinBit = RPIHAL_GPIO_BIT(pin);
 
             shift = 3 * j; // shift = 3 * (pin % 10);
 
@@ -550,19 +1105,18 @@ void RPIHAL_GPIO_dumpAltFuncReg(uint64_t pins)
 
 void RPIHAL_GPIO_dumpPullUpDnReg(uint64_t pins)
 {
-    const RPIHAL_model_t hwModel = RPIHAL_getModel();
-    if (hwModel < RPIHAL_model_bcm2711)
+    if (!gpio_base) RPIHAL_GPIO_init();
+
+    if (platform.pullReg != iGPIO_pullReg_bcm2711)
     {
-        LOG_ERR("%s not available on model %08x", __func__, hwModel);
+        LOG_ERR("%s not available on model %08x", __func__, platform.model);
         return;
     }
 
-    if (!gpio_base) RPIHAL_GPIO_init();
-
     RPIHAL_regptr_t addr;
     int shift;
     uint32_t regValue;
-    const uint64_t userPinsMask = iGPIO_getUserPinsMask();
+    const uint64_t userPinsMask = platform.userPinsMask;
 
     printf("========================================\n");
     printf("%s selected pins: 0x%04x'%04x'%04x'%04x\n", __func__, (int)((pins >> 48) & 0x0FFFFull), (int)((pins >> 32) & 0x0FFFFull),
@@ -573,7 +1127,7 @@ void RPIHAL_GPIO_dumpPullUpDnReg(uint64_t pins)
         const uint64_t regPinsMask = (0x0FFFFull << (i * 16)); // 16 pins per register
 
         addr = gpio_base + (BCM2711_GPIO_PUP_PDN_CNTRL_REG0 / 4) + i;
-        regValue = BCM2835_reg_read(addr);
+        regValue = reg_read(addr);
 
         if (pins & regPinsMask) printf("\033[96mGPIO_PUP_PDN_CNTRL_REG%i: 0x%08x\033[39m\n", i, regValue);
 
@@ -623,90 +1177,169 @@ void RPIHAL_GPIO_dumpPullUpDnReg(uint64_t pins)
 
 
 /**
+ * Called with `initLock` held.
+ *
  * @return 0 on success
  */
-int initPin(int pin, const RPIHAL_GPIO_init_t* initStruct)
+int initBackend(int id, RPIHAL_model_t model)
 {
     int r = 0;
+    RPIHAL_regptr_t base = NULL;
 
-    const RPIHAL_model_t hwModel = RPIHAL_getModel();
+    if (gpio_base)
+    {
+        if (id == backendId) { return 0; }
 
-    RPIHAL_regptr_t addr;
-    int shift;
-    uint32_t value;
-    uint32_t mask;
+        LOG_ERR("GPIO is already initialised with backend 0x%x", backendId);
+        return -(__LINE__);
+    }
 
+    const int baseId = (id & ~RPIHAL_GPIO_BACKEND_TRACE);
+    if ((baseId != RPIHAL_GPIO_BACKEND_MMAP) && (baseId != RPIHAL_GPIO_BACKEND_ANON))
+    {
+        LOG_ERR("invalid backend 0x%x", id);
+        return -(__LINE__);
+    }
 
+    if (model == RPIHAL_model_unknown) { model = RPIHAL_getModel(); }
 
-    // fsel
+    const int isRp1 = RPIHAL_model_SoC_is_bcm2712(model);
+    const uint32_t periBase = iBCM_periBase(model);
+    off_t mmapoffs = periBase;
+    size_t mapSize = BCM_BLOCK_SIZE;
 
-    addr = gpio_base + (GPFSEL0 / 4) + (pin / 10);
-    shift = 3 * (pin % 10);
-    if (initStruct->mode == RPIHAL_GPIO_MODE_OUT) value = FSEL_OUT;
-    else if (initStruct->mode == RPIHAL_GPIO_MODE_AF) value = FSEL_AF_LUT[initStruct->altfunc];
-    else value = FSEL_IN;
-    value <<= shift;
-    mask = FSEL_MASK << shift;
-    BCM2835_reg_write_bits(addr, value, mask);
+    if (isRp1)
+    {
+        mmapoffs = (off_t)RP1_ADR_IO_BANK0; // truncated with a 32 bit off_t, checked before using /dev/mem
+        mapSize = RP1_BLOCK_SIZE;
+    }
+    else if (mmapoffs) { mmapoffs += PERI_ADR_OFFSET_GPIO; }
+    else
+    {
+        const char* dt = RPIHAL_dt_model();
+        if (!dt) { dt = RPIHAL_dt_compatible(); }
+        if (!dt) { dt = "UNKNOWN MODEL"; }
 
+        LOG_ERR("GPIO for %s is not yet supported", dt);
+
+        return -(__LINE__);
+    }
 
+    if (baseId == RPIHAL_GPIO_BACKEND_ANON)
+    {
+        usingGpiomem = 0;
 
-    // pull up/down
+        // zero initialised by the kernel
+        base = (RPIHAL_regptr_t)mmap(0, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 
-    if (RPIHAL_model_SoC_peripheral_is_bcm283x(hwModel))
+        if (base == MAP_FAILED)
+        {
+            LOG_ERR("failed to map anonymous memory (%i %s)", errno, strerror(errno));
+            r = -(__LINE__);
+        }
+    }
+    else
     {
-        // 1. Write to GPPUD to set the required control signal (i.e. Pull-up or Pull-Down or neither to remove the
-        //    current Pull-up/down)
-        addr = gpio_base + (BCM2835_GPPUD / 4);
-        if (initStruct->pull == RPIHAL_GPIO_PULL_UP) { value = BCM2835_PUD_UP; }
-        else if (initStruct->pull == RPIHAL_GPIO_PULL_DOWN) { value = BCM2835_PUD_DOWN; }
-        else { value = BCM2835_PUD_NONE; }
-        BCM2835_reg_write(addr, value);
+        int fd;
 
-        // 2. Wait 150 cycles – this provides the required set-up time for the control signal
-        BCM2835_wait_cycles(150);
+        fd = open((isRp1 ? "/dev/gpiomem0" : "/dev/gpiomem"), O_RDWR | O_SYNC | O_CLOEXEC); // no root access needed
 
-        // 3. Write to GPPUDCLK0/1 to clock the control signal into the GPIO pads you wish to modify – NOTE only the
-        //    pads which receive a clock will be modified, all others will retain their previous state.
-        addr = gpio_base + (BCM2835_GPPUDCLK0 / 4) + (pin / 32);
-        shift = (pin % 32);
-        value = 1u << shift;
-        BCM2835_reg_write(addr, value);
+        if (fd >= 0)
+        {
+            mmapoffs = 0;
+            usingGpiomem = 1;
+        }
+        else
+        {
+            usingGpiomem = 0;
 
-        // 4. Wait 150 cycles – this provides the required hold time for the control signal
-        BCM2835_wait_cycles(150);
+            if (isRp1 && (sizeof(off_t) < 8))
+            {
+                LOG_ERR("/dev/gpiomem0 not available and RP1 can't be mapped from /dev/mem with a 32 bit off_t");
+                r = -(__LINE__);
+            }
+            else
+            {
+                fd = open("/dev/mem", O_RDWR | O_SYNC | O_CLOEXEC); // root access needed
 
-        // 5. Write to GPPUD to remove the control signal
-        addr = gpio_base + (BCM2835_GPPUD / 4);
-        value = 0;
-        BCM2835_reg_write(addr, value);
+                if (fd < 0) r = -(__LINE__);
+            }
+        }
+
+        if (r == 0)
+        {
+            base = (RPIHAL_regptr_t)mmap(0, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, mmapoffs);
+
+            if (base == MAP_FAILED) { r = -(__LINE__); }
+        }
 
-        // 6. Write to GPPUDCLK0/1 to remove the clock
-        addr = gpio_base + (BCM2835_GPPUDCLK0 / 4) + (pin / 32);
-        BCM2835_reg_write(addr, 0);
+        if ((fd >= 0) && (close(fd) != 0)) { LOG_WRN("failed to close fd from mmap (%i %s)", errno, strerror(errno)); }
     }
-    else if (RPIHAL_model_SoC_peripheral_is_bcm2711(hwModel))
+
+    if (r == 0)
     {
-        addr = gpio_base + (BCM2711_GPIO_PUP_PDN_CNTRL_REG0 / 4) + (pin / 16);
-        shift = (pin % 16) * 2;
+        backendId = id;
+        rp1 = isRp1;
+        iGPIO_initPlatform(&platform, model, sysGpioLocked);
+        selectBackend();
+        initRegmap(base);
+
+        // the PADS block is not in the GPIO block, on RP1 it is
+        if (isRp1) { pads_base = NULL; }
+        else if (baseId == RPIHAL_GPIO_BACKEND_ANON) { pads_base = iBCM_mapAnon(BCM_BLOCK_SIZE); }
+        else { pads_base = iBCM_mapDevMem(periBase + PERI_ADR_OFFSET_PADS, BCM_BLOCK_SIZE); }
+
+        // not traced, the trace offset is relative to `gpio_base`
+        for (int bank = 0; bank < 2; ++bank)
+        {
+            if (regs.out[bank]) { outShadow[bank] = getTraceTarget()->read(regs.out[bank]); }
+        }
 
-        if (initStruct->pull == RPIHAL_GPIO_PULL_UP) { value = BCM2711_GPIO_PUP_PDN_UP; }
-        else if (initStruct->pull == RPIHAL_GPIO_PULL_DOWN) { value = BCM2711_GPIO_PUP_PDN_DOWN; }
-        else { value = BCM2711_GPIO_PUP_PDN_NONE; }
+        // published last, everything above is visible to a thread which sees `gpio_base` set
+        __atomic_store_n(&gpio_base, base, __ATOMIC_RELEASE);
+    }
 
-        value <<= shift;
-        mask = BCM2711_GPIO_PUP_PDN_MASK << shift;
-        BCM2835_reg_write_bits(addr, value, mask);
+    return r;
+}
+
+void initRegmap(RPIHAL_regptr_t base)
+{
+    memset(&regs, 0, sizeof(regs));
+
+    if (rp1)
+    {
+        regs.set[0] = base + ((RP1_RIO_OUT + RP1_ALIAS_SET) / 4);
+        regs.clr[0] = base + ((RP1_RIO_OUT + RP1_ALIAS_CLR) / 4);
+        regs.tgl[0] = base + ((RP1_RIO_OUT + RP1_ALIAS_XOR) / 4);
+        regs.out[0] = base + (RP1_RIO_OUT / 4);
+        regs.lev[0] = base + (RP1_RIO_SYNC_IN / 4);
     }
     else
     {
-        LOG_ERR("unknown SoC peripheral specification");
-        r = -(__LINE__);
+        for (int bank = 0; bank < 2; ++bank)
+        {
+            regs.set[bank] = base + (GPSET0 / 4) + bank;
+            regs.clr[bank] = base + (GPCLR0 / 4) + bank;
+            regs.out[bank] = base + (GPLEV0 / 4) + bank; // the level of an output pin is its output latch
+            regs.lev[bank] = base + (GPLEV0 / 4) + bank;
+        }
     }
+}
+
+/**
+ * @return 0 on success
+ */
+int initPin(int pin, const RPIHAL_GPIO_init_t* initStruct)
+{
+    int r = 0;
 
+    if (checkPads(initStruct) != 0) { return -(__LINE__); }
 
+    batch_t batch;
+    memset(&batch, 0, sizeof(batch));
 
-    // drive
+    batchAdd(&batch, pin, initStruct);
+    r = batchApply(&batch);
 
 
 
@@ -736,13 +1369,276 @@ int initPin(int pin, const RPIHAL_GPIO_init_t* initStruct)
     return r;
 }
 
+/**
+ * Validates the pad configuration, called before anything of the init is written.
+ *
+ * @return 0 if the pad configuration can be applied
+ */
+int checkPads(const RPIHAL_GPIO_init_t* initStruct)
+{
+    if (initStruct->drive == RPIHAL_GPIO_DRIVE_KEEP) { return 0; }
+
+    if ((initStruct->drive < RPIHAL_GPIO_DRIVE_2mA) || (initStruct->drive > RPIHAL_GPIO_DRIVE_16mA))
+    {
+        LOG_ERR("invalid drive strength %i", initStruct->drive);
+        return -(__LINE__);
+    }
+
+    if (!rp1 && !pads_base)
+    {
+        LOG_ERR("the pad control registers are not accessible (root needed)");
+        return -(__LINE__);
+    }
+
+    return 0;
+}
+
+/**
+ * Collects the register bits of one pin, nothing is written to the registers. The pad configuration has to be checked
+ * by `checkPads()`.
+ */
+void batchAdd(batch_t* batch, int pin, const RPIHAL_GPIO_init_t* initStruct)
+{
+    int idx;
+    int shift;
+    uint32_t value;
+
+
+
+    // fsel
+
+    idx = pin / 10;
+    shift = 3 * (pin % 10);
+    if (initStruct->mode == RPIHAL_GPIO_MODE_OUT)
+    {
+        value = FSEL_OUT;
+        batch->outPins |= RPIHAL_GPIO_BIT(pin);
+    }
+    else if (initStruct->mode == RPIHAL_GPIO_MODE_AF) value = FSEL_AF_LUT[initStruct->altfunc];
+    else value = FSEL_IN;
+    batch->fselValue[idx] = (batch->fselValue[idx] & ~(FSEL_MASK << shift)) | (value << shift);
+    batch->fselMask[idx] |= FSEL_MASK << shift;
+
+
+
+    // pull up/down
+
+    if (initStruct->pull == RPIHAL_GPIO_PULL_UP) { value = BCM2835_PUD_UP; }
+    else if (initStruct->pull == RPIHAL_GPIO_PULL_DOWN) { value = BCM2835_PUD_DOWN; }
+    else { value = BCM2835_PUD_NONE; }
+
+    for (size_t i = 0; i < (sizeof(batch->pudPins) / sizeof(batch->pudPins[0])); ++i)
+    {
+        if (i == value) { batch->pudPins[i] |= RPIHAL_GPIO_BIT(pin); }
+        else { batch->pudPins[i] &= ~RPIHAL_GPIO_BIT(pin); }
+    }
+
+    idx = pin / 16;
+    shift = (pin % 16) * 2;
+    if (initStruct->pull == RPIHAL_GPIO_PULL_UP) { value = BCM2711_GPIO_PUP_PDN_UP; }
+    else if (initStruct->pull == RPIHAL_GPIO_PULL_DOWN) { value = BCM2711_GPIO_PUP_PDN_DOWN; }
+    else { value = BCM2711_GPIO_PUP_PDN_NONE; }
+    batch->pupValue[idx] = (batch->pupValue[idx] & ~(BCM2711_GPIO_PUP_PDN_MASK << shift)) | (value << shift);
+    batch->pupMask[idx] |= BCM2711_GPIO_PUP_PDN_MASK << shift;
+
+
+
+    // RP1, inputs and outputs are driven by RIO
+
+    if (pin < RP1_NPINS)
+    {
+        batch->pins |= RPIHAL_GPIO_BIT(pin);
+        batch->funcsel[pin] = (uint8_t)((initStruct->mode == RPIHAL_GPIO_MODE_AF) ? initStruct->altfunc : RP1_FUNCSEL_SYS_RIO);
+
+        value = RP1_PADS_IE;
+        if (initStruct->pull == RPIHAL_GPIO_PULL_UP) { value |= RP1_PADS_PUE; }
+        else if (initStruct->pull == RPIHAL_GPIO_PULL_DOWN) { value |= RP1_PADS_PDE; }
+        batch->pads[pin] = (uint8_t)value;
+    }
+
+
+
+    // drive
+
+    if (initStruct->drive != RPIHAL_GPIO_DRIVE_KEEP)
+    {
+        const uint32_t drive = (uint32_t)(initStruct->drive - RPIHAL_GPIO_DRIVE_2mA); // field value
+
+        idx = ((pin <= 27) ? 0 : ((pin <= 45) ? 1 : 2));
+        value = drive;
+        if (initStruct->slew == RPIHAL_GPIO_SLEW_FAST) { value |= PADS_SLEW; }
+        if (initStruct->hysteresis) { value |= PADS_HYST; }
+        batch->padsValue[idx] = value;
+        batch->padsGroups |= (1u << idx);
+
+        if (pin < RP1_NPINS)
+        {
+            static const uint8_t rp1Drive[] = { 0, 1, 2, 2, 3, 3, 3, 3 }; // rounded up, max 12mA
+
+            value = ((uint32_t)rp1Drive[drive] << RP1_PADS_DRIVE_POS);
+            if (initStruct->slew == RPIHAL_GPIO_SLEW_FAST) { value |= RP1_PADS_SLEWFAST; }
+            if (initStruct->hysteresis) { value |= RP1_PADS_SCHMITT; }
+            batch->pads[pin] |= (uint8_t)value;
+            batch->padsMask[pin] = (RP1_PADS_DRIVE_MASK | RP1_PADS_SLEWFAST | RP1_PADS_SCHMITT);
+        }
+    }
+}
+
+/**
+ * Writes the collected bits, one read-modify-write per register. On BCM2835 all pins with the same pull setting are
+ * clocked in by one GPPUD sequence.
+ *
+ * @return 0 on success
+ */
+int batchApply(const batch_t* batch)
+{
+    int r = 0;
+
+    RPIHAL_regptr_t addr;
+    uint32_t value;
+
+    if (rp1) { return batchApplyRp1(batch); }
+
+
+
+    // fsel
+
+    for (int i = 0; i < 6; ++i)
+    {
+        if (batch->fselMask[i])
+        {
+            spinLock(&fselLock[i]);
+            reg_write_bits(gpio_base + (GPFSEL0 / 4) + i, batch->fselValue[i], batch->fselMask[i]);
+            spinUnlock(&fselLock[i]);
+        }
+    }
+
+    if (batch->outPins) { loadOutputs(batch->outPins); }
+
+
+
+    // pull up/down
+
+    if (platform.pullReg == iGPIO_pullReg_bcm2835)
+    {
+        for (uint32_t pud = 0; pud < (sizeof(batch->pudPins) / sizeof(batch->pudPins[0])); ++pud)
+        {
+            const uint64_t pins = batch->pudPins[pud];
+            if (!pins) { continue; }
+
+            // the control signal is shared by all pins, the whole sequence has to be exclusive
+            spinLock(&pudLock);
+
+            // 1. Write to GPPUD to set the required control signal (i.e. Pull-up or Pull-Down or neither to remove
+            //    the current Pull-up/down)
+            addr = gpio_base + (BCM2835_GPPUD / 4);
+            reg_write(addr, pud);
+
+            // 2. Wait 150 cycles – this provides the required set-up time for the control signal
+            BCM2835_wait_cycles(150);
+
+            // 3. Write to GPPUDCLK0/1 to clock the control signal into the GPIO pads you wish to modify – NOTE only
+            //    the pads which receive a clock will be modified, all others will retain their previous state.
+            for (int i = 0; i < 2; ++i)
+            {
+                value = (uint32_t)(pins >> (32 * i));
+                if (value) { reg_write(gpio_base + (BCM2835_GPPUDCLK0 / 4) + i, value); }
+            }
+
+            // 4. Wait 150 cycles – this provides the required hold time for the control signal
+            BCM2835_wait_cycles(150);
+
+            // 5. Write to GPPUD to remove the control signal
+            addr = gpio_base + (BCM2835_GPPUD / 4);
+            reg_write(addr, 0);
+
+            // 6. Write to GPPUDCLK0/1 to remove the clock
+            for (int i = 0; i < 2; ++i)
+            {
+                if ((uint32_t)(pins >> (32 * i))) { reg_write(gpio_base + (BCM2835_GPPUDCLK0 / 4) + i, 0); }
+            }
+
+            spinUnlock(&pudLock);
+        }
+    }
+    else if (platform.pullReg == iGPIO_pullReg_bcm2711)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            addr = gpio_base + (BCM2711_GPIO_PUP_PDN_CNTRL_REG0 / 4) + i;
+
+            if (batch->pupMask[i])
+            {
+                spinLock(&pupLock[i]);
+                reg_write_bits(addr, batch->pupValue[i], batch->pupMask[i]);
+                spinUnlock(&pupLock[i]);
+            }
+        }
+    }
+    else
+    {
+        LOG_ERR("unknown SoC peripheral specification");
+        r = -(__LINE__);
+    }
+
+
+
+    // drive
+
+    // whole register writes, not traced and plain memory with the anon backend (accessibility checked by `checkPads()`)
+    for (int i = 0; i < 3; ++i)
+    {
+        if (batch->padsGroups & (1u << i)) { getRegAccess()->write(pads_base + (PADS_GPIO_0_27 / 4) + i, BCM_REGISTER_PASSWORD | batch->padsValue[i]); }
+    }
+
+
+
+    return r;
+}
+
+/**
+ * The PADS and RIO bits are changed through the SET/CLR aliases. CTRL is written by read-modify-write, it's a register
+ * per pin and needs no lock. The output enable is set before the function is switched to RIO, so that the pin doesn't
+ * float in between.
+ *
+ * @return 0 on success
+ */
+int batchApplyRp1(const batch_t* batch)
+{
+    const uint32_t padsMask = RP1_PADS_PUE | RP1_PADS_PDE | RP1_PADS_IE | RP1_PADS_OD; // and `batch->padsMask`
+    const uint32_t pins = (uint32_t)batch->pins;
+    const uint32_t outPins = (uint32_t)batch->outPins;
+
+    for (int pin = 0; pin < RP1_NPINS; ++pin)
+    {
+        if (!(pins & (1u << pin))) { continue; }
+
+        reg_write(gpio_base + ((RP1_PADS_GPIO(pin) + RP1_ALIAS_CLR) / 4), (padsMask | batch->padsMask[pin]) & ~batch->pads[pin]);
+        reg_write(gpio_base + ((RP1_PADS_GPIO(pin) + RP1_ALIAS_SET) / 4), batch->pads[pin]);
+    }
+
+    if (outPins) { reg_write(gpio_base + ((RP1_RIO_OE + RP1_ALIAS_SET) / 4), outPins); }
+    if (pins & ~outPins) { reg_write(gpio_base + ((RP1_RIO_OE + RP1_ALIAS_CLR) / 4), pins & ~outPins); }
+
+    for (int pin = 0; pin < RP1_NPINS; ++pin)
+    {
+        if (!(pins & (1u << pin))) { continue; }
+
+        reg_write_bits(gpio_base + (RP1_GPIO_CTRL(pin) / 4), batch->funcsel[pin], RP1_CTRL_FUNCSEL_MASK);
+    }
+
+    if (outPins) { loadOutputs(outPins); }
+
+    return 0;
+}
+
 int readPin(int pin)
 {
     int r;
-    RPIHAL_regptr_t addr = gpio_base + (GPLEV0 / 4) + (pin / 32);
+    RPIHAL_regptr_t addr = regs.lev[pin / 32];
     const uint32_t bit = 1 << (pin % 32);
 
-    if (BCM2835_reg_read(addr) & bit) r = 1;
+    if (reg_read(addr) & bit) r = 1;
     else r = 0;
 
     return r;
@@ -750,13 +1646,95 @@ int readPin(int pin)
 
 void writePin(int pin, int state)
 {
-    RPIHAL_regptr_t addr = gpio_base + (pin / 32);
-    const uint32_t bit = 1 << (pin % 32);
+    const uint32_t bit = 1u << (pin % 32);
+
+    if (state) { writeOutputs(pin / 32, bit, 0, 0); }
+    else { writeOutputs(pin / 32, 0, bit, 0); }
+}
+
+/**
+ * Updates the shadow of the bank and writes GPSET/GPCLR. Set and clear bits are always written (the pins may have been
+ * changed by the fast path in between), toggled bits according to their new state. On RP1 the toggled bits are written
+ * to the XOR alias, a toggle is a single write.
+ *
+ * @param setBits Must not overlap with `clrBits`
+ */
+void writeOutputs(int bank, uint32_t setBits, uint32_t clrBits, uint32_t toggleBits)
+{
+    uint32_t old = __atomic_load_n(&outShadow[bank], __ATOMIC_RELAXED);
+    uint32_t level;
+
+    do
+    {
+        level = ((old | setBits) & ~clrBits) ^ toggleBits;
+    }
+    while (!__atomic_compare_exchange_n(&outShadow[bank], &old, level, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    if (regs.tgl[bank])
+    {
+        if (setBits) { reg_write(regs.set[bank], setBits); }
+        if (clrBits) { reg_write(regs.clr[bank], clrBits); }
+        if (toggleBits) { reg_write(regs.tgl[bank], toggleBits); }
+    }
+    else
+    {
+        const uint32_t set = (setBits | toggleBits) & level;
+        const uint32_t clr = (clrBits | toggleBits) & ~level;
+
+        if (set) { reg_write(regs.set[bank], set); }
+        if (clr) { reg_write(regs.clr[bank], clr); }
+    }
+}
 
-    if (state) addr += (GPSET0 / 4);
-    else addr += (GPCLR0 / 4);
+//! Loads the shadow of the pins from the output latch.
+void loadOutputs(uint64_t pins)
+{
+    for (int bank = 0; bank < 2; ++bank)
+    {
+        const uint32_t mask = (uint32_t)(pins >> (32 * bank));
+        if (!mask || !regs.out[bank]) { continue; }
+
+        const uint32_t level = reg_read(regs.out[bank]);
+        uint32_t old = __atomic_load_n(&outShadow[bank], __ATOMIC_RELAXED);
+
+        while (!__atomic_compare_exchange_n(&outShadow[bank], &old, (old & ~mask) | (level & mask), 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+    }
+}
+
+
+
+//! @return Bits of the pins which are outputs in the snapshot
+uint64_t snapshotOutPins(const RPIHAL_GPIO_snapshot_t* snapshot)
+{
+    uint64_t outPins = 0;
+
+    for (int pin = 0; pin < 60; ++pin) // 6 GPFSEL registers
+    {
+        const uint64_t bit = RPIHAL_GPIO_BIT(pin);
+        if (!(snapshot->pins & bit)) { continue; }
+
+        if (RPIHAL_model_SoC_is_bcm2712(snapshot->model))
+        {
+            if ((pin < RP1_NPINS) && ((snapshot->ctrl[pin] & RP1_CTRL_FUNCSEL_MASK) == RP1_FUNCSEL_SYS_RIO) && (snapshot->oe & (1u << pin))) { outPins |= bit; }
+        }
+        else if (((snapshot->fsel[pin / 10] >> (3 * (pin % 10))) & FSEL_MASK) == FSEL_OUT) { outPins |= bit; }
+    }
+
+    return outPins;
+}
+
+//! @return Mask of the `width` bit wide fields of the pins in `pins`, `firstPin` is the pin of field 0
+uint32_t fieldMask(uint64_t pins, int firstPin, int nPins, int width)
+{
+    uint32_t mask = 0;
+
+    for (int i = 0; i < nPins; ++i)
+    {
+        const int pin = firstPin + i;
+        if ((pin < 64) && (pins & RPIHAL_GPIO_BIT(pin))) { mask |= (((1u << width) - 1) << (width * i)); }
+    }
 
-    BCM2835_reg_write(addr, bit);
+    return mask;
 }
 
 
@@ -0,0 +1,306 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#define _GNU_SOURCE // pthread_setaffinity_np()
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal/platform_check.h"
+#include "internal/ring.h"
+#include "internal/util.h"
+#include "rpihal/gpio.h"
+#include "rpihal/gpiocapture.h"
+
+#include <pthread.h>
+#include <time.h>
+
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INF
+#define LOG_MODULE_NAME  GPIOCAPTURE
+#include "internal/log.h"
+
+
+
+#define SPIN_RATE_MIN (10000) // [Hz] busy wait the whole period at and above this rate
+#define SPIN_TIME     (60000) // [ns] busy wait time at lower rates
+
+
+
+typedef struct
+{
+    iRING_t ring;
+    pthread_t thread;
+    RPIHAL_GPIOCAPTURE_config_t config;
+    int running;
+
+    // statistics, written by the sampling thread only
+    uint64_t samples;
+    uint64_t late;
+    uint64_t maxLateness;
+} capture_t;
+
+static void* captureThread(void* arg);
+
+
+
+void RPIHAL_GPIOCAPTURE_defaultConfig(RPIHAL_GPIOCAPTURE_config_t* config)
+{
+    config->bits = 0x0FFFFFFF; // GPIO 0..27
+    config->rate = 1000000;
+    config->nSamples = 0;
+    config->capacity = 65536;
+    config->cpu = -1;
+    config->priority = 0;
+}
+
+int RPIHAL_GPIOCAPTURE_start(RPIHAL_GPIOCAPTURE_instance_t* inst, const RPIHAL_GPIOCAPTURE_config_t* config)
+{
+    inst->config = *config;
+    inst->capture = NULL;
+    inst->vcdLevel = 0;
+    inst->vcdStarted = 0;
+
+    // the sample period is integer nanoseconds, the ring capacity is rounded up to a power of two
+    if ((config->bits == 0) || (config->rate > 1000000000) || (config->capacity > ((SIZE_MAX / 2) / sizeof(RPIHAL_GPIOCAPTURE_change_t))))
+    {
+        LOG_ERR("invalid config (bits 0x%016llx, rate %u, capacity %zu)", (unsigned long long)(config->bits), config->rate, config->capacity);
+        return -(__LINE__);
+    }
+
+    capture_t* capture = NULL;
+
+    // the ring needs cache line alignment
+    if (posix_memalign((void**)(&capture), iRING_CACHE_LINE, sizeof(capture_t)) != 0) { return -(__LINE__); }
+    memset(capture, 0, sizeof(capture_t));
+
+    capture->config = *config;
+
+    if (iRING_init(&capture->ring, sizeof(RPIHAL_GPIOCAPTURE_change_t), config->capacity) != 0)
+    {
+        free(capture);
+        LOG_ERR("failed to allocate buffer of %zu changes", config->capacity);
+        return -(__LINE__);
+    }
+
+    // touch the buffer to have it faulted in before sampling
+    memset(capture->ring.buffer, 0, capture->ring.capacity * capture->ring.elementSize);
+
+    capture->running = 1;
+
+    const int err = pthread_create(&capture->thread, NULL, captureThread, capture);
+    if (err)
+    {
+        LOG_ERR("failed to create sampling thread (%s)", strerror(err));
+        iRING_destroy(&capture->ring);
+        free(capture);
+        return -(__LINE__);
+    }
+
+    inst->capture = capture;
+
+    LOG_INF("started capture of 0x%016llx at %uHz", (unsigned long long)config->bits, config->rate);
+
+    return 0;
+}
+
+size_t RPIHAL_GPIOCAPTURE_read(RPIHAL_GPIOCAPTURE_instance_t* inst, RPIHAL_GPIOCAPTURE_change_t* changes, size_t count)
+{
+    capture_t* capture = (capture_t*)(inst->capture);
+
+    if (!capture) { return 0; }
+
+    return iRING_pop(&capture->ring, changes, count);
+}
+
+int RPIHAL_GPIOCAPTURE_getStats(const RPIHAL_GPIOCAPTURE_instance_t* inst, RPIHAL_GPIOCAPTURE_stats_t* stats)
+{
+    const capture_t* capture = (const capture_t*)(inst->capture);
+
+    if (!capture) { return -(__LINE__); }
+
+    stats->samples = __atomic_load_n(&capture->samples, __ATOMIC_RELAXED);
+    stats->changes = __atomic_load_n(&capture->ring.pushed, __ATOMIC_RELAXED);
+    stats->overflows = __atomic_load_n(&capture->ring.overflows, __ATOMIC_RELAXED);
+    stats->late = __atomic_load_n(&capture->late, __ATOMIC_RELAXED);
+    stats->maxLateness = __atomic_load_n(&capture->maxLateness, __ATOMIC_RELAXED);
+    stats->running = __atomic_load_n(&capture->running, __ATOMIC_ACQUIRE);
+
+    return 0;
+}
+
+int RPIHAL_GPIOCAPTURE_stop(RPIHAL_GPIOCAPTURE_instance_t* inst)
+{
+    int r = 0;
+    capture_t* capture = (capture_t*)(inst->capture);
+
+    if (!capture) { return -(__LINE__); }
+
+    __atomic_store_n(&capture->running, 0, __ATOMIC_RELEASE);
+
+    const int err = pthread_join(capture->thread, NULL);
+    if (err)
+    {
+        LOG_ERR("failed to join the sampling thread (%s)", strerror(err));
+        r = -(__LINE__);
+    }
+
+    LOG_INF("stopped capture, %llu samples, %llu changes", (unsigned long long)capture->samples, (unsigned long long)capture->ring.pushed);
+
+    iRING_destroy(&capture->ring);
+    free(capture);
+    inst->capture = NULL;
+
+    return r;
+}
+
+int RPIHAL_GPIOCAPTURE_writeVcdHeader(RPIHAL_GPIOCAPTURE_instance_t* inst, FILE* fp)
+{
+    int r = 0;
+
+    if (fprintf(fp, "$timescale 1ns $end\n$scope module rpihal $end\n") < 0) { r = -(__LINE__); }
+
+    for (int pin = 0; (pin < 64) && (r == 0); ++pin)
+    {
+        // identifier codes are the printable ASCII characters starting at '!'
+        if (inst->config.bits & RPIHAL_GPIO_BIT(pin))
+        {
+            if (fprintf(fp, "$var wire 1 %c GPIO%i $end\n", (char)('!' + pin), pin) < 0) { r = -(__LINE__); }
+        }
+    }
+
+    if ((r == 0) && (fprintf(fp, "$upscope $end\n$enddefinitions $end\n") < 0)) { r = -(__LINE__); }
+
+    inst->vcdStarted = 0;
+
+    return r;
+}
+
+int RPIHAL_GPIOCAPTURE_writeVcd(RPIHAL_GPIOCAPTURE_instance_t* inst, FILE* fp, const RPIHAL_GPIOCAPTURE_change_t* changes, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        // the first change dumps all pins
+        const uint64_t changed = (inst->vcdStarted ? (changes[i].level ^ inst->vcdLevel) : inst->config.bits);
+
+        if (fprintf(fp, "#%llu\n", (unsigned long long)changes[i].timestamp) < 0) { return -(__LINE__); }
+
+        for (int pin = 0; pin < 64; ++pin)
+        {
+            const uint64_t bit = RPIHAL_GPIO_BIT(pin);
+
+            if (changed & bit)
+            {
+                if (fprintf(fp, "%c%c\n", ((changes[i].level & bit) ? '1' : '0'), (char)('!' + pin)) < 0) { return -(__LINE__); }
+            }
+        }
+
+        inst->vcdLevel = changes[i].level;
+        inst->vcdStarted = 1;
+    }
+
+    return 0;
+}
+
+
+
+void* captureThread(void* arg)
+{
+    capture_t* capture = (capture_t*)arg;
+    const RPIHAL_GPIOCAPTURE_config_t* config = &capture->config;
+
+    const int err = UTIL_setThreadSched(config->cpu, config->priority);
+    if (err) { LOG_WRN("failed to set CPU %i and priority %i of the sampling thread (%s)", config->cpu, config->priority, strerror(err)); }
+
+    const uint32_t rate = config->rate;
+    const uint64_t period = (rate ? (1000000000ull / rate) : 0);
+    const uint64_t periodRem = (rate ? (1000000000ull % rate) : 0); // distributed over the periods to avoid drift
+    const uint64_t spin = (rate >= SPIN_RATE_MIN ? period : SPIN_TIME);
+
+    RPIHAL_GPIOCAPTURE_change_t change;
+    uint64_t last = 0;
+    uint64_t samples = 0;
+    uint64_t frac = 0;
+
+    const uint64_t t0 = UTIL_time_ns(CLOCK_MONOTONIC);
+    uint64_t next = t0;
+
+    while (__atomic_load_n(&capture->running, __ATOMIC_ACQUIRE) && ((config->nSamples == 0) || (samples < config->nSamples)))
+    {
+        uint64_t t;
+
+        if (rate)
+        {
+            t = UTIL_waitUntil_ns(CLOCK_MONOTONIC, next, spin);
+
+            const uint64_t lateness = t - next;
+
+            if (lateness > period)
+            {
+                // skip the missed slots instead of sampling them in a burst
+                const uint64_t missed = lateness / period;
+
+                __atomic_store_n(&capture->late, capture->late + missed, __ATOMIC_RELAXED);
+                next += missed * period;
+            }
+
+            if (lateness > capture->maxLateness) { __atomic_store_n(&capture->maxLateness, lateness, __ATOMIC_RELAXED); }
+
+            next += period;
+            frac += periodRem;
+            if (frac >= rate)
+            {
+                frac -= rate;
+                ++next;
+            }
+        }
+        else { t = UTIL_time_ns(CLOCK_MONOTONIC); }
+
+        const uint64_t level = RPIHAL_GPIO_read64() & config->bits;
+
+        if ((samples == 0) || (level != last))
+        {
+            change.timestamp = (samples ? (t - t0) : 0);
+            change.level = level;
+            iRING_push(&capture->ring, &change, 1);
+
+            last = level;
+        }
+
+        ++samples;
+        __atomic_store_n(&capture->samples, samples, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&capture->running, 0, __ATOMIC_RELEASE);
+
+    return NULL;
+}
@@ -0,0 +1,779 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal/bcm.h"
+#include "internal/platform_check.h"
+#include "internal/util.h"
+#include "rpihal/gpio.h"
+#include "rpihal/gpiodma.h"
+#include "rpihal/pwm.h"
+#include "rpihal/rpihal.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INF
+#define LOG_MODULE_NAME  GPIODMA
+#include "internal/log.h"
+
+
+
+// DMA channel register offsets
+
+#define DMA_CHANNEL_SIZE (0x0100)
+#define DMA_CS           (0x0000)
+#define DMA_CONBLK_AD    (0x0004)
+#define DMA_DEBUG        (0x0020)
+#define DMA_ENABLE       (0x0FF0) // global, relative to channel 0
+
+#define DMA_CS_ACTIVE             (0x00000001u)
+#define DMA_CS_END                (0x00000002u)
+#define DMA_CS_INT                (0x00000004u)
+#define DMA_CS_PRIORITY(_x)       (((uint32_t)(_x) & 0x0F) << 16)
+#define DMA_CS_PANIC_PRIORITY(_x) (((uint32_t)(_x) & 0x0F) << 20)
+#define DMA_CS_WAIT_WRITES        (0x10000000u)
+#define DMA_CS_ABORT              (0x40000000u)
+#define DMA_CS_RESET              (0x80000000u)
+
+#define DMA_DEBUG_ERRORS (0x07) // read error, FIFO error, read last not set error
+
+#define DMA_TI_INTEN          (0x00000001u)
+#define DMA_TI_WAIT_RESP      (0x00000008u)
+#define DMA_TI_DEST_INC       (0x00000010u)
+#define DMA_TI_DEST_DREQ      (0x00000040u)
+#define DMA_TI_SRC_INC        (0x00000100u)
+#define DMA_TI_PERMAP(_x)     (((uint32_t)(_x) & 0x1F) << 16)
+#define DMA_TI_NO_WIDE_BURSTS (0x04000000u)
+
+#define DMA_PERMAP_PWM (5)
+
+#define DMA_CHANNEL_MAX (14)
+#define DMA_LEN_MAX     (0xFFFC) // lite channels have a 16bit transfer length
+
+#define BUS_GPSET0   (PERI_BUS_BASE + PERI_ADR_OFFSET_GPIO + 0x001C) // GPSET0, GPSET1, reserved, GPCLR0, GPCLR1
+#define BUS_PWM_FIF1 (PERI_BUS_BASE + PERI_ADR_OFFSET_PWM + 0x0018)
+
+#define GPIO_WORDS (5)
+
+#define PWM_CLOCK (10000000u) // [Hz] requested, the actual clock depends on the oscillator
+
+#define MONITOR_TIMEOUT (1000) // [poll intervals] to wait for the DMA to stop after an abort
+
+
+
+// VideoCore mailbox, see https://github.com/raspberrypi/firmware/wiki/Mailbox-property-interface
+
+#define IOCTL_MBOX_PROPERTY _IOWR(100, 0, char*)
+
+#define MBOX_TAG_MEM_ALLOC  (0x0003000C)
+#define MBOX_TAG_MEM_LOCK   (0x0003000D)
+#define MBOX_TAG_MEM_UNLOCK (0x0003000E)
+#define MBOX_TAG_MEM_FREE   (0x0003000F)
+
+#define MBOX_MEM_FLAG_DIRECT (0x04) // uncached 0xC0000000 alias, BCM2836 and later
+#define MBOX_MEM_FLAG_ZERO   (0x10)
+
+#define BUS_TO_PHYS(_adr) ((_adr) & ~0xC0000000u)
+
+
+
+// control block, 32 byte aligned
+typedef struct
+{
+    uint32_t ti;
+    uint32_t src;
+    uint32_t dst;
+    uint32_t len;
+    uint32_t stride;
+    uint32_t next;
+    uint32_t reserved[2];
+} cb_t;
+
+// position of a control block in the waveform
+typedef struct
+{
+    uint32_t step;
+    uint32_t pass;
+} cbPos_t;
+
+typedef struct
+{
+    int mbox; // -1 with the anon backend
+    uint32_t handle;
+    uint32_t bus;
+    void* virt;
+    size_t size;
+} mem_t;
+
+typedef struct
+{
+    RPIHAL_GPIODMA_config_t config;
+    RPIHAL_regptr_t dma_base; // channel 0
+    RPIHAL_regptr_t ch_base;
+    mem_t mem;
+
+    cb_t* cbs;
+    size_t nCbs;
+    size_t nPassCbs; // control blocks of one pass, the patch control blocks follow them
+    cbPos_t* pos;
+    double tick; // [ns]
+
+    pthread_t monitor;
+    pthread_t emulator; // anon backend only
+    int running;
+    int stop;
+
+    uint64_t pass;
+    size_t step;
+} dma_t;
+
+static int memAlloc(mem_t* mem, size_t size, int backend);
+static void memFree(mem_t* mem);
+static int mboxProperty(int fd, uint32_t tag, const uint32_t* in, size_t nIn, uint32_t* out);
+static uint64_t countCbs(const RPIHAL_GPIOWAVE_entry_t* wave, size_t count, double tick);
+static void build(dma_t* dma, const RPIHAL_GPIOWAVE_entry_t* wave, size_t count);
+static int setupPwm(dma_t* dma);
+static void start(dma_t* dma);
+static void abortDma(dma_t* dma);
+static void freeDma(dma_t* dma);
+static void* monitorThread(void* arg);
+static void* emulatorThread(void* arg);
+
+static inline uint32_t dma_read(const dma_t* dma, uint32_t offset) { return BCM_reg_read_mb(dma->ch_base + (offset / 4)); }
+static inline void dma_write(const dma_t* dma, uint32_t offset, uint32_t value) { BCM_reg_write_mb(dma->ch_base + (offset / 4), value); }
+static inline uint32_t busAddr(const dma_t* dma, const void* p) { return dma->mem.bus + (uint32_t)((const uint8_t*)p - (const uint8_t*)(dma->mem.virt)); }
+static inline void* virtAddr(const dma_t* dma, uint32_t bus) { return (uint8_t*)(dma->mem.virt) + (bus - dma->mem.bus); }
+
+
+
+void RPIHAL_GPIODMA_defaultConfig(RPIHAL_GPIODMA_config_t* config)
+{
+    config->backend = RPIHAL_GPIO_BACKEND_MMAP;
+    config->channel = 10;
+    config->tick = 1000;
+    config->loops = 1;
+    config->poll = 1000;
+    config->callback = NULL;
+    config->arg = NULL;
+}
+
+int RPIHAL_GPIODMA_play(RPIHAL_GPIODMA_instance_t* inst, const RPIHAL_GPIOWAVE_entry_t* wave, size_t count, const RPIHAL_GPIODMA_config_t* config)
+{
+    inst->dma = NULL;
+
+    if (!wave || (count == 0) || (count > UINT32_MAX))
+    {
+        LOG_ERR("empty waveform");
+        return -(__LINE__);
+    }
+
+    if ((config->channel < 0) || (config->channel > DMA_CHANNEL_MAX) || (config->tick == 0) || (config->poll == 0) ||
+        ((config->backend != RPIHAL_GPIO_BACKEND_MMAP) && (config->backend != RPIHAL_GPIO_BACKEND_ANON)))
+    {
+        LOG_ERR("invalid config");
+        return -(__LINE__);
+    }
+
+    dma_t* dma = (dma_t*)malloc(sizeof(dma_t));
+    if (!dma) { return -(__LINE__); }
+    memset(dma, 0, sizeof(dma_t));
+
+    dma->config = *config;
+    dma->mem.mbox = -1;
+
+    if (setupPwm(dma) != 0)
+    {
+        freeDma(dma);
+        return -(__LINE__);
+    }
+
+    if (config->backend == RPIHAL_GPIO_BACKEND_ANON) { dma->dma_base = iBCM_mapAnon(BCM_BLOCK_SIZE); }
+    else
+    {
+        const uint32_t periBase = iBCM_periBase(RPIHAL_getModel());
+        if (periBase) { dma->dma_base = iBCM_mapDevMem(periBase + PERI_ADR_OFFSET_DMA, BCM_BLOCK_SIZE); }
+    }
+
+    if (!dma->dma_base)
+    {
+        LOG_ERR("failed to map the DMA registers (%i %s)", errno, strerror(errno));
+        freeDma(dma);
+        return -(__LINE__);
+    }
+
+    dma->ch_base = dma->dma_base + ((config->channel * DMA_CHANNEL_SIZE) / 4);
+
+    // only one pass is built, the passes are counted by patch control blocks (see `build()`)
+    const uint64_t nPassCbs = countCbs(wave, count, dma->tick);
+    const uint64_t nPatches = ((config->loops > 1) ? (config->loops - 1) : 0);
+    const uint64_t nCbs = 1 + nPassCbs + nPatches; // +1 to prime the PWM FIFO
+    const uint64_t nWords = ((uint64_t)count * GPIO_WORDS) + 1 + nPatches;
+
+    if ((nCbs > (RPIHAL_GPIODMA_MEM_MAX / sizeof(cb_t))) || (((nCbs * sizeof(cb_t)) + (nWords * sizeof(uint32_t))) > RPIHAL_GPIODMA_MEM_MAX))
+    {
+        LOG_ERR("waveform needs more than %u bytes of DMA memory", (unsigned)RPIHAL_GPIODMA_MEM_MAX);
+        freeDma(dma);
+        return -(__LINE__);
+    }
+
+    dma->nCbs = (size_t)nCbs;
+    dma->nPassCbs = (size_t)nPassCbs;
+
+    const size_t size = (dma->nCbs * sizeof(cb_t)) + ((size_t)nWords * sizeof(uint32_t));
+
+    dma->pos = (cbPos_t*)malloc(dma->nCbs * sizeof(cbPos_t));
+
+    if (!dma->pos || (memAlloc(&dma->mem, size, config->backend) != 0))
+    {
+        LOG_ERR("failed to allocate %zu bytes of DMA memory", size);
+        freeDma(dma);
+        return -(__LINE__);
+    }
+
+    build(dma, wave, count);
+
+    dma->running = 1;
+    start(dma);
+
+    // the monitor thread joins the emulator
+    int err = 0;
+    if (config->backend == RPIHAL_GPIO_BACKEND_ANON) { err = pthread_create(&dma->emulator, NULL, emulatorThread, dma); }
+
+    if (err == 0)
+    {
+        err = pthread_create(&dma->monitor, NULL, monitorThread, dma);
+
+        if (err && (config->backend == RPIHAL_GPIO_BACKEND_ANON))
+        {
+            __atomic_store_n(&dma->stop, 1, __ATOMIC_RELEASE);
+            pthread_join(dma->emulator, NULL);
+        }
+    }
+
+    if (err)
+    {
+        LOG_ERR("failed to create thread (%s)", strerror(err));
+        abortDma(dma);
+        freeDma(dma);
+        return -(__LINE__);
+    }
+
+    LOG_INF("playing %zu entries with %zu control blocks, tick %.1fns", count, dma->nCbs, dma->tick);
+
+    inst->dma = dma;
+
+    return 0;
+}
+
+int RPIHAL_GPIODMA_getStatus(const RPIHAL_GPIODMA_instance_t* inst, RPIHAL_GPIODMA_status_t* status)
+{
+    const dma_t* dma = (const dma_t*)(inst->dma);
+
+    if (!dma) { return -(__LINE__); }
+
+    status->pass = __atomic_load_n(&dma->pass, __ATOMIC_RELAXED);
+    status->step = __atomic_load_n(&dma->step, __ATOMIC_RELAXED);
+    status->tick = (uint32_t)(dma->tick + 0.5);
+    status->running = __atomic_load_n(&dma->running, __ATOMIC_ACQUIRE);
+
+    return 0;
+}
+
+int RPIHAL_GPIODMA_wait(RPIHAL_GPIODMA_instance_t* inst)
+{
+    int r = 0;
+    dma_t* dma = (dma_t*)(inst->dma);
+
+    if (!dma) { return -(__LINE__); }
+
+    if (dma->config.loops == 0)
+    {
+        LOG_ERR("the playback is endless");
+        return -(__LINE__);
+    }
+
+    const int err = pthread_join(dma->monitor, NULL);
+    if (err)
+    {
+        LOG_ERR("failed to join the monitor thread (%s)", strerror(err));
+        r = -(__LINE__);
+    }
+
+    freeDma(dma);
+    inst->dma = NULL;
+
+    return r;
+}
+
+int RPIHAL_GPIODMA_stop(RPIHAL_GPIODMA_instance_t* inst)
+{
+    int r = 0;
+    dma_t* dma = (dma_t*)(inst->dma);
+
+    if (!dma) { return -(__LINE__); }
+
+    __atomic_store_n(&dma->stop, 1, __ATOMIC_RELEASE);
+    abortDma(dma);
+
+    const int err = pthread_join(dma->monitor, NULL);
+    if (err)
+    {
+        LOG_ERR("failed to join the monitor thread (%s)", strerror(err));
+        r = -(__LINE__);
+    }
+
+    freeDma(dma);
+    inst->dma = NULL;
+
+    return r;
+}
+
+
+
+int memAlloc(mem_t* mem, size_t size, int backend)
+{
+    const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    mem->size = ((size + pageSize - 1) / pageSize) * pageSize;
+
+    if (backend == RPIHAL_GPIO_BACKEND_ANON)
+    {
+        mem->virt = (void*)iBCM_mapAnon(mem->size);
+        mem->bus = 0xC0000000u; // as if allocated with MBOX_MEM_FLAG_DIRECT
+
+        return (mem->virt ? 0 : -(__LINE__));
+    }
+
+    mem->mbox = open("/dev/vcio", O_RDWR | O_CLOEXEC);
+    if (mem->mbox < 0)
+    {
+        LOG_ERR("failed to open /dev/vcio (%i %s)", errno, strerror(errno));
+        return -(__LINE__);
+    }
+
+    if (mem->size > UINT32_MAX)
+    {
+        LOG_ERR("size %zu is too large for the mailbox", mem->size);
+        return -(__LINE__);
+    }
+
+    const uint32_t alloc[] = { (uint32_t)(mem->size), (uint32_t)pageSize, MBOX_MEM_FLAG_DIRECT | MBOX_MEM_FLAG_ZERO };
+    if ((mboxProperty(mem->mbox, MBOX_TAG_MEM_ALLOC, alloc, 3, &mem->handle) != 0) || (mem->handle == 0)) { return -(__LINE__); }
+
+    if ((mboxProperty(mem->mbox, MBOX_TAG_MEM_LOCK, &mem->handle, 1, &mem->bus) != 0) || (mem->bus == 0)) { return -(__LINE__); }
+
+    mem->virt = (void*)iBCM_mapDevMem(BUS_TO_PHYS(mem->bus), mem->size);
+
+    return (mem->virt ? 0 : -(__LINE__));
+}
+
+void memFree(mem_t* mem)
+{
+    if (mem->virt) { munmap(mem->virt, mem->size); }
+
+    if (mem->mbox >= 0)
+    {
+        uint32_t status;
+
+        if (mem->bus) { mboxProperty(mem->mbox, MBOX_TAG_MEM_UNLOCK, &mem->handle, 1, &status); }
+        if (mem->handle) { mboxProperty(mem->mbox, MBOX_TAG_MEM_FREE, &mem->handle, 1, &status); }
+
+        close(mem->mbox);
+    }
+
+    mem->mbox = -1;
+    mem->handle = 0;
+    mem->bus = 0;
+    mem->virt = NULL;
+}
+
+//! @param out First word of the response
+int mboxProperty(int fd, uint32_t tag, const uint32_t* in, size_t nIn, uint32_t* out)
+{
+    uint32_t buffer[16] __attribute__((aligned(16)));
+    size_t i = 0;
+
+    buffer[i++] = 0; // size
+    buffer[i++] = 0; // process request
+    buffer[i++] = tag;
+    buffer[i++] = nIn * 4; // value buffer size, the used tags respond with at most as many words
+    buffer[i++] = nIn * 4; // request size
+    for (size_t k = 0; k < nIn; ++k) { buffer[i++] = in[k]; }
+    buffer[i++] = 0; // end tag
+    buffer[0] = i * 4;
+
+    if (ioctl(fd, IOCTL_MBOX_PROPERTY, buffer) < 0)
+    {
+        LOG_ERR("mailbox property 0x%08x failed (%i %s)", tag, errno, strerror(errno));
+        return -(__LINE__);
+    }
+
+    if (buffer[1] != 0x80000000u)
+    {
+        LOG_ERR("mailbox property 0x%08x failed (0x%08x)", tag, buffer[1]);
+        return -(__LINE__);
+    }
+
+    *out = buffer[5];
+
+    return 0;
+}
+
+//! @return Number of control blocks needed for one pass
+uint64_t countCbs(const RPIHAL_GPIOWAVE_entry_t* wave, size_t count, double tick)
+{
+    const uint64_t wordsMax = DMA_LEN_MAX / 4;
+
+    uint64_t n = 0;
+    uint64_t t = 0;
+    uint64_t words = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        t += wave[i].delay;
+
+        // rounded on the absolute timeline
+        const uint64_t w = (uint64_t)(((double)t / tick) + 0.5);
+        const uint64_t k = w - words;
+        words = w;
+
+        n += 1 + ((k + wordsMax - 1) / wordsMax);
+    }
+
+    return n;
+}
+
+void build(dma_t* dma, const RPIHAL_GPIOWAVE_entry_t* wave, size_t count)
+{
+    const uint64_t wordsMax = DMA_LEN_MAX / 4;
+    const size_t nPatches = dma->nCbs - 1 - dma->nPassCbs;
+
+    cb_t* cbs = (cb_t*)(dma->mem.virt);
+    uint32_t* data = (uint32_t*)(cbs + dma->nCbs);
+    uint32_t* zero = data + (count * GPIO_WORDS);
+    uint32_t* patchData = zero + 1;
+
+    dma->cbs = cbs;
+    *zero = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint64_t set = wave[i].set;
+        const uint64_t clr = wave[i].clr & ~set;
+        uint32_t* d = data + (i * GPIO_WORDS);
+
+        d[0] = (uint32_t)set;         // GPSET0
+        d[1] = (uint32_t)(set >> 32); // GPSET1
+        d[2] = 0;                     // reserved
+        d[3] = (uint32_t)clr;         // GPCLR0
+        d[4] = (uint32_t)(clr >> 32); // GPCLR1
+    }
+
+    const cb_t gpioCb = {
+        .ti = DMA_TI_WAIT_RESP | DMA_TI_SRC_INC | DMA_TI_DEST_INC | DMA_TI_NO_WIDE_BURSTS,
+        .dst = BUS_GPSET0,
+        .len = GPIO_WORDS * sizeof(uint32_t),
+    };
+
+    const cb_t delayCb = {
+        .ti = DMA_TI_WAIT_RESP | DMA_TI_DEST_DREQ | DMA_TI_PERMAP(DMA_PERMAP_PWM) | DMA_TI_NO_WIDE_BURSTS,
+        .src = busAddr(dma, zero),
+        .dst = BUS_PWM_FIF1,
+    };
+
+    size_t n = 0;
+
+    // fill the PWM FIFO, so that the following delays are paced from the start
+    cbs[n] = delayCb;
+    cbs[n].len = RPIHAL_PWM_FIFO_SIZE * sizeof(uint32_t);
+    dma->pos[n].step = 0;
+    dma->pos[n].pass = 0;
+    ++n;
+
+    uint64_t t = 0;
+    uint64_t words = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        cbs[n] = gpioCb;
+        cbs[n].src = busAddr(dma, data + (i * GPIO_WORDS));
+        dma->pos[n].step = (uint32_t)i;
+        dma->pos[n].pass = 0;
+        ++n;
+
+        t += wave[i].delay;
+
+        const uint64_t w = (uint64_t)(((double)t / dma->tick) + 0.5);
+        uint64_t k = w - words;
+        words = w;
+
+        while (k)
+        {
+            const uint64_t chunk = (k < wordsMax ? k : wordsMax);
+
+            cbs[n] = delayCb;
+            cbs[n].len = (uint32_t)(chunk * sizeof(uint32_t));
+            dma->pos[n].step = (uint32_t)i;
+            dma->pos[n].pass = 0;
+            ++n;
+
+            k -= chunk;
+        }
+    }
+
+    for (size_t i = 0; (i + 1) < n; ++i) { cbs[i].next = busAddr(dma, cbs + i + 1); }
+
+    cb_t* const last = cbs + n - 1;
+
+    if (dma->config.loops == 0) { last->next = busAddr(dma, cbs + 1); }
+    else if (nPatches == 0)
+    {
+        last->ti |= DMA_TI_INTEN;
+        last->next = 0;
+    }
+    else
+    {
+        // Patch k runs at the end of pass k. It writes the address of the next patch (0 after the last one) to the
+        // `next` field of the last control block of the pass and jumps back to the start of the pass. So the DMA
+        // counts the passes by itself and only the patches grow with the number of loops.
+        last->next = busAddr(dma, cbs + n);
+
+        for (size_t k = 0; k < nPatches; ++k)
+        {
+            patchData[k] = (((k + 1) < nPatches) ? busAddr(dma, cbs + n + 1) : 0);
+
+            cbs[n].ti = DMA_TI_WAIT_RESP | DMA_TI_NO_WIDE_BURSTS;
+            cbs[n].src = busAddr(dma, patchData + k);
+            cbs[n].dst = busAddr(dma, &(last->next));
+            cbs[n].len = sizeof(uint32_t);
+            cbs[n].stride = 0;
+            cbs[n].next = busAddr(dma, cbs + 1);
+            cbs[n].reserved[0] = 0;
+            cbs[n].reserved[1] = 0;
+            dma->pos[n].step = (uint32_t)(count - 1);
+            dma->pos[n].pass = (uint32_t)k;
+            ++n;
+        }
+    }
+}
+
+int setupPwm(dma_t* dma)
+{
+    int err = 0;
+    uint32_t clock;
+
+    if (RPIHAL_PWM_setClock(PWM_CLOCK, &clock) != 0)
+    {
+        LOG_ERR("failed to set the PWM clock, is the PWM module initialised?");
+        return -(__LINE__);
+    }
+
+    uint32_t range = (uint32_t)((((uint64_t)(dma->config.tick) * clock) + 500000000ull) / 1000000000ull);
+    if (range < 2) { range = 2; }
+
+    dma->tick = ((double)range * 1e9) / (double)clock;
+
+    // the data is never output, the pin stays muxed to GPIO
+    RPIHAL_PWM_chConfig_t config;
+    RPIHAL_PWM_defaultChConfig(&config);
+    config.mode = RPIHAL_PWM_MODE_MS;
+    config.range = range;
+    config.useFifo = 1;
+
+    err |= RPIHAL_PWM_configChannel(0, &config);
+    err |= RPIHAL_PWM_clearFifo();
+    err |= RPIHAL_PWM_setDma(1);
+    err |= RPIHAL_PWM_enable(0, 1);
+
+    return (err ? -(__LINE__) : 0);
+}
+
+void start(dma_t* dma)
+{
+    RPIHAL_regptr_t enable = dma->dma_base + (DMA_ENABLE / 4);
+    BCM_reg_write_mb(enable, BCM_reg_read_mb(enable) | (1u << dma->config.channel));
+
+    dma_write(dma, DMA_CS, DMA_CS_RESET);
+    usleep(10);
+
+    dma_write(dma, DMA_CS, DMA_CS_INT | DMA_CS_END);
+    dma_write(dma, DMA_DEBUG, DMA_DEBUG_ERRORS);
+    dma_write(dma, DMA_CONBLK_AD, busAddr(dma, dma->cbs));
+    dma_write(dma, DMA_CS, DMA_CS_WAIT_WRITES | DMA_CS_PANIC_PRIORITY(15) | DMA_CS_PRIORITY(15) | DMA_CS_ACTIVE);
+}
+
+void abortDma(dma_t* dma)
+{
+    // pause, abort the current control block and reset the channel
+    dma_write(dma, DMA_CS, 0);
+    dma_write(dma, DMA_CS, DMA_CS_ABORT);
+    usleep(100);
+    dma_write(dma, DMA_CS, DMA_CS_RESET);
+}
+
+void freeDma(dma_t* dma)
+{
+    RPIHAL_PWM_setDma(0);
+    RPIHAL_PWM_enable(0, 0);
+
+    if (dma->dma_base) { munmap((void*)(dma->dma_base), BCM_BLOCK_SIZE); }
+
+    memFree(&dma->mem);
+    free(dma->pos);
+    free(dma);
+}
+
+void* monitorThread(void* arg)
+{
+    dma_t* dma = (dma_t*)arg;
+    const RPIHAL_GPIODMA_config_t* config = &dma->config;
+
+    const struct timespec ts = {
+        .tv_sec = (time_t)(config->poll / 1000000),
+        .tv_nsec = (long)(config->poll % 1000000) * 1000,
+    };
+
+    const uint32_t cbBus = busAddr(dma, dma->cbs);
+    uint64_t pass = 0;
+    size_t step = 0;
+    int done = 0;
+
+    while (!done && !__atomic_load_n(&dma->stop, __ATOMIC_ACQUIRE))
+    {
+        nanosleep(&ts, NULL);
+
+        const uint32_t ad = dma_read(dma, DMA_CONBLK_AD);
+        const uint32_t cs = dma_read(dma, DMA_CS);
+        uint64_t p = pass;
+
+        if (ad)
+        {
+            const size_t i = (ad - cbBus) / sizeof(cb_t);
+
+            if (i < dma->nCbs)
+            {
+                if (config->loops == 0)
+                {
+                    if (dma->pos[i].step < step) { ++p; } // wrapped
+                }
+                else if (i > dma->nPassCbs) { p = dma->pos[i].pass; } // patch
+                else
+                {
+                    // the pending patch tells the pass, there is none in the last pass
+                    const uint32_t next = dma->cbs[dma->nPassCbs].next;
+                    const size_t k = (next ? ((next - cbBus) / sizeof(cb_t)) : 0);
+
+                    p = ((k > dma->nPassCbs) && (k < dma->nCbs) ? dma->pos[k].pass : (config->loops - 1));
+                }
+
+                step = dma->pos[i].step;
+                __atomic_store_n(&dma->step, step, __ATOMIC_RELAXED);
+            }
+        }
+        else if (!(cs & DMA_CS_ACTIVE))
+        {
+            done = 1;
+            p = config->loops;
+        }
+
+        if (p != pass)
+        {
+            pass = p;
+            __atomic_store_n(&dma->pass, pass, __ATOMIC_RELAXED);
+
+            if (config->callback && !done) { config->callback(config->arg, pass, 0); }
+        }
+    }
+
+    if (config->backend == RPIHAL_GPIO_BACKEND_ANON)
+    {
+        __atomic_store_n(&dma->stop, 1, __ATOMIC_RELEASE);
+        pthread_join(dma->emulator, NULL);
+    }
+
+    if (config->backend == RPIHAL_GPIO_BACKEND_MMAP)
+    {
+        const uint32_t debug = dma_read(dma, DMA_DEBUG);
+        if (debug & DMA_DEBUG_ERRORS) { LOG_ERR("DMA error 0x%02x", debug & DMA_DEBUG_ERRORS); }
+    }
+
+    __atomic_store_n(&dma->running, 0, __ATOMIC_RELEASE);
+
+    if (config->callback) { config->callback(config->arg, pass, 1); }
+
+    return NULL;
+}
+
+// Executes the control blocks like the DMA engine would, the delays are waited for in real time.
+void* emulatorThread(void* arg)
+{
+    dma_t* dma = (dma_t*)arg;
+
+    const uint64_t t0 = UTIL_time_ns(CLOCK_MONOTONIC);
+    double t = 0;
+
+    uint32_t ad = dma_read(dma, DMA_CONBLK_AD);
+
+    while (ad && !__atomic_load_n(&dma->stop, __ATOMIC_ACQUIRE))
+    {
+        const cb_t* cb = (const cb_t*)virtAddr(dma, ad);
+
+        if (cb->dst == BUS_GPSET0)
+        {
+            const uint32_t* d = (const uint32_t*)virtAddr(dma, cb->src);
+            const uint64_t set = ((uint64_t)d[1] << 32) | d[0];
+            const uint64_t clr = ((uint64_t)d[4] << 32) | d[3];
+
+            RPIHAL_GPIO_write64(set, set);
+            RPIHAL_GPIO_write64(clr, 0);
+        }
+        else if (cb->dst == BUS_PWM_FIF1)
+        {
+            t += (double)(cb->len / sizeof(uint32_t)) * dma->tick;
+            UTIL_waitUntil_ns(CLOCK_MONOTONIC, t0 + (uint64_t)t, 0);
+        }
+        else { memcpy(virtAddr(dma, cb->dst), virtAddr(dma, cb->src), cb->len); } // patch
+
+        ad = cb->next;
+        dma_write(dma, DMA_CONBLK_AD, ad);
+    }
+
+    dma_write(dma, DMA_CS, (dma_read(dma, DMA_CS) & ~DMA_CS_ACTIVE) | DMA_CS_END);
+
+    return NULL;
+}
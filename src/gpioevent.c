@@ -0,0 +1,449 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal/platform_check.h"
+#include "internal/ring.h"
+#include "rpihal/gpio.h"
+#include "rpihal/gpioevent.h"
+
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INF
+#define LOG_MODULE_NAME  GPIOEVENT
+#include "internal/log.h"
+
+
+
+typedef struct
+{
+    iRING_t ring;
+    pthread_t thread;
+    int fd;
+    int stopfd;
+    int notifyfd; // signaled when the ring becomes non empty
+    const char* dev;
+    uint64_t kernelOverflows;
+    int error;
+} reader_t;
+
+static int readEvents(int fd, const char* dev, RPIHAL_GPIOEVENT_event_t* events, size_t count);
+static void* readerThread(void* arg);
+
+
+
+int RPIHAL_GPIOEVENT_open(RPIHAL_GPIOEVENT_instance_t* inst, const char* dev, uint64_t bits, int edge, uint32_t config)
+{
+    inst->dev[0] = 0;
+    inst->fd = -1;
+    inst->bits = 0;
+    inst->reader = NULL;
+
+    errno = 0;
+
+    if (!bits || !(edge & RPIHAL_GPIO_EDGE_BOTH))
+    {
+        LOG_ERR("no pins or edges specified");
+        return -(__LINE__);
+    }
+
+    struct gpio_v2_line_request req;
+    memset(&req, 0, sizeof(req));
+
+    for (int pin = 0; pin < 64; ++pin)
+    {
+        if (bits & RPIHAL_GPIO_BIT(pin))
+        {
+            req.offsets[req.num_lines] = (uint32_t)pin;
+            ++req.num_lines;
+        }
+    }
+
+    strncpy(req.consumer, "rpihal", GPIO_MAX_NAME_SIZE - 1);
+
+    req.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+
+    if (edge & RPIHAL_GPIO_EDGE_RISING) { req.config.flags |= GPIO_V2_LINE_FLAG_EDGE_RISING; }
+    if (edge & RPIHAL_GPIO_EDGE_FALLING) { req.config.flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING; }
+
+    if (config & RPIHAL_GPIOEVENT_CFG_PULL_UP) { req.config.flags |= GPIO_V2_LINE_FLAG_BIAS_PULL_UP; }
+    else if (config & RPIHAL_GPIOEVENT_CFG_PULL_DOWN) { req.config.flags |= GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN; }
+    else if (config & RPIHAL_GPIOEVENT_CFG_PULL_NONE) { req.config.flags |= GPIO_V2_LINE_FLAG_BIAS_DISABLED; }
+    // else the bias is not changed
+
+    if (config & RPIHAL_GPIOEVENT_CFG_REALTIME) { req.config.flags |= GPIO_V2_LINE_FLAG_EVENT_CLOCK_REALTIME; }
+
+    const int chipfd = open(dev, O_RDWR | O_CLOEXEC);
+    if (chipfd < 0)
+    {
+        LOG_ERR("failed to open \"%s\" (%s)", dev, strerror(errno));
+        return -(__LINE__);
+    }
+
+    const int ret = ioctl(chipfd, GPIO_V2_GET_LINE_IOCTL, &req);
+    const int reqErrno = errno;
+
+    if (close(chipfd) != 0) { LOG_WRN("failed to close \"%s\" (%s)", dev, strerror(errno)); }
+
+    if (ret < 0)
+    {
+        errno = reqErrno;
+        LOG_ERR("failed to request pins 0x%016llx on \"%s\" (%s)", (unsigned long long)bits, dev, strerror(errno));
+        return -(__LINE__);
+    }
+
+    LOG_INF("opened \"%s\" pins: 0x%016llx, edge: %i", dev, (unsigned long long)bits, edge);
+
+    strncpy(inst->dev, dev, RPIHAL_GPIOEVENT_INSTANCE_DEV_SIZE);
+    inst->dev[RPIHAL_GPIOEVENT_INSTANCE_DEV_SIZE - 1] = 0;
+
+    inst->fd = req.fd;
+    inst->bits = bits;
+
+    return 0;
+}
+
+int RPIHAL_GPIOEVENT_wait(const RPIHAL_GPIOEVENT_instance_t* inst, int timeout_ms)
+{
+    struct pollfd pfd;
+
+    pfd.fd = inst->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int ret;
+
+    do
+    {
+        errno = 0;
+        ret = poll(&pfd, 1, timeout_ms);
+    }
+    while ((ret < 0) && (errno == EINTR));
+
+    if (ret < 0)
+    {
+        LOG_ERR("failed to poll \"%s\" (%s)", inst->dev, strerror(errno));
+        return -(__LINE__);
+    }
+
+    return ((ret > 0) ? 1 : 0);
+}
+
+int RPIHAL_GPIOEVENT_read(const RPIHAL_GPIOEVENT_instance_t* inst, RPIHAL_GPIOEVENT_event_t* events, size_t count)
+{
+    return readEvents(inst->fd, inst->dev, events, count);
+}
+
+int RPIHAL_GPIOEVENT_startReader(RPIHAL_GPIOEVENT_instance_t* inst, size_t capacity)
+{
+    if (inst->fd < 0)
+    {
+        LOG_ERR("not open");
+        return -(__LINE__);
+    }
+
+    if (inst->reader)
+    {
+        LOG_ERR("reader of \"%s\" is already running", inst->dev);
+        return -(__LINE__);
+    }
+
+    // the ring capacity is rounded up to a power of two
+    if (capacity > ((SIZE_MAX / 2) / sizeof(RPIHAL_GPIOEVENT_event_t)))
+    {
+        LOG_ERR("invalid capacity %zu", capacity);
+        return -(__LINE__);
+    }
+
+    reader_t* reader = NULL;
+
+    // the ring needs cache line alignment
+    if (posix_memalign((void**)(&reader), iRING_CACHE_LINE, sizeof(reader_t)) != 0) { return -(__LINE__); }
+    memset(reader, 0, sizeof(reader_t));
+
+    reader->fd = inst->fd;
+    reader->dev = inst->dev;
+
+    if (iRING_init(&reader->ring, sizeof(RPIHAL_GPIOEVENT_event_t), capacity) != 0)
+    {
+        free(reader);
+        LOG_ERR("failed to allocate ring of %zu events", capacity);
+        return -(__LINE__);
+    }
+
+    errno = 0;
+
+    reader->stopfd = eventfd(0, EFD_CLOEXEC);
+    if (reader->stopfd < 0)
+    {
+        LOG_ERR("failed to create eventfd (%s)", strerror(errno));
+        iRING_destroy(&reader->ring);
+        free(reader);
+        return -(__LINE__);
+    }
+
+    reader->notifyfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (reader->notifyfd < 0)
+    {
+        LOG_ERR("failed to create eventfd (%s)", strerror(errno));
+        close(reader->stopfd);
+        iRING_destroy(&reader->ring);
+        free(reader);
+        return -(__LINE__);
+    }
+
+    const int err = pthread_create(&reader->thread, NULL, readerThread, reader);
+    if (err)
+    {
+        LOG_ERR("failed to create reader thread (%s)", strerror(err));
+        close(reader->notifyfd);
+        close(reader->stopfd);
+        iRING_destroy(&reader->ring);
+        free(reader);
+        return -(__LINE__);
+    }
+
+    inst->reader = reader;
+
+    return 0;
+}
+
+int RPIHAL_GPIOEVENT_stopReader(RPIHAL_GPIOEVENT_instance_t* inst)
+{
+    int r = 0;
+    reader_t* reader = (reader_t*)(inst->reader);
+
+    if (!reader) { return -(__LINE__); }
+
+    const uint64_t value = 1;
+    if (write(reader->stopfd, &value, sizeof(value)) != sizeof(value))
+    {
+        LOG_ERR("failed to stop the reader of \"%s\" (%s)", inst->dev, strerror(errno));
+        return -(__LINE__);
+    }
+
+    const int err = pthread_join(reader->thread, NULL);
+    if (err)
+    {
+        LOG_ERR("failed to join the reader of \"%s\" (%s)", inst->dev, strerror(err));
+        r = -(__LINE__);
+    }
+
+    close(reader->notifyfd);
+    close(reader->stopfd);
+    iRING_destroy(&reader->ring);
+    free(reader);
+    inst->reader = NULL;
+
+    return r;
+}
+
+size_t RPIHAL_GPIOEVENT_drain(RPIHAL_GPIOEVENT_instance_t* inst, RPIHAL_GPIOEVENT_event_t* events, size_t count)
+{
+    reader_t* reader = (reader_t*)(inst->reader);
+
+    if (!reader) { return 0; }
+
+    // orders the `tail` store of the previous drain before the `head` load, pairs with the fence in `readerThread()`
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    return iRING_pop(&reader->ring, events, count);
+}
+
+int RPIHAL_GPIOEVENT_getReaderFd(const RPIHAL_GPIOEVENT_instance_t* inst)
+{
+    const reader_t* reader = (const reader_t*)(inst->reader);
+
+    if (!reader) { return -(__LINE__); }
+
+    return reader->notifyfd;
+}
+
+int RPIHAL_GPIOEVENT_getStats(const RPIHAL_GPIOEVENT_instance_t* inst, RPIHAL_GPIOEVENT_stats_t* stats)
+{
+    const reader_t* reader = (const reader_t*)(inst->reader);
+
+    if (!reader) { return -(__LINE__); }
+
+    stats->events = __atomic_load_n(&reader->ring.pushed, __ATOMIC_RELAXED);
+    stats->overflows = __atomic_load_n(&reader->ring.overflows, __ATOMIC_RELAXED);
+    stats->kernelOverflows = __atomic_load_n(&reader->kernelOverflows, __ATOMIC_RELAXED);
+    stats->highWater = __atomic_load_n(&reader->ring.highWater, __ATOMIC_RELAXED);
+    stats->capacity = reader->ring.capacity;
+    stats->error = __atomic_load_n(&reader->error, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+int RPIHAL_GPIOEVENT_close(RPIHAL_GPIOEVENT_instance_t* inst)
+{
+    if (inst->reader) { RPIHAL_GPIOEVENT_stopReader(inst); }
+
+    errno = 0;
+
+    if (inst->fd >= 0)
+    {
+        int err;
+
+        err = close(inst->fd);
+        if (err)
+        {
+            LOG_ERR("failed to close \"%s\" (%s)", inst->dev, strerror(errno));
+            return -(__LINE__);
+        }
+        else
+        {
+            LOG_INF("closed \"%s\"", inst->dev);
+            inst->dev[0] = 0;
+            inst->fd = -1;
+            inst->bits = 0;
+        }
+    }
+    else { LOG_WRN("not open"); }
+
+    return 0;
+}
+
+
+
+int readEvents(int fd, const char* dev, RPIHAL_GPIOEVENT_event_t* events, size_t count)
+{
+    struct gpio_v2_line_event buffer[RPIHAL_GPIOEVENT_READ_MAX];
+
+    if (count > RPIHAL_GPIOEVENT_READ_MAX) { count = RPIHAL_GPIOEVENT_READ_MAX; }
+    if (count == 0) { return 0; }
+
+    errno = 0;
+
+    const ssize_t ret = read(fd, buffer, count * sizeof(buffer[0]));
+
+    if (ret < 0)
+    {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) { return 0; }
+
+        LOG_ERR("failed to read events from \"%s\" (%s)", dev, strerror(errno));
+        return -(__LINE__);
+    }
+
+    // the kernel only returns whole events
+    const int n = (int)((size_t)ret / sizeof(buffer[0]));
+
+    for (int i = 0; i < n; ++i)
+    {
+        events[i].timestamp = buffer[i].timestamp_ns;
+        events[i].pin = (int)buffer[i].offset;
+        events[i].edge = ((buffer[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE) ? RPIHAL_GPIO_EDGE_RISING : RPIHAL_GPIO_EDGE_FALLING);
+        events[i].seqno = buffer[i].seqno;
+        events[i].lineSeqno = buffer[i].line_seqno;
+    }
+
+    return n;
+}
+
+void* readerThread(void* arg)
+{
+    reader_t* reader = (reader_t*)arg;
+
+    RPIHAL_GPIOEVENT_event_t events[RPIHAL_GPIOEVENT_READ_MAX];
+    uint32_t lastSeqno = 0; // the kernel starts counting at 1
+
+    struct pollfd pfd[2];
+    pfd[0].fd = reader->fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = reader->stopfd;
+    pfd[1].events = POLLIN;
+
+    while (1)
+    {
+        pfd[0].revents = 0;
+        pfd[1].revents = 0;
+
+        const int ret = poll(pfd, 2, -1);
+
+        if ((ret < 0) && (errno != EINTR))
+        {
+            LOG_ERR("failed to poll \"%s\" (%s)", reader->dev, strerror(errno));
+            __atomic_store_n(&reader->error, 1, __ATOMIC_RELAXED);
+            break;
+        }
+
+        if (pfd[1].revents) { break; }
+
+        if (pfd[0].revents & POLLIN)
+        {
+            const int n = readEvents(reader->fd, reader->dev, events, RPIHAL_GPIOEVENT_READ_MAX);
+
+            if (n < 0)
+            {
+                __atomic_store_n(&reader->error, 1, __ATOMIC_RELAXED);
+                break;
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                const uint32_t gap = events[i].seqno - lastSeqno - 1;
+                if (gap) { __atomic_store_n(&reader->kernelOverflows, reader->kernelOverflows + gap, __ATOMIC_RELAXED); }
+                lastSeqno = events[i].seqno;
+            }
+
+            const size_t head = reader->ring.head;
+            const size_t pushed = iRING_push(&reader->ring, events, (size_t)n);
+
+            // Signal only if the ring was empty, the consumer drains until it's empty after each wake-up. If the
+            // consumer has emptied the ring meanwhile, either it sees the new head or this sees its tail (fences).
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            const size_t tail = __atomic_load_n(&reader->ring.tail, __ATOMIC_ACQUIRE);
+
+            if (pushed && ((tail - head) <= pushed))
+            {
+                const uint64_t one = 1;
+                if (write(reader->notifyfd, &one, sizeof(one)) != sizeof(one)) { LOG_WRN("failed to signal the eventfd"); }
+            }
+        }
+        else if (pfd[0].revents & (POLLERR | POLLHUP | POLLNVAL))
+        {
+            LOG_ERR("\"%s\" has been closed", reader->dev);
+            __atomic_store_n(&reader->error, 1, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,230 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#define _GNU_SOURCE // pthread_setaffinity_np()
+
+#include <errno.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal/platform_check.h"
+#include "internal/util.h"
+#include "rpihal/gpio.h"
+#include "rpihal/gpiowave.h"
+
+#include <pthread.h>
+#include <time.h>
+
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INF
+#define LOG_MODULE_NAME  GPIOWAVE
+#include "internal/log.h"
+
+
+
+#define LATE_THRESHOLD (10000) // [ns]
+
+
+
+typedef struct
+{
+    pthread_t thread;
+    const RPIHAL_GPIOWAVE_entry_t* entries;
+    size_t count;
+    RPIHAL_GPIOWAVE_config_t config;
+    int running;
+
+    // statistics, written by the playback thread only
+    uint64_t played;
+    uint64_t late;
+    uint64_t maxError;
+    double sumError;
+    double sumSqError;
+} wave_t;
+
+static int join(RPIHAL_GPIOWAVE_instance_t* inst);
+static void* playbackThread(void* arg);
+
+
+
+void RPIHAL_GPIOWAVE_defaultConfig(RPIHAL_GPIOWAVE_config_t* config)
+{
+    config->loops = 1;
+    config->spin = 100000;
+    config->cpu = -1;
+    config->priority = 0;
+}
+
+int RPIHAL_GPIOWAVE_play(RPIHAL_GPIOWAVE_instance_t* inst, const RPIHAL_GPIOWAVE_entry_t* wave, size_t count, const RPIHAL_GPIOWAVE_config_t* config)
+{
+    inst->wave = NULL;
+
+    if (!wave || (count == 0))
+    {
+        LOG_ERR("empty waveform");
+        return -(__LINE__);
+    }
+
+    wave_t* w = (wave_t*)malloc(sizeof(wave_t));
+    if (!w) { return -(__LINE__); }
+    memset(w, 0, sizeof(wave_t));
+
+    w->entries = wave;
+    w->count = count;
+    w->config = *config;
+    w->running = 1;
+
+    const int err = pthread_create(&w->thread, NULL, playbackThread, w);
+    if (err)
+    {
+        LOG_ERR("failed to create playback thread (%s)", strerror(err));
+        free(w);
+        return -(__LINE__);
+    }
+
+    inst->wave = w;
+
+    return 0;
+}
+
+int RPIHAL_GPIOWAVE_getStats(const RPIHAL_GPIOWAVE_instance_t* inst, RPIHAL_GPIOWAVE_stats_t* stats)
+{
+    const wave_t* w = (const wave_t*)(inst->wave);
+
+    if (!w) { return -(__LINE__); }
+
+    double sum, sumSq;
+    __atomic_load(&w->sumError, &sum, __ATOMIC_RELAXED);
+    __atomic_load(&w->sumSqError, &sumSq, __ATOMIC_RELAXED);
+
+    stats->entries = __atomic_load_n(&w->played, __ATOMIC_RELAXED);
+    stats->late = __atomic_load_n(&w->late, __ATOMIC_RELAXED);
+    stats->maxError = __atomic_load_n(&w->maxError, __ATOMIC_RELAXED);
+    stats->running = __atomic_load_n(&w->running, __ATOMIC_ACQUIRE);
+
+    if (stats->entries)
+    {
+        const double n = (double)(stats->entries);
+        const double var = (sumSq / n) - ((sum / n) * (sum / n));
+
+        stats->meanError = sum / n;
+        stats->stdDev = (var > 0 ? sqrt(var) : 0);
+    }
+    else
+    {
+        stats->meanError = 0;
+        stats->stdDev = 0;
+    }
+
+    return 0;
+}
+
+int RPIHAL_GPIOWAVE_wait(RPIHAL_GPIOWAVE_instance_t* inst)
+{
+    if (!inst->wave) { return -(__LINE__); }
+
+    return join(inst);
+}
+
+int RPIHAL_GPIOWAVE_stop(RPIHAL_GPIOWAVE_instance_t* inst)
+{
+    wave_t* w = (wave_t*)(inst->wave);
+
+    if (!w) { return -(__LINE__); }
+
+    __atomic_store_n(&w->running, 0, __ATOMIC_RELEASE);
+
+    return join(inst);
+}
+
+
+
+int join(RPIHAL_GPIOWAVE_instance_t* inst)
+{
+    int r = 0;
+    wave_t* w = (wave_t*)(inst->wave);
+
+    const int err = pthread_join(w->thread, NULL);
+    if (err)
+    {
+        LOG_ERR("failed to join the playback thread (%s)", strerror(err));
+        r = -(__LINE__);
+    }
+
+    free(w);
+    inst->wave = NULL;
+
+    return r;
+}
+
+void* playbackThread(void* arg)
+{
+    wave_t* w = (wave_t*)arg;
+    const RPIHAL_GPIOWAVE_config_t* config = &w->config;
+
+    const int err = UTIL_setThreadSched(config->cpu, config->priority);
+    if (err) { LOG_WRN("failed to set CPU %i and priority %i of the playback thread (%s)", config->cpu, config->priority, strerror(err)); }
+
+    uint64_t deadline = UTIL_time_ns(CLOCK_MONOTONIC);
+    uint32_t loop = 0;
+
+    double sum = 0;
+    double sumSq = 0;
+
+    while (__atomic_load_n(&w->running, __ATOMIC_ACQUIRE) && ((config->loops == 0) || (loop < config->loops)))
+    {
+        for (size_t i = 0; (i < w->count) && __atomic_load_n(&w->running, __ATOMIC_RELAXED); ++i)
+        {
+            const RPIHAL_GPIOWAVE_entry_t* entry = w->entries + i;
+
+            const uint64_t t = UTIL_waitUntil_ns(CLOCK_MONOTONIC, deadline, config->spin);
+            RPIHAL_GPIO_write64(entry->set | entry->clr, entry->set);
+
+            const uint64_t error = t - deadline;
+            deadline += entry->delay;
+
+            sum += (double)error;
+            sumSq += (double)error * (double)error;
+
+            __atomic_store_n(&w->played, w->played + 1, __ATOMIC_RELAXED);
+            if (error > LATE_THRESHOLD) { __atomic_store_n(&w->late, w->late + 1, __ATOMIC_RELAXED); }
+            if (error > w->maxError) { __atomic_store_n(&w->maxError, error, __ATOMIC_RELAXED); }
+            __atomic_store(&w->sumError, &sum, __ATOMIC_RELAXED);
+            __atomic_store(&w->sumSqError, &sumSq, __ATOMIC_RELAXED);
+        }
+
+        ++loop;
+    }
+
+    __atomic_store_n(&w->running, 0, __ATOMIC_RELEASE);
+
+    return NULL;
+}
@@ -0,0 +1,175 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef IG_RPIHAL_INTERNAL_BCM_H
+#define IG_RPIHAL_INTERNAL_BCM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rpihal/gpio.h>
+#include <rpihal/rpihal.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define BCM_REGISTER_PASSWORD (0x5A000000u)
+#define BCM_BLOCK_SIZE        (4 * 1024)
+// #define BCM_PAGE_SIZE      (4 * 1024)
+
+#define PERI_ADR_BASE_BCM2835   (0x20000000u)
+#define PERI_ADR_BASE_BCM2836_7 (0x3F000000u)
+#define PERI_ADR_BASE_BCM2836   PERI_ADR_BASE_BCM2836_7
+#define PERI_ADR_BASE_BCM2837   PERI_ADR_BASE_BCM2836_7
+#define PERI_ADR_BASE_BCM2711   (0xFE000000u)
+
+// BCM283x and BCM2711
+#define PERI_ADR_OFFSET_DMA  (0x00007000u) // channels 0..14
+#define PERI_ADR_OFFSET_PADS (0x00100000u) // pad control
+#define PERI_ADR_OFFSET_CM   (0x00101000u) // clock manager
+#define PERI_ADR_OFFSET_GPIO (0x00200000u)
+#define PERI_ADR_OFFSET_PWM  (0x0020C000u)
+
+// peripheral base as seen by the DMA engine (VC bus address), the offsets are the same
+#define PERI_BUS_BASE (0x7E000000u)
+
+
+
+//! @return The ARM physical peripheral base address, __0__ if the SoC is not supported
+static inline uint32_t iBCM_periBase(RPIHAL_model_t model)
+{
+    // ADDHW bcm2835, bcm2712
+    if (RPIHAL_model_SoC_is_bcm2836(model)) { return PERI_ADR_BASE_BCM2836; }
+    if (RPIHAL_model_SoC_is_bcm2837_any(model)) { return PERI_ADR_BASE_BCM2837; }
+    if (RPIHAL_model_SoC_is_bcm2711(model)) { return PERI_ADR_BASE_BCM2711; }
+    return 0;
+}
+
+/**
+ * @brief Maps a peripheral register block from `/dev/mem`.
+ *
+ * Root access is needed.
+ *
+ * @param addr ARM physical address, has to be page aligned
+ * @param size Size of the block in bytes
+ * @return The mapped block, `NULL` on failure (`errno` is set)
+ */
+static inline RPIHAL_regptr_t iBCM_mapDevMem(off_t addr, size_t size)
+{
+    const int fd = open("/dev/mem", O_RDWR | O_SYNC | O_CLOEXEC);
+    if (fd < 0) { return NULL; }
+
+    void* p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, addr);
+
+    const int err = errno;
+    close(fd);
+    errno = err;
+
+    return (p == MAP_FAILED ? NULL : (RPIHAL_regptr_t)p);
+}
+
+//! @brief Maps zero initialised anonymous memory, used to emulate a register block.
+//! @return The mapped block, `NULL` on failure (`errno` is set)
+static inline RPIHAL_regptr_t iBCM_mapAnon(size_t size)
+{
+    void* p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (p == MAP_FAILED ? NULL : (RPIHAL_regptr_t)p);
+}
+
+
+
+// the following functions are the same for bcm2835 and bcm2711
+
+static inline void BCM2835_wait_cycles(size_t cycleCount)
+{
+    while (--cycleCount) { asm volatile("nop"); }
+}
+
+// Memory barriers for the transition between peripherals (see chapter 1.3 in BCM2835-ARM-Peripherals.pdf). ARMv6
+// has no DMB instruction, there (and off-target) the compiler builtin is used, which on Linux resolves to the kernel
+// provided barrier for the CPU actually running the code.
+// clang-format off
+#if defined(__aarch64__)
+#define BCM_wmb() asm volatile("dmb oshst" ::: "memory")
+#define BCM_rmb() asm volatile("dmb oshld" ::: "memory")
+#elif defined(__arm__) && defined(__ARM_ARCH) && (__ARM_ARCH >= 7)
+#define BCM_wmb() asm volatile("dmb oshst" ::: "memory")
+#define BCM_rmb() asm volatile("dmb osh" ::: "memory")
+#else
+#define BCM_wmb() __sync_synchronize()
+#define BCM_rmb() __sync_synchronize()
+#endif
+// clang-format on
+
+static inline uint32_t BCM_reg_read_relaxed(RPIHAL_regptr_t addr) { return *addr; }
+static inline void BCM_reg_write_relaxed(RPIHAL_regptr_t addr, uint32_t value) { *addr = value; }
+
+static inline uint32_t BCM_reg_read_mb(RPIHAL_regptr_t addr)
+{
+    const uint32_t value = *addr;
+    BCM_rmb();
+    return value;
+}
+
+static inline void BCM_reg_write_mb(RPIHAL_regptr_t addr, uint32_t value)
+{
+    BCM_wmb();
+    *addr = value;
+}
+
+// `RPIHAL_regptr_t` is volatile, so the compiler can't merge the double accesses.
+
+static inline uint32_t BCM2835_reg_read(RPIHAL_regptr_t addr)
+{
+    // the last read could potentially go wrong (see chapter 1.3 in BCM2835-ARM-Peripherals.pdf).
+    uint32_t value = *addr;
+    uint32_t garbage __attribute__((unused)) = *addr;
+    return value;
+}
+
+static inline void BCM2835_reg_write(RPIHAL_regptr_t addr, uint32_t value)
+{
+    // the first write could potentially go wrong (see chapter 1.3 in BCM2835-ARM-Peripherals.pdf).
+    *addr = value;
+    *addr = value;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IG_RPIHAL_INTERNAL_BCM_H
@@ -33,6 +33,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <stdint.h>
 
 #include <rpihal/gpio.h>
+#include <rpihal/rpihal.h>
 
 
 #ifdef __cplusplus
@@ -40,20 +41,68 @@ extern "C" {
 #endif
 
 
-//! @param pin BCM GPIO pin number
+typedef enum
+{
+    iGPIO_soc_unknown = 0,
+    iGPIO_soc_bcm2835,
+    iGPIO_soc_bcm2836,
+    iGPIO_soc_bcm2837, // including BCM2837B0
+    iGPIO_soc_bcm2711,
+    iGPIO_soc_bcm2712,
+} iGPIO_soc_t;
+
+typedef enum
+{
+    iGPIO_header_unknown = 0,
+    iGPIO_header_26pin,
+    iGPIO_header_40pin,
+} iGPIO_header_t;
+
+typedef enum
+{
+    iGPIO_pullReg_unknown = 0,
+    iGPIO_pullReg_bcm2835, // GPPUD and GPPUDCLKn clock sequence (BCM283x)
+    iGPIO_pullReg_bcm2711, // GPIO_PUP_PDN_CNTRL_REGn, 2 bit per pin
+    iGPIO_pullReg_rp1,     // PUE/PDE bits in the PADS register of the pin
+} iGPIO_pullReg_t;
+
+/**
+ * @brief Platform descriptor.
+ *
+ * Resolved once by `iGPIO_initPlatform()` when the GPIO module is initialised and only read afterwards, so that the
+ * hot path doesn't need to detect or compare the model.
+ */
+typedef struct
+{
+    RPIHAL_model_t model;
+    iGPIO_soc_t soc;
+    iGPIO_header_t header;
+    iGPIO_pullReg_t pullReg;
+    int sysGpioLocked;
+    uint64_t userPinsMask; // 0 if the model is not supported
+    uint64_t bcmPinsMask;  // 0 if the model is not supported
+    uint64_t accessMask;   // pins the API is allowed to access, depends on `sysGpioLocked`
+} iGPIO_platform_t;
+
+//! @param [out] platform
+//! @param model The hardware model
 //! @param sysGpioLocked Has to be TRUE (`1`), might only be unlocked (set to FALSE) on compute modules
+void iGPIO_initPlatform(iGPIO_platform_t* platform, RPIHAL_model_t model, int sysGpioLocked);
+
+//! @param pin BCM GPIO pin number
+//! @param platform The platform the GPIO module has been initialised for
 //! @return Boolean value TRUE (`1`) if it's allowed to access the pin, otherwhise FALSE (`0`)
-int iGPIO_checkPin(int pin, int sysGpioLocked);
+int iGPIO_checkPin(int pin, const iGPIO_platform_t* platform);
 
 //! @return 0 if the hardware model is not supported, otherwise the USER_PINS_MASK_x
-uint64_t iGPIO_getUserPinsMask();
+uint64_t iGPIO_getUserPinsMask(RPIHAL_model_t model);
 
 //! @return 0 if the hardware model is not supported, otherwise the BCMx_PINS_MASK
-uint64_t iGPIO_getBcmPinsMask();
+uint64_t iGPIO_getBcmPinsMask(RPIHAL_model_t model);
 
 void iGPIO_defaultInitStruct(RPIHAL_GPIO_init_t* initStruct);
 
-int iGPIO_defaultInitStructPin(int pin, RPIHAL_GPIO_init_t* initStruct);
+int iGPIO_defaultInitStructPin(int pin, RPIHAL_GPIO_init_t* initStruct, RPIHAL_model_t model);
 
 int iGPIO_bittopin(uint64_t bit);
 
@@ -91,6 +140,10 @@ int iGPIO_bittopin(uint64_t bit);
 // #define BCM2711_FIRST_PIN (0)
 // #define BCM2711_LAST_PIN  (57)
 
+#define RP1_PINS_MASK (0x000000000FFFFFFFull) // bank 0, the other banks are used by the system
+// #define RP1_FIRST_PIN (0)
+// #define RP1_LAST_PIN  (27)
+
 #define USER_PINS_MASK_26pin_rev1    (0x0000000003E6CF93ull)
 #define USER_PINS_MASK_26pin_rev2_P1 (0x000000000BC6CF9Cull) // GPIO pin header P1
 #define USER_PINS_MASK_26pin_rev2_P5 (0x00000000F0000000ull) // addon GPIO pin header P5
@@ -106,37 +159,49 @@ int iGPIO_bittopin(uint64_t bit);
 
 
 
-int iGPIO_checkPin(int pin, int sysGpioLocked)
+void iGPIO_initPlatform(iGPIO_platform_t* platform, RPIHAL_model_t model, int sysGpioLocked)
 {
-    int r = 0;
-
-    // bit of the pin
-    uint64_t bit = 0x01;
-    bit <<= pin;
-
-    uint64_t mask;
-
-    if (sysGpioLocked) { mask = iGPIO_getUserPinsMask(); }
-    else { mask = iGPIO_getBcmPinsMask(); }
+    platform->model = model;
+
+    if (RPIHAL_model_SoC_is_bcm2835(model)) { platform->soc = iGPIO_soc_bcm2835; }
+    else if (RPIHAL_model_SoC_is_bcm2836(model)) { platform->soc = iGPIO_soc_bcm2836; }
+    else if (RPIHAL_model_SoC_is_bcm2837_any(model)) { platform->soc = iGPIO_soc_bcm2837; }
+    else if (RPIHAL_model_SoC_is_bcm2711(model)) { platform->soc = iGPIO_soc_bcm2711; }
+    else if (RPIHAL_model_SoC_is_bcm2712(model)) { platform->soc = iGPIO_soc_bcm2712; }
+    else { platform->soc = iGPIO_soc_unknown; }
+
+    if (RPIHAL_model_header_is_26pin(model)) { platform->header = iGPIO_header_26pin; }
+    else if (RPIHAL_model_header_is_40pin(model)) { platform->header = iGPIO_header_40pin; }
+    else { platform->header = iGPIO_header_unknown; }
+
+    if (RPIHAL_model_SoC_peripheral_is_bcm283x(model)) { platform->pullReg = iGPIO_pullReg_bcm2835; }
+    else if (RPIHAL_model_SoC_peripheral_is_bcm2711(model)) { platform->pullReg = iGPIO_pullReg_bcm2711; }
+    else if (RPIHAL_model_SoC_is_bcm2712(model)) { platform->pullReg = iGPIO_pullReg_rp1; }
+    else { platform->pullReg = iGPIO_pullReg_unknown; }
+
+    platform->sysGpioLocked = sysGpioLocked;
+    platform->userPinsMask = iGPIO_getUserPinsMask(model);
+    platform->bcmPinsMask = iGPIO_getBcmPinsMask(model);
+
+    if (sysGpioLocked) { platform->accessMask = platform->userPinsMask; }
+    else { platform->accessMask = platform->bcmPinsMask; }
+}
 
-    if (mask & bit) r = 1;
+int iGPIO_checkPin(int pin, const iGPIO_platform_t* platform)
+{
+    if (((unsigned int)pin < 64) && (platform->accessMask & (1ull << pin))) { return 1; }
 
-    if (!r)
-    {
-        if (sysGpioLocked) { LOG_WRN("system GPIOs are locked"); }
-        LOG_ERR("invalid pin: %i", pin);
-    }
+    if (platform->sysGpioLocked) { LOG_WRN("system GPIOs are locked"); }
+    LOG_ERR("invalid pin: %i", pin);
 
-    return r;
+    return 0;
 }
 
-uint64_t iGPIO_getUserPinsMask()
+uint64_t iGPIO_getUserPinsMask(RPIHAL_model_t model)
 {
     uint64_t mask = 0;
 
-    const RPIHAL_model_t hwModel = RPIHAL_getModel();
-
-    if (RPIHAL_model_header_is_26pin(hwModel))
+    if (RPIHAL_model_header_is_26pin(model))
     {
 #if 0 // ADDHW
             if (RPIHAL_model_t has to be a bit field, so the rev can be read out of it) { mask = USER_PINS_MASK_26pin_rev; }
@@ -147,20 +212,19 @@ uint64_t iGPIO_getUserPinsMask()
         mask = 0;
 #endif
     }
-    else if (RPIHAL_model_header_is_40pin(hwModel)) { mask = USER_PINS_MASK_40pin; }
+    else if (RPIHAL_model_header_is_40pin(model)) { mask = USER_PINS_MASK_40pin; }
     else { mask = 0; }
 
     return mask;
 }
 
-uint64_t iGPIO_getBcmPinsMask()
+uint64_t iGPIO_getBcmPinsMask(RPIHAL_model_t model)
 {
     uint64_t mask = 0;
 
-    const RPIHAL_model_t hwModel = RPIHAL_getModel();
-
-    if (RPIHAL_model_SoC_peripheral_is_bcm283x(hwModel)) { mask = BCM283x_PINS_MASK; }
-    else if (RPIHAL_model_SoC_peripheral_is_bcm2711(hwModel)) { mask = BCM2711_PINS_MASK; }
+    if (RPIHAL_model_SoC_peripheral_is_bcm283x(model)) { mask = BCM283x_PINS_MASK; }
+    else if (RPIHAL_model_SoC_peripheral_is_bcm2711(model)) { mask = BCM2711_PINS_MASK; }
+    else if (RPIHAL_model_SoC_is_bcm2712(model)) { mask = RP1_PINS_MASK; }
     else { mask = 0; }
 
     return mask;
@@ -170,21 +234,22 @@ void iGPIO_defaultInitStruct(RPIHAL_GPIO_init_t* initStruct)
 {
     initStruct->mode = RPIHAL_GPIO_MODE_IN;
     initStruct->pull = RPIHAL_GPIO_PULL_DOWN;
-    // initStruct->drive = RPIHAL_GPIO_DRIVE_2mA;
+    initStruct->drive = RPIHAL_GPIO_DRIVE_KEEP;
     initStruct->altfunc = RPIHAL_GPIO_AF_0;
+    initStruct->slew = RPIHAL_GPIO_SLEW_FAST;
+    initStruct->hysteresis = 1;
 }
 
-int iGPIO_defaultInitStructPin(int pin, RPIHAL_GPIO_init_t* initStruct)
+int iGPIO_defaultInitStructPin(int pin, RPIHAL_GPIO_init_t* initStruct, RPIHAL_model_t model)
 {
     int r = 0;
 
-    const RPIHAL_model_t hwModel = RPIHAL_getModel();
-
     initStruct->mode = RPIHAL_GPIO_MODE_IN;
 
     int lastPin;
-    if (RPIHAL_model_SoC_peripheral_is_bcm283x(hwModel)) { lastPin = 53; }
-    else if (RPIHAL_model_SoC_peripheral_is_bcm2711(hwModel)) { lastPin = 57; }
+    if (RPIHAL_model_SoC_peripheral_is_bcm283x(model)) { lastPin = 53; }
+    else if (RPIHAL_model_SoC_peripheral_is_bcm2711(model)) { lastPin = 57; }
+    else if (RPIHAL_model_SoC_is_bcm2712(model)) { lastPin = 27; }
     else
     {
         lastPin = 57;
@@ -195,7 +260,10 @@ int iGPIO_defaultInitStructPin(int pin, RPIHAL_GPIO_init_t* initStruct)
     else if (((pin >= 9) && (pin <= 27)) || ((pin >= 30) && (pin <= 33)) || ((pin >= 37) && (pin <= 43))) { initStruct->pull = RPIHAL_GPIO_PULL_DOWN; }
     else initStruct->pull = RPIHAL_GPIO_PULL_NONE;
 
+    initStruct->drive = RPIHAL_GPIO_DRIVE_KEEP;
     initStruct->altfunc = RPIHAL_GPIO_AF_0;
+    initStruct->slew = RPIHAL_GPIO_SLEW_FAST;
+    initStruct->hysteresis = 1;
 
     return r;
 }
@@ -216,6 +284,7 @@ int iGPIO_bittopin(uint64_t bit)
 #undef LOG_MODULE_NAME
 #undef BCM283x_PINS_MASK
 #undef BCM2711_PINS_MASK
+#undef RP1_PINS_MASK
 #undef USER_PINS_MASK_26pin_rev1
 #undef USER_PINS_MASK_26pin_rev2_P1
 #undef USER_PINS_MASK_26pin_rev2_P5
@@ -39,7 +39,7 @@ extern "C" {
 #error "not a Linux platform - this library is only for the Raspberry Pi!"
 #endif
 
-#if (!defined(__arm__) && !defined(__aarch64__))
+#if (!defined(__arm__) && !defined(__aarch64__) && !defined(RPIHAL_CONFIG_OFFTARGET))
 #error "not an ARM platform - this library is only for the Raspberry Pi!"
 #endif
 
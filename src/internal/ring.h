@@ -0,0 +1,159 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef IG_RPIHAL_INTERNAL_RING_H
+#define IG_RPIHAL_INTERNAL_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Lock-free single-producer/single-consumer ring buffer of fixed size elements.
+//
+// `head` is only written by the producer, `tail` only by the consumer. Both are free running, the capacity is a power
+// of two so that the index is `counter & mask`. The counters and the statistics live on separate cache lines to
+// avoid false sharing between the two threads.
+
+#define iRING_CACHE_LINE (64)
+
+typedef struct
+{
+    uint8_t* buffer;
+    size_t elementSize;
+    size_t capacity;
+    size_t mask;
+
+    // producer
+    __attribute__((aligned(iRING_CACHE_LINE))) size_t head;
+    uint64_t pushed;    // number of elements pushed
+    uint64_t overflows; // number of elements dropped because the ring was full
+    size_t highWater;   // max number of elements in the ring
+
+    // consumer
+    __attribute__((aligned(iRING_CACHE_LINE))) size_t tail;
+} iRING_t;
+
+//! @param capacity Rounded up to the next power of two
+//! @return __0__ on success, __negative__ on error
+static inline int iRING_init(iRING_t* ring, size_t elementSize, size_t capacity)
+{
+    size_t cap = 1;
+    while (cap < capacity) { cap <<= 1; }
+
+    memset(ring, 0, sizeof(*ring));
+
+    ring->buffer = (uint8_t*)malloc(cap * elementSize);
+    if (!ring->buffer) { return -(__LINE__); }
+
+    ring->elementSize = elementSize;
+    ring->capacity = cap;
+    ring->mask = cap - 1;
+
+    return 0;
+}
+
+static inline void iRING_destroy(iRING_t* ring)
+{
+    free(ring->buffer);
+    ring->buffer = NULL;
+}
+
+//! @return Number of elements in the ring, may be outdated as soon as it's returned
+static inline size_t iRING_count(const iRING_t* ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Copies as many of the elements into the ring as fit, the rest is dropped and counted as overflow.
+ *
+ * Must only be called by the producer.
+ *
+ * @return Number of elements pushed
+ */
+static inline size_t iRING_push(iRING_t* ring, const void* elements, size_t count)
+{
+    const size_t head = ring->head;
+    const size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    const size_t space = ring->capacity - (head - tail);
+    const size_t n = (count < space ? count : space);
+
+    const size_t idx = head & ring->mask;
+    const size_t n1 = ((ring->capacity - idx) < n ? (ring->capacity - idx) : n); // up to the end of the buffer
+
+    memcpy(ring->buffer + (idx * ring->elementSize), elements, n1 * ring->elementSize);
+    memcpy(ring->buffer, (const uint8_t*)elements + (n1 * ring->elementSize), (n - n1) * ring->elementSize);
+
+    __atomic_store_n(&ring->head, head + n, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&ring->pushed, ring->pushed + n, __ATOMIC_RELAXED);
+    if (n < count) { __atomic_store_n(&ring->overflows, ring->overflows + (count - n), __ATOMIC_RELAXED); }
+    if (ring->highWater < (head + n - tail)) { __atomic_store_n(&ring->highWater, head + n - tail, __ATOMIC_RELAXED); }
+
+    return n;
+}
+
+/**
+ * @brief Moves up to `count` elements out of the ring.
+ *
+ * Must only be called by the consumer.
+ *
+ * @return Number of elements popped
+ */
+static inline size_t iRING_pop(iRING_t* ring, void* elements, size_t count)
+{
+    const size_t tail = ring->tail;
+    const size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    const size_t available = head - tail;
+    const size_t n = (count < available ? count : available);
+
+    const size_t idx = tail & ring->mask;
+    const size_t n1 = ((ring->capacity - idx) < n ? (ring->capacity - idx) : n);
+
+    memcpy(elements, ring->buffer + (idx * ring->elementSize), n1 * ring->elementSize);
+    memcpy((uint8_t*)elements + (n1 * ring->elementSize), ring->buffer, (n - n1) * ring->elementSize);
+
+    __atomic_store_n(&ring->tail, tail + n, __ATOMIC_RELEASE);
+
+    return n;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IG_RPIHAL_INTERNAL_RING_H
@@ -0,0 +1,159 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef IG_RPIHAL_INTERNAL_SPI_H
+#define IG_RPIHAL_INTERNAL_SPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rpihal/spi.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//! @param [out] pool
+//! @param bufferSize Usable size of each buffer, rounded up to the page size for the stride
+//! @param count Number of buffers, max `RPIHAL_SPI_POOL_BUFFERS_MAX`
+//! @return __0__ on success, __negative__ on error
+int iSPI_poolCreate(RPIHAL_SPI_pool_t* pool, size_t bufferSize, size_t count);
+
+uint8_t* iSPI_poolGet(RPIHAL_SPI_pool_t* pool);
+
+void iSPI_poolPut(RPIHAL_SPI_pool_t* pool, uint8_t* buffer);
+
+void iSPI_poolDestroy(RPIHAL_SPI_pool_t* pool);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IG_RPIHAL_INTERNAL_SPI_H
+
+
+
+#ifdef iSPI_DEFINE_FUNCTIONS
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rpihal/spi.h"
+
+#include <unistd.h>
+
+#undef LOG_MODULE_LEVEL
+#undef LOG_MODULE_NAME
+#define LOG_MODULE_LEVEL LOG_LEVEL_INF
+#define LOG_MODULE_NAME  SPI
+#include "../internal/log.h"
+
+
+
+int iSPI_poolCreate(RPIHAL_SPI_pool_t* pool, size_t bufferSize, size_t count)
+{
+    memset(pool, 0, sizeof(*pool));
+
+    if ((bufferSize == 0) || (count == 0) || (count > RPIHAL_SPI_POOL_BUFFERS_MAX))
+    {
+        LOG_ERR("invalid pool of %zu buffers of %zu bytes", count, bufferSize);
+        return -(__LINE__);
+    }
+
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    const size_t page = (pageSize > 0 ? (size_t)pageSize : 4096);
+    const size_t stride = ((bufferSize + page - 1) / page) * page;
+
+    void* memory = NULL;
+
+    if (posix_memalign(&memory, page, stride * count) != 0)
+    {
+        LOG_ERR("failed to allocate %zu buffers of %zu bytes", count, stride);
+        return -(__LINE__);
+    }
+
+    // touch the memory to have it faulted in before the first transfer
+    memset(memory, 0, stride * count);
+
+    pool->memory = (uint8_t*)memory;
+    pool->bufferSize = bufferSize;
+    pool->stride = stride;
+    pool->count = count;
+    pool->free = ((count < 64) ? ((1ull << count) - 1) : ~0ull);
+
+    return 0;
+}
+
+uint8_t* iSPI_poolGet(RPIHAL_SPI_pool_t* pool)
+{
+    uint64_t freeMask = __atomic_load_n(&pool->free, __ATOMIC_ACQUIRE);
+
+    while (freeMask)
+    {
+        const int idx = __builtin_ctzll(freeMask);
+
+        if (__atomic_compare_exchange_n(&pool->free, &freeMask, freeMask & ~(1ull << idx), 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            return pool->memory + ((size_t)idx * pool->stride);
+        }
+    }
+
+    return NULL;
+}
+
+void iSPI_poolPut(RPIHAL_SPI_pool_t* pool, uint8_t* buffer)
+{
+    if (!buffer || (buffer < pool->memory)) { return; }
+
+    const size_t idx = (size_t)(buffer - pool->memory) / pool->stride;
+
+    if ((idx >= pool->count) || (buffer != (pool->memory + (idx * pool->stride))))
+    {
+        LOG_ERR("buffer %p is not part of the pool", (void*)buffer);
+        return;
+    }
+
+    __atomic_fetch_or(&pool->free, (1ull << idx), __ATOMIC_RELEASE);
+}
+
+void iSPI_poolDestroy(RPIHAL_SPI_pool_t* pool)
+{
+    free(pool->memory);
+    memset(pool, 0, sizeof(*pool));
+}
+
+#undef LOG_MODULE_LEVEL
+#undef LOG_MODULE_NAME
+
+#endif // iSPI_DEFINE_FUNCTIONS
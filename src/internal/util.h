@@ -30,12 +30,91 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef IG_RPIHAL_INTERNAL_UTIL_H
 #define IG_RPIHAL_INTERNAL_UTIL_H
 
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
-// voi UTIL_...
+//! @return Time of the clock [ns]
+static inline uint64_t UTIL_time_ns(clockid_t clk)
+{
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Waits until `deadline`.
+ *
+ * Sleeps until `spin` before the deadline and busy waits for the rest, as the wake up latency of the sleep is much
+ * larger than the resolution of the clock.
+ *
+ * @param clk Clock of `deadline`
+ * @param deadline Absolute time [ns]
+ * @param spin Busy wait time [ns]
+ * @return The time at which the function returned [ns]
+ */
+static inline uint64_t UTIL_waitUntil_ns(clockid_t clk, uint64_t deadline, uint64_t spin)
+{
+    uint64_t t = UTIL_time_ns(clk);
+
+    if ((t + spin) < deadline)
+    {
+        struct timespec ts;
+        ts.tv_sec = (time_t)((deadline - spin) / 1000000000ull);
+        ts.tv_nsec = (long)((deadline - spin) % 1000000000ull);
+
+        while (clock_nanosleep(clk, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+
+        t = UTIL_time_ns(clk);
+    }
+
+    while (t < deadline) { t = UTIL_time_ns(clk); }
+
+    return t;
+}
+
+#ifdef _GNU_SOURCE
+/**
+ * @brief Pins the calling thread to a CPU and sets its scheduling policy.
+ *
+ * Only available if `_GNU_SOURCE` is defined before the first include.
+ *
+ * @param cpu CPU index, negative to keep the affinity
+ * @param priority `SCHED_FIFO` priority (1..99), __0__ to keep `SCHED_OTHER`
+ * @return __0__ on success, the error number otherwise
+ */
+static inline int UTIL_setThreadSched(int cpu, int priority)
+{
+    int err = 0;
+
+    if (cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    if ((err == 0) && (priority > 0))
+    {
+        struct sched_param param;
+        param.sched_priority = priority;
+        err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    }
+
+    return err;
+}
+#endif // _GNU_SOURCE
 
 
 #ifdef __cplusplus
@@ -0,0 +1,453 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "internal/bcm.h"
+#include "internal/platform_check.h"
+#include "rpihal/gpio.h"
+#include "rpihal/pwm.h"
+#include "rpihal/rpihal.h"
+
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INF
+#define LOG_MODULE_NAME  PWM
+#include "internal/log.h"
+
+
+
+// PWM register offsets
+
+#define PWM_CTL  (0x0000)
+#define PWM_STA  (0x0004)
+#define PWM_DMAC (0x0008)
+#define PWM_RNG1 (0x0010)
+#define PWM_DAT1 (0x0014)
+#define PWM_FIF1 (0x0018)
+#define PWM_RNG2 (0x0020)
+#define PWM_DAT2 (0x0024)
+
+// CTL, channel 2 bits are shifted by 8
+#define PWM_CTL_PWEN          (0x01)
+#define PWM_CTL_MODE          (0x02) // serialiser
+#define PWM_CTL_RPTL          (0x04)
+#define PWM_CTL_SBIT          (0x08)
+#define PWM_CTL_POLA          (0x10)
+#define PWM_CTL_USEF          (0x20)
+#define PWM_CTL_CLRF          (0x40) // channel 1 only
+#define PWM_CTL_MSEN          (0x80)
+#define PWM_CTL_CH_MASK       (0xBF)
+#define PWM_CTL_CH_SHIFT(_ch) ((_ch) * 8)
+
+#define PWM_STA_FULL1  (0x0001)
+#define PWM_STA_EMPT1  (0x0002)
+#define PWM_STA_WERR1  (0x0004)
+#define PWM_STA_RERR1  (0x0008)
+#define PWM_STA_GAPO1  (0x0010)
+#define PWM_STA_GAPO2  (0x0020)
+#define PWM_STA_BERR   (0x0100)
+#define PWM_STA_STA1   (0x0200)
+#define PWM_STA_STA2   (0x0400)
+#define PWM_STA_ERRORS (PWM_STA_WERR1 | PWM_STA_RERR1 | PWM_STA_GAPO1 | PWM_STA_GAPO2 | PWM_STA_BERR)
+
+#define PWM_DMAC_ENAB        (0x80000000u)
+#define PWM_DMAC_PANIC_SHIFT (8)
+#define PWM_DMAC_DREQ_SHIFT  (0)
+#define PWM_DMAC_THRESHOLD   (7)
+
+
+
+// clock manager register offsets
+
+#define CM_PWMCTL (0x00A0)
+#define CM_PWMDIV (0x00A4)
+
+#define CM_CTL_SRC_OSC (0x01)
+#define CM_CTL_ENAB    (0x10)
+#define CM_CTL_KILL    (0x20)
+#define CM_CTL_BUSY    (0x80)
+
+#define CM_DIV_DIVI_SHIFT (12)
+#define CM_DIV_DIVI_MIN   (2)
+#define CM_DIV_DIVI_MAX   (4095)
+
+#define OSC_FREQ_BCM283x (19200000u)
+#define OSC_FREQ_BCM2711 (54000000u)
+
+#define CLOCK_BUSY_TIMEOUT (1000) // [10us]
+
+
+
+static RPIHAL_regptr_t pwm_base = NULL;
+static RPIHAL_regptr_t cm_base = NULL;
+
+static uint32_t oscFreq = 0;
+static uint32_t clockFreq = 0; // 0 if not set
+static uint32_t range[2] = { 0, 0 };
+static int fifoChannels = 0; // bit mask of the channels using the FIFO
+
+static inline uint32_t pwm_read(uint32_t offset) { return BCM_reg_read_mb(pwm_base + (offset / 4)); }
+static inline void pwm_write(uint32_t offset, uint32_t value) { BCM_reg_write_mb(pwm_base + (offset / 4), value); }
+static inline uint32_t cm_read(uint32_t offset) { return BCM_reg_read_mb(cm_base + (offset / 4)); }
+static inline void cm_write(uint32_t offset, uint32_t value) { BCM_reg_write_mb(cm_base + (offset / 4), BCM_REGISTER_PASSWORD | value); }
+
+static int checkChannel(int ch);
+static uint64_t fifoDrainTime();
+
+
+
+int RPIHAL_PWM_init() { return RPIHAL_PWM_initBackend(RPIHAL_GPIO_BACKEND_MMAP, RPIHAL_model_unknown); }
+
+int RPIHAL_PWM_initBackend(int id, RPIHAL_model_t model)
+{
+    if (pwm_base)
+    {
+        LOG_ERR("PWM is already initialised");
+        return -(__LINE__);
+    }
+
+    if ((id != RPIHAL_GPIO_BACKEND_MMAP) && (id != RPIHAL_GPIO_BACKEND_ANON))
+    {
+        LOG_ERR("invalid backend 0x%x", id);
+        return -(__LINE__);
+    }
+
+    if (model == RPIHAL_model_unknown) { model = RPIHAL_getModel(); }
+
+    const uint32_t periBase = iBCM_periBase(model);
+    if (periBase == 0)
+    {
+        LOG_ERR("PWM for this model is not yet supported");
+        return -(__LINE__);
+    }
+
+    if (RPIHAL_model_SoC_is_bcm2711(model)) { oscFreq = OSC_FREQ_BCM2711; }
+    else { oscFreq = OSC_FREQ_BCM283x; }
+
+    if (id == RPIHAL_GPIO_BACKEND_ANON)
+    {
+        pwm_base = iBCM_mapAnon(BCM_BLOCK_SIZE);
+        cm_base = iBCM_mapAnon(BCM_BLOCK_SIZE);
+    }
+    else
+    {
+        pwm_base = iBCM_mapDevMem(periBase + PERI_ADR_OFFSET_PWM, BCM_BLOCK_SIZE);
+        cm_base = iBCM_mapDevMem(periBase + PERI_ADR_OFFSET_CM, BCM_BLOCK_SIZE);
+    }
+
+    if (!pwm_base || !cm_base)
+    {
+        LOG_ERR("failed to map the registers (%i %s)", errno, strerror(errno));
+
+        if (pwm_base) { munmap((void*)pwm_base, BCM_BLOCK_SIZE); }
+        if (cm_base) { munmap((void*)cm_base, BCM_BLOCK_SIZE); }
+        pwm_base = NULL;
+        cm_base = NULL;
+
+        return -(__LINE__);
+    }
+
+    clockFreq = 0;
+    range[0] = range[1] = 0;
+    fifoChannels = 0;
+
+    return 0;
+}
+
+int RPIHAL_PWM_setClock(uint32_t frequency, uint32_t* actual)
+{
+    if (!pwm_base) { return -(__LINE__); }
+
+    if (frequency == 0)
+    {
+        LOG_ERR("invalid frequency");
+        return -(__LINE__);
+    }
+
+    uint32_t divi = (oscFreq + (frequency / 2)) / frequency;
+    if (divi < CM_DIV_DIVI_MIN) { divi = CM_DIV_DIVI_MIN; }
+    if (divi > CM_DIV_DIVI_MAX) { divi = CM_DIV_DIVI_MAX; }
+
+    // the PWM has to be stopped while the clock is switched
+    const uint32_t ctl = pwm_read(PWM_CTL);
+    pwm_write(PWM_CTL, 0);
+
+    const uint32_t cmCtl = cm_read(CM_PWMCTL) & 0x00FFFFFF & ~(CM_CTL_KILL | CM_CTL_BUSY); // without password and status
+    cm_write(CM_PWMCTL, CM_CTL_KILL);
+
+    int timeout = CLOCK_BUSY_TIMEOUT;
+    while ((cm_read(CM_PWMCTL) & CM_CTL_BUSY) && (timeout > 0))
+    {
+        usleep(10);
+        --timeout;
+    }
+
+    if (timeout <= 0)
+    {
+        // leave the clock and the PWM as they were
+        cm_write(CM_PWMCTL, cmCtl);
+        pwm_write(PWM_CTL, ctl & ~PWM_CTL_CLRF);
+
+        LOG_ERR("PWM clock is still busy");
+        return -(__LINE__);
+    }
+
+    cm_write(CM_PWMDIV, divi << CM_DIV_DIVI_SHIFT);
+    cm_write(CM_PWMCTL, CM_CTL_SRC_OSC);
+    cm_write(CM_PWMCTL, CM_CTL_SRC_OSC | CM_CTL_ENAB);
+
+    pwm_write(PWM_CTL, ctl & ~PWM_CTL_CLRF);
+
+    clockFreq = oscFreq / divi;
+    if (actual) { *actual = clockFreq; }
+
+    LOG_INF("clock %uHz (divider %u)", clockFreq, divi);
+
+    return 0;
+}
+
+void RPIHAL_PWM_defaultChConfig(RPIHAL_PWM_chConfig_t* config)
+{
+    config->mode = RPIHAL_PWM_MODE_MS;
+    config->range = 1024;
+    config->useFifo = 0;
+    config->repeat = 0;
+    config->silence = 0;
+    config->invert = 0;
+}
+
+int RPIHAL_PWM_configChannel(int ch, const RPIHAL_PWM_chConfig_t* config)
+{
+    if (!pwm_base || !checkChannel(ch)) { return -(__LINE__); }
+
+    if ((config->range == 0) || ((config->mode == RPIHAL_PWM_MODE_SERIAL) && (config->range > 32)))
+    {
+        LOG_ERR("invalid range %u", config->range);
+        return -(__LINE__);
+    }
+
+    uint32_t bits = 0;
+
+    switch (config->mode)
+    {
+    case RPIHAL_PWM_MODE_PWM:
+        break;
+
+    case RPIHAL_PWM_MODE_MS:
+        bits |= PWM_CTL_MSEN;
+        break;
+
+    case RPIHAL_PWM_MODE_SERIAL:
+        bits |= PWM_CTL_MODE;
+        break;
+
+    default:
+        LOG_ERR("invalid mode %i", config->mode);
+        return -(__LINE__);
+        break;
+    }
+
+    if (config->useFifo) { bits |= PWM_CTL_USEF; }
+    if (config->repeat) { bits |= PWM_CTL_RPTL; }
+    if (config->silence) { bits |= PWM_CTL_SBIT; }
+    if (config->invert) { bits |= PWM_CTL_POLA; }
+
+    const uint32_t shift = PWM_CTL_CH_SHIFT(ch);
+    const uint32_t ctl = pwm_read(PWM_CTL) & ~PWM_CTL_CLRF & ~(PWM_CTL_CH_MASK << shift);
+
+    pwm_write(PWM_CTL, ctl);
+    pwm_write((ch == 0 ? PWM_RNG1 : PWM_RNG2), config->range);
+    pwm_write(PWM_CTL, ctl | (bits << shift));
+
+    range[ch] = config->range;
+    if (config->useFifo) { fifoChannels |= (1 << ch); }
+    else { fifoChannels &= ~(1 << ch); }
+
+    return 0;
+}
+
+int RPIHAL_PWM_enable(int ch, int enable)
+{
+    if (!pwm_base || !checkChannel(ch)) { return -(__LINE__); }
+
+    const uint32_t bit = PWM_CTL_PWEN << PWM_CTL_CH_SHIFT(ch);
+    const uint32_t ctl = pwm_read(PWM_CTL) & ~PWM_CTL_CLRF;
+
+    if (enable) { pwm_write(PWM_CTL, ctl | bit); }
+    else { pwm_write(PWM_CTL, ctl & ~bit); }
+
+    return 0;
+}
+
+int RPIHAL_PWM_setData(int ch, uint32_t data)
+{
+    if (!pwm_base || !checkChannel(ch)) { return -(__LINE__); }
+
+    pwm_write((ch == 0 ? PWM_DAT1 : PWM_DAT2), data);
+
+    return 0;
+}
+
+int RPIHAL_PWM_writeFifo(const uint32_t* data, size_t count)
+{
+    if (!pwm_base) { return -(__LINE__); }
+
+    size_t i = 0;
+
+    while ((i < count) && !(pwm_read(PWM_STA) & PWM_STA_FULL1))
+    {
+        pwm_write(PWM_FIF1, data[i]);
+        ++i;
+    }
+
+    return (int)i;
+}
+
+int RPIHAL_PWM_streamFifo(const uint32_t* data, size_t count)
+{
+    if (!pwm_base) { return -(__LINE__); }
+
+    const uint64_t drainTime = fifoDrainTime();
+    const struct timespec ts = {
+        .tv_sec = (time_t)(drainTime / 2 / 1000000000ull),
+        .tv_nsec = (long)((drainTime / 2) % 1000000000ull),
+    };
+
+    size_t i = 0;
+
+    while (i < count)
+    {
+        const int n = RPIHAL_PWM_writeFifo(data + i, count - i);
+        if (n < 0) { return -(__LINE__); }
+
+        i += (size_t)n;
+
+        if (i < count) { nanosleep(&ts, NULL); }
+    }
+
+    return 0;
+}
+
+int RPIHAL_PWM_clearFifo()
+{
+    if (!pwm_base) { return -(__LINE__); }
+
+    pwm_write(PWM_CTL, pwm_read(PWM_CTL) | PWM_CTL_CLRF);
+
+    return 0;
+}
+
+int RPIHAL_PWM_setDma(int enable)
+{
+    if (!pwm_base) { return -(__LINE__); }
+
+    const uint32_t thresholds = (PWM_DMAC_THRESHOLD << PWM_DMAC_PANIC_SHIFT) | (PWM_DMAC_THRESHOLD << PWM_DMAC_DREQ_SHIFT);
+
+    pwm_write(PWM_DMAC, (enable ? PWM_DMAC_ENAB : 0) | thresholds);
+
+    return 0;
+}
+
+int RPIHAL_PWM_getStatus(RPIHAL_PWM_status_t* status)
+{
+    if (!pwm_base) { return -(__LINE__); }
+
+    const uint32_t sta = pwm_read(PWM_STA);
+
+    status->fifoFull = ((sta & PWM_STA_FULL1) ? 1 : 0);
+    status->fifoEmpty = ((sta & PWM_STA_EMPT1) ? 1 : 0);
+    status->writeError = ((sta & PWM_STA_WERR1) ? 1 : 0);
+    status->readError = ((sta & PWM_STA_RERR1) ? 1 : 0);
+    status->gap[0] = ((sta & PWM_STA_GAPO1) ? 1 : 0);
+    status->gap[1] = ((sta & PWM_STA_GAPO2) ? 1 : 0);
+    status->busError = ((sta & PWM_STA_BERR) ? 1 : 0);
+    status->running[0] = ((sta & PWM_STA_STA1) ? 1 : 0);
+    status->running[1] = ((sta & PWM_STA_STA2) ? 1 : 0);
+
+    // write 1 to clear
+    if (sta & PWM_STA_ERRORS) { pwm_write(PWM_STA, sta & PWM_STA_ERRORS); }
+
+    return 0;
+}
+
+int RPIHAL_PWM_deinit()
+{
+    int r = 0;
+
+    if (!pwm_base) { return 0; }
+
+    pwm_write(PWM_CTL, PWM_CTL_CLRF);
+    cm_write(CM_PWMCTL, CM_CTL_KILL);
+
+    if (munmap((void*)pwm_base, BCM_BLOCK_SIZE) != 0) { r = -(__LINE__); }
+    if (munmap((void*)cm_base, BCM_BLOCK_SIZE) != 0) { r = -(__LINE__); }
+
+    pwm_base = NULL;
+    cm_base = NULL;
+
+    return r;
+}
+
+
+
+int checkChannel(int ch)
+{
+    if ((ch == 0) || (ch == 1)) { return 1; }
+
+    LOG_ERR("invalid channel: %i", ch);
+
+    return 0;
+}
+
+//! @return Time the hardware needs to output a full FIFO [ns]
+uint64_t fifoDrainTime()
+{
+    // the words are taken alternately if both channels use the FIFO, so each channel gets half of them
+    uint32_t r;
+    uint32_t words = RPIHAL_PWM_FIFO_SIZE;
+
+    if (fifoChannels == 0x03)
+    {
+        r = (range[0] < range[1] ? range[0] : range[1]);
+        words /= 2;
+    }
+    else if (fifoChannels == 0x01) { r = range[0]; }
+    else if (fifoChannels == 0x02) { r = range[1]; }
+    else { r = 0; }
+
+    if ((clockFreq == 0) || (r == 0)) { return 100000; }
+
+    return ((uint64_t)r * words * 1000000000ull) / clockFreq;
+}
@@ -59,6 +59,10 @@ static void readDeviceTreeModel();
 RPIHAL_model_t RPIHAL_getModel()
 {
     static RPIHAL_model_t model = RPIHAL_model_unknown;
+    static int detected = 0; // the detection runs only once, even if the model stays unknown
+
+    if (detected) { return model; }
+    detected = 1;
 
     const char* const dtModel = RPIHAL_dt_model();
 
@@ -0,0 +1,357 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#define _GNU_SOURCE // pthread_setaffinity_np()
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal/platform_check.h"
+#include "internal/util.h"
+#include "rpihal/gpio.h"
+#include "rpihal/softpwm.h"
+
+#include <pthread.h>
+#include <time.h>
+
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INF
+#define LOG_MODULE_NAME  SOFTPWM
+#include "internal/log.h"
+
+
+
+#define LATE_THRESHOLD (10000) // [ns]
+
+// The schedules are exchanged by a triple buffer: the API side builds into `back` and swaps it with `middle`, the timing
+// thread swaps `middle` with `front` at the period boundary if the dirty flag is set. Neither side ever waits.
+#define DIRTY (0x04)
+
+
+
+typedef struct
+{
+    uint64_t offset; // [ns] relative to the period start
+    uint64_t clr;
+} edge_t;
+
+typedef struct
+{
+    uint64_t period; // [ns]
+    uint64_t set;    // set at the period start
+    uint64_t clr;    // cleared at the period start (duty 0)
+    size_t nEdges;
+    edge_t edges[64];
+} schedule_t;
+
+typedef struct
+{
+    pthread_t thread;
+    RPIHAL_SOFTPWM_config_t config;
+    int running;
+
+    schedule_t schedules[3];
+    int front;  // timing thread
+    int middle; // shared, index | DIRTY
+    int back;   // API side
+
+    // API side, protected by the mutex
+    pthread_mutex_t mutex;
+    uint32_t frequency;
+    uint32_t duty[64];
+
+    // statistics, written by the timing thread only
+    uint64_t periods;
+    uint64_t writes;
+    uint64_t late;
+    uint64_t skipped;
+    uint64_t maxError;
+    double sumError;
+} pwm_t;
+
+static void buildSchedule(const pwm_t* pwm, schedule_t* schedule);
+static void publish(pwm_t* pwm);
+static void* timingThread(void* arg);
+
+
+
+void RPIHAL_SOFTPWM_defaultConfig(RPIHAL_SOFTPWM_config_t* config)
+{
+    config->bits = 0;
+    config->frequency = 1000;
+    config->resolution = 1000;
+    config->spin = 100000;
+    config->cpu = -1;
+    config->priority = 0;
+}
+
+int RPIHAL_SOFTPWM_start(RPIHAL_SOFTPWM_instance_t* inst, const RPIHAL_SOFTPWM_config_t* config)
+{
+    inst->pwm = NULL;
+
+    if (!config->bits || (config->frequency == 0) || (config->resolution == 0) || ((1000000000ull / config->frequency) < config->resolution))
+    {
+        LOG_ERR("invalid config");
+        return -(__LINE__);
+    }
+
+    pwm_t* pwm = (pwm_t*)malloc(sizeof(pwm_t));
+    if (!pwm) { return -(__LINE__); }
+    memset(pwm, 0, sizeof(pwm_t));
+
+    pwm->config = *config;
+    pwm->frequency = config->frequency;
+    pwm->front = 0;
+    pwm->middle = 1;
+    pwm->back = 2;
+    pwm->running = 1;
+
+    buildSchedule(pwm, &pwm->schedules[pwm->front]);
+
+    pthread_mutex_init(&pwm->mutex, NULL);
+
+    const int err = pthread_create(&pwm->thread, NULL, timingThread, pwm);
+    if (err)
+    {
+        LOG_ERR("failed to create timing thread (%s)", strerror(err));
+        pthread_mutex_destroy(&pwm->mutex);
+        free(pwm);
+        return -(__LINE__);
+    }
+
+    inst->pwm = pwm;
+
+    LOG_INF("started 0x%016llx at %uHz", (unsigned long long)config->bits, config->frequency);
+
+    return 0;
+}
+
+int RPIHAL_SOFTPWM_setDuty(RPIHAL_SOFTPWM_instance_t* inst, uint64_t bits, uint32_t duty)
+{
+    pwm_t* pwm = (pwm_t*)(inst->pwm);
+
+    if (!pwm) { return -(__LINE__); }
+
+    if ((bits & ~pwm->config.bits) || (duty > RPIHAL_SOFTPWM_DUTY_MAX))
+    {
+        LOG_ERR("invalid channels 0x%016llx or duty %u", (unsigned long long)bits, duty);
+        return -(__LINE__);
+    }
+
+    pthread_mutex_lock(&pwm->mutex);
+
+    for (int pin = 0; pin < 64; ++pin)
+    {
+        if (bits & RPIHAL_GPIO_BIT(pin)) { pwm->duty[pin] = duty; }
+    }
+
+    publish(pwm);
+
+    pthread_mutex_unlock(&pwm->mutex);
+
+    return 0;
+}
+
+int RPIHAL_SOFTPWM_setFrequency(RPIHAL_SOFTPWM_instance_t* inst, uint32_t frequency)
+{
+    pwm_t* pwm = (pwm_t*)(inst->pwm);
+
+    if (!pwm) { return -(__LINE__); }
+
+    if ((frequency == 0) || ((1000000000ull / frequency) < pwm->config.resolution))
+    {
+        LOG_ERR("invalid frequency %uHz", frequency);
+        return -(__LINE__);
+    }
+
+    pthread_mutex_lock(&pwm->mutex);
+
+    pwm->frequency = frequency;
+    publish(pwm);
+
+    pthread_mutex_unlock(&pwm->mutex);
+
+    return 0;
+}
+
+int RPIHAL_SOFTPWM_getStats(const RPIHAL_SOFTPWM_instance_t* inst, RPIHAL_SOFTPWM_stats_t* stats)
+{
+    const pwm_t* pwm = (const pwm_t*)(inst->pwm);
+
+    if (!pwm) { return -(__LINE__); }
+
+    double sum;
+    __atomic_load(&pwm->sumError, &sum, __ATOMIC_RELAXED);
+
+    stats->periods = __atomic_load_n(&pwm->periods, __ATOMIC_RELAXED);
+    stats->writes = __atomic_load_n(&pwm->writes, __ATOMIC_RELAXED);
+    stats->late = __atomic_load_n(&pwm->late, __ATOMIC_RELAXED);
+    stats->skipped = __atomic_load_n(&pwm->skipped, __ATOMIC_RELAXED);
+    stats->maxError = __atomic_load_n(&pwm->maxError, __ATOMIC_RELAXED);
+    stats->meanError = (stats->writes ? (sum / (double)(stats->writes)) : 0);
+    stats->running = __atomic_load_n(&pwm->running, __ATOMIC_ACQUIRE);
+
+    return 0;
+}
+
+int RPIHAL_SOFTPWM_stop(RPIHAL_SOFTPWM_instance_t* inst)
+{
+    int r = 0;
+    pwm_t* pwm = (pwm_t*)(inst->pwm);
+
+    if (!pwm) { return -(__LINE__); }
+
+    __atomic_store_n(&pwm->running, 0, __ATOMIC_RELEASE);
+
+    const int err = pthread_join(pwm->thread, NULL);
+    if (err)
+    {
+        LOG_ERR("failed to join the timing thread (%s)", strerror(err));
+        r = -(__LINE__);
+    }
+
+    RPIHAL_GPIO_write64(pwm->config.bits, 0);
+
+    pthread_mutex_destroy(&pwm->mutex);
+    free(pwm);
+    inst->pwm = NULL;
+
+    return r;
+}
+
+
+
+void buildSchedule(const pwm_t* pwm, schedule_t* schedule)
+{
+    const uint64_t period = 1000000000ull / pwm->frequency;
+    const uint64_t res = pwm->config.resolution;
+
+    schedule->period = period;
+    schedule->set = 0;
+    schedule->clr = 0;
+    schedule->nEdges = 0;
+
+    for (int pin = 0; pin < 64; ++pin)
+    {
+        const uint64_t bit = RPIHAL_GPIO_BIT(pin);
+
+        if (!(pwm->config.bits & bit)) { continue; }
+
+        const uint64_t offset = ((((period * pwm->duty[pin]) / RPIHAL_SOFTPWM_DUTY_MAX) + (res / 2)) / res) * res;
+
+        if (offset == 0) { schedule->clr |= bit; }
+        else
+        {
+            schedule->set |= bit;
+
+            if (offset < period)
+            {
+                // insert sorted, merge equal edge times
+                size_t i = 0;
+                while ((i < schedule->nEdges) && (schedule->edges[i].offset < offset)) { ++i; }
+
+                if ((i < schedule->nEdges) && (schedule->edges[i].offset == offset)) { schedule->edges[i].clr |= bit; }
+                else
+                {
+                    memmove(schedule->edges + i + 1, schedule->edges + i, (schedule->nEdges - i) * sizeof(edge_t));
+                    schedule->edges[i].offset = offset;
+                    schedule->edges[i].clr = bit;
+                    ++schedule->nEdges;
+                }
+            }
+        }
+    }
+}
+
+void publish(pwm_t* pwm)
+{
+    buildSchedule(pwm, &pwm->schedules[pwm->back]);
+
+    pwm->back = __atomic_exchange_n(&pwm->middle, pwm->back | DIRTY, __ATOMIC_ACQ_REL) & ~DIRTY;
+}
+
+void* timingThread(void* arg)
+{
+    pwm_t* pwm = (pwm_t*)arg;
+    const RPIHAL_SOFTPWM_config_t* config = &pwm->config;
+
+    const int err = UTIL_setThreadSched(config->cpu, config->priority);
+    if (err) { LOG_WRN("failed to set CPU %i and priority %i of the timing thread (%s)", config->cpu, config->priority, strerror(err)); }
+
+    double sum = 0;
+    uint64_t start = UTIL_time_ns(CLOCK_MONOTONIC);
+
+    while (__atomic_load_n(&pwm->running, __ATOMIC_ACQUIRE))
+    {
+        // apply a new schedule only at the period boundary
+        if (__atomic_load_n(&pwm->middle, __ATOMIC_ACQUIRE) & DIRTY)
+        {
+            pwm->front = __atomic_exchange_n(&pwm->middle, pwm->front, __ATOMIC_ACQ_REL) & ~DIRTY;
+        }
+
+        const schedule_t* s = &pwm->schedules[pwm->front];
+
+        for (size_t i = 0; i <= s->nEdges; ++i)
+        {
+            const uint64_t deadline = start + (i ? s->edges[i - 1].offset : 0);
+            const uint64_t t = UTIL_waitUntil_ns(CLOCK_MONOTONIC, deadline, config->spin);
+
+            if (i == 0) { RPIHAL_GPIO_write64(s->set | s->clr, s->set); }
+            else { RPIHAL_GPIO_write64(s->edges[i - 1].clr, 0); }
+
+            const uint64_t error = t - deadline;
+            sum += (double)error;
+
+            __atomic_store_n(&pwm->writes, pwm->writes + 1, __ATOMIC_RELAXED);
+            if (error > LATE_THRESHOLD) { __atomic_store_n(&pwm->late, pwm->late + 1, __ATOMIC_RELAXED); }
+            if (error > pwm->maxError) { __atomic_store_n(&pwm->maxError, error, __ATOMIC_RELAXED); }
+        }
+
+        __atomic_store(&pwm->sumError, &sum, __ATOMIC_RELAXED);
+        __atomic_store_n(&pwm->periods, pwm->periods + 1, __ATOMIC_RELAXED);
+
+        start += s->period;
+
+        // skip the missed periods instead of playing them in a burst
+        const uint64_t t = UTIL_time_ns(CLOCK_MONOTONIC);
+        if (t > (start + s->period))
+        {
+            const uint64_t missed = (t - start) / s->period;
+
+            __atomic_store_n(&pwm->skipped, pwm->skipped + missed, __ATOMIC_RELAXED);
+            start += missed * s->period;
+        }
+    }
+
+    __atomic_store_n(&pwm->running, 0, __ATOMIC_RELEASE);
+
+    return NULL;
+}
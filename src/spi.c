@@ -29,16 +29,20 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <errno.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "internal/platform_check.h"
+#include "internal/spi.h"
 #include "rpihal/rpihal.h"
 #include "rpihal/spi.h"
 
 #include <asm/ioctl.h>
 #include <fcntl.h>
 #include <linux/spi/spidev.h>
+#include <pthread.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 
@@ -48,14 +52,85 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
 
+#define BUFSIZ_PARAM_FILE "/sys/module/spidev/parameters/bufsiz"
+
+#define DEVICES_MAX   (16)
+#define MODE_UNKNOWN  (0xFFFFFFFF)
+#define LOOPBACK_FLAG (0x8000000000000000ull) // loopback keys are a hash of the name, spidev keys the device number
+
+
+
+// The mode is a setting of the device, not of the file descriptor (see ANOM2). The mode currently applied to each
+// device is tracked, an instance re-applies its mode only if another instance on the same device changed it. The mutex
+// of the device is held from the mode check until the message is done.
+typedef struct
+{
+    uint64_t key;
+    int refs;
+    uint32_t mode;
+    uint64_t modeSwitches;
+    pthread_mutex_t mutex;
+} device_t;
+
+static pthread_mutex_t devicesMutex = PTHREAD_MUTEX_INITIALIZER;
+static device_t devices[DEVICES_MAX];
+
+static int attachDevice(uint64_t key);
+static void detachDevice(int device);
+static int applyMode(const RPIHAL_SPI_instance_t* inst);
+static uint32_t configToMode(uint32_t config);
+static uint64_t hashName(const char* name);
+static size_t readBufsiz();
+static int message(const RPIHAL_SPI_instance_t* inst, struct spi_ioc_transfer* transfers, size_t count);
+static int loopbackMessage(const struct spi_ioc_transfer* transfers, size_t count);
+
+
+
 int RPIHAL_SPI_open(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSpeed, uint32_t config)
+{
+    return RPIHAL_SPI_openBackend(inst, dev, maxSpeed, config, RPIHAL_SPI_BACKEND_SPIDEV);
+}
+
+int RPIHAL_SPI_openBackend(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSpeed, uint32_t config, int backend)
 {
     int fd;
     inst->dev[0] = 0;
     inst->fd = -1;
+    inst->backend = RPIHAL_SPI_BACKEND_SPIDEV;
+    inst->mode = configToMode(config);
+    inst->device = -1;
 
     errno = 0;
 
+    if (backend == RPIHAL_SPI_BACKEND_LOOPBACK)
+    {
+        const int device = attachDevice(hashName(dev) | LOOPBACK_FLAG);
+        if (device < 0) { return -(__LINE__); }
+
+        // the mode has no effect on the loopback, it's only tracked
+        pthread_mutex_lock(&devices[device].mutex);
+        devices[device].mode = inst->mode;
+        pthread_mutex_unlock(&devices[device].mutex);
+
+        LOG_INF("opened \"%s\" loopback, mode: %04x, speed: %uHz", dev, inst->mode, maxSpeed);
+
+        inst->speed = maxSpeed;
+        inst->bits = 8;
+        inst->backend = backend;
+        inst->bufsiz = RPIHAL_SPI_BUFSIZ_DEFAULT;
+        inst->device = device;
+
+        strncpy(inst->dev, dev, RPIHAL_SPI_INSTANCE_DEV_SIZE);
+        inst->dev[RPIHAL_SPI_INSTANCE_DEV_SIZE - 1] = 0;
+
+        return 0;
+    }
+    else if (backend != RPIHAL_SPI_BACKEND_SPIDEV)
+    {
+        LOG_ERR("invalid backend: %i", backend);
+        return -(__LINE__);
+    }
+
     fd = open(dev, O_RDWR);
     if (fd < 0)
     {
@@ -67,29 +142,40 @@ int RPIHAL_SPI_open(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSp
         int ret = 0;
         errno = 0;
 
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            LOG_ERR("failed to stat \"%s\" (%s)", dev, strerror(errno));
+            close(fd);
+            return -(__LINE__);
+        }
 
+        const int device = attachDevice((uint64_t)(st.st_rdev));
+        if (device < 0)
+        {
+            close(fd);
+            return -(__LINE__);
+        }
 
-        // ioctl SPI mode
-
-        uint32_t modeFlags = 0;
-
-        // modeFlags |= SPI_LOOP;
 
-        if (config & RPIHAL_SPI_CFG_CPHA) { modeFlags |= SPI_CPHA; }
-        if (config & RPIHAL_SPI_CFG_CPOL) { modeFlags |= SPI_CPOL; }
 
-        if (config & RPIHAL_SPI_CFG_LSB_FIRST) { modeFlags |= SPI_LSB_FIRST; }
+        // ioctl SPI mode
 
-        if (config & RPIHAL_SPI_CFG_CS_HIGH) { modeFlags |= SPI_CS_HIGH; }
-        if (config & RPIHAL_SPI_CFG_HALFDUPLEX) { modeFlags |= SPI_3WIRE; }
+        uint32_t modeFlags = inst->mode;
 
-        if (config & RPIHAL_SPI_CFG_NO_CS) { modeFlags |= SPI_NO_CS; }
+        pthread_mutex_lock(&devices[device].mutex);
 
         const uint32_t modeFlagsReq = modeFlags;
         ret = ioctl(fd, SPI_IOC_WR_MODE32, &modeFlags);
+        devices[device].mode = ((ret < 0) ? MODE_UNKNOWN : modeFlagsReq);
+
+        pthread_mutex_unlock(&devices[device].mutex);
+
         if (ret < 0)
         {
             LOG_ERR("failed to config mode (%s)", strerror(errno));
+            detachDevice(device);
+            close(fd);
             return -(__LINE__);
         }
 
@@ -105,6 +191,8 @@ int RPIHAL_SPI_open(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSp
         if (ret < 0)
         {
             LOG_ERR("failed to config tx bits per word (%s)", strerror(errno));
+            detachDevice(device);
+            close(fd);
             return -(__LINE__);
         }
 
@@ -112,6 +200,8 @@ int RPIHAL_SPI_open(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSp
         if (ret < 0)
         {
             LOG_ERR("failed to config rx bits per word (%s)", strerror(errno));
+            detachDevice(device);
+            close(fd);
             return -(__LINE__);
         }
 
@@ -123,6 +213,8 @@ int RPIHAL_SPI_open(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSp
         if (ret < 0)
         {
             LOG_ERR("failed to config tx speed (%s)", strerror(errno));
+            detachDevice(device);
+            close(fd);
             return -(__LINE__);
         }
 
@@ -130,6 +222,8 @@ int RPIHAL_SPI_open(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSp
         if (ret < 0)
         {
             LOG_ERR("failed to config rx speed (%s)", strerror(errno));
+            detachDevice(device);
+            close(fd);
             return -(__LINE__);
         }
 
@@ -139,6 +233,8 @@ int RPIHAL_SPI_open(RPIHAL_SPI_instance_t* inst, const char* dev, uint32_t maxSp
 
         inst->speed = maxSpeed;
         inst->bits = nBits;
+        inst->bufsiz = readBufsiz();
+        inst->device = device;
 
         strncpy(inst->dev, dev, RPIHAL_SPI_INSTANCE_DEV_SIZE);
         inst->dev[RPIHAL_SPI_INSTANCE_DEV_SIZE - 1] = 0;
@@ -157,18 +253,78 @@ int RPIHAL_SPI_transfer(const RPIHAL_SPI_instance_t* inst, const uint8_t* txData
 
     memset(&transfer, 0, sizeof(transfer));
 
-    transfer.tx_buf = (uintptr_t)txData;
-    transfer.rx_buf = (uintptr_t)rxBuffer;
-    transfer.len = count;
     transfer.delay_usecs = 0;
     transfer.speed_hz = inst->speed;
     transfer.bits_per_word = inst->bits;
 
-    const int ret = ioctl(inst->fd, SPI_IOC_MESSAGE(1), &transfer);
+    // spidev rejects messages larger than bufsiz
+    size_t offset = 0;
 
-    if ((ret < 0) || (ret != (int)count))
+    do
     {
-        LOG_ERR("failed to transfer %u bytes (%s, ioctl ret: %i)", count, strerror(errno), ret);
+        const size_t len = ((count - offset) < inst->bufsiz ? (count - offset) : inst->bufsiz);
+
+        transfer.tx_buf = (txData ? (uintptr_t)(txData + offset) : 0);
+        transfer.rx_buf = (rxBuffer ? (uintptr_t)(rxBuffer + offset) : 0);
+        transfer.len = len;
+
+        const int ret = message(inst, &transfer, 1);
+
+        if ((ret < 0) || (ret != (int)len))
+        {
+            LOG_ERR("failed to transfer %zu bytes at offset %zu (%s, ioctl ret: %i)", len, offset, strerror(errno), ret);
+            return -(__LINE__);
+        }
+
+        offset += len;
+    }
+    while (offset < count);
+
+    return 0;
+}
+
+int RPIHAL_SPI_transaction(const RPIHAL_SPI_instance_t* inst, const RPIHAL_SPI_segment_t* segments, size_t count)
+{
+    errno = 0;
+
+    if ((count == 0) || (count > RPIHAL_SPI_SEGMENTS_MAX))
+    {
+        LOG_ERR("invalid number of segments: %zu", count);
+        return -(__LINE__);
+    }
+
+    struct spi_ioc_transfer transfers[RPIHAL_SPI_SEGMENTS_MAX];
+    size_t total = 0;
+
+    memset(transfers, 0, count * sizeof(transfers[0]));
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const RPIHAL_SPI_segment_t* const seg = segments + i;
+        struct spi_ioc_transfer* const transfer = transfers + i;
+
+        transfer->tx_buf = (uintptr_t)(seg->txData);
+        transfer->rx_buf = (uintptr_t)(seg->rxBuffer);
+        transfer->len = seg->count;
+        transfer->delay_usecs = seg->delay;
+        transfer->speed_hz = (seg->speed ? seg->speed : inst->speed);
+        transfer->bits_per_word = (seg->bits ? seg->bits : inst->bits);
+        transfer->cs_change = (seg->csChange ? 1 : 0);
+
+        total += seg->count;
+    }
+
+    if (total > inst->bufsiz)
+    {
+        LOG_ERR("transaction of %zu bytes exceeds bufsiz (%zu)", total, inst->bufsiz);
+        return -(__LINE__);
+    }
+
+    const int ret = message(inst, transfers, count);
+
+    if ((ret < 0) || (ret != (int)total))
+    {
+        LOG_ERR("failed to transfer %zu segments, %zu bytes (%s, ioctl ret: %i)", count, total, strerror(errno), ret);
         return -(__LINE__);
     }
 
@@ -179,7 +335,15 @@ int RPIHAL_SPI_close(RPIHAL_SPI_instance_t* inst)
 {
     errno = 0;
 
-    if (inst->fd >= 0)
+    if (inst->backend == RPIHAL_SPI_BACKEND_LOOPBACK)
+    {
+        LOG_INF("closed \"%s\"", inst->dev);
+        detachDevice(inst->device);
+        inst->dev[0] = 0;
+        inst->backend = RPIHAL_SPI_BACKEND_SPIDEV;
+        inst->device = -1;
+    }
+    else if (inst->fd >= 0)
     {
         int err;
 
@@ -192,11 +356,224 @@ int RPIHAL_SPI_close(RPIHAL_SPI_instance_t* inst)
         else
         {
             LOG_INF("closed \"%s\"", inst->dev);
+            detachDevice(inst->device);
             inst->dev[0] = 0;
             inst->fd = -1;
+            inst->device = -1;
         }
     }
     else { LOG_WRN("device is not open"); }
 
     return 0;
 }
+
+
+
+uint64_t RPIHAL_SPI_getModeSwitches(const RPIHAL_SPI_instance_t* inst)
+{
+    uint64_t r = 0;
+
+    if ((inst->device >= 0) && (inst->device < DEVICES_MAX))
+    {
+        pthread_mutex_lock(&devices[inst->device].mutex);
+        r = devices[inst->device].modeSwitches;
+        pthread_mutex_unlock(&devices[inst->device].mutex);
+    }
+
+    return r;
+}
+
+int RPIHAL_SPI_poolCreate(RPIHAL_SPI_pool_t* pool, const RPIHAL_SPI_instance_t* inst, size_t count) { return iSPI_poolCreate(pool, inst->bufsiz, count); }
+uint8_t* RPIHAL_SPI_poolGet(RPIHAL_SPI_pool_t* pool) { return iSPI_poolGet(pool); }
+void RPIHAL_SPI_poolPut(RPIHAL_SPI_pool_t* pool, uint8_t* buffer) { iSPI_poolPut(pool, buffer); }
+void RPIHAL_SPI_poolDestroy(RPIHAL_SPI_pool_t* pool) { iSPI_poolDestroy(pool); }
+
+
+
+//! @return Index of the device, __negative__ if the table is full
+int attachDevice(uint64_t key)
+{
+    int device = -1;
+    int empty = -1;
+
+    pthread_mutex_lock(&devicesMutex);
+
+    for (int i = 0; (i < DEVICES_MAX) && (device < 0); ++i)
+    {
+        if (devices[i].refs > 0)
+        {
+            if (devices[i].key == key) { device = i; }
+        }
+        else if (empty < 0) { empty = i; }
+    }
+
+    if ((device < 0) && (empty >= 0))
+    {
+        device = empty;
+
+        devices[device].key = key;
+        devices[device].refs = 0;
+        devices[device].mode = MODE_UNKNOWN;
+        devices[device].modeSwitches = 0;
+        pthread_mutex_init(&devices[device].mutex, NULL);
+    }
+
+    if (device >= 0) { ++(devices[device].refs); }
+    else { LOG_ERR("too many SPI devices open (max %i)", DEVICES_MAX); }
+
+    pthread_mutex_unlock(&devicesMutex);
+
+    return device;
+}
+
+void detachDevice(int device)
+{
+    if ((device < 0) || (device >= DEVICES_MAX)) { return; }
+
+    pthread_mutex_lock(&devicesMutex);
+
+    --(devices[device].refs);
+    if (devices[device].refs <= 0)
+    {
+        devices[device].refs = 0;
+        pthread_mutex_destroy(&devices[device].mutex);
+    }
+
+    pthread_mutex_unlock(&devicesMutex);
+}
+
+/**
+ * @brief Applies the mode of the instance to the device, if it differs from the currently applied one.
+ *
+ * The mutex of the device has to be locked.
+ *
+ * @return __0__ on success, __negative__ on failure
+ */
+int applyMode(const RPIHAL_SPI_instance_t* inst)
+{
+    device_t* const device = devices + inst->device;
+
+    if (device->mode != inst->mode)
+    {
+        if (inst->backend == RPIHAL_SPI_BACKEND_SPIDEV)
+        {
+            uint32_t mode = inst->mode;
+
+            if (ioctl(inst->fd, SPI_IOC_WR_MODE32, &mode) < 0)
+            {
+                device->mode = MODE_UNKNOWN;
+                LOG_ERR("failed to config mode (%s)", strerror(errno));
+                return -(__LINE__);
+            }
+        }
+
+        device->mode = inst->mode;
+        ++(device->modeSwitches);
+    }
+
+    return 0;
+}
+
+uint32_t configToMode(uint32_t config)
+{
+    uint32_t modeFlags = 0;
+
+    // modeFlags |= SPI_LOOP;
+
+    if (config & RPIHAL_SPI_CFG_CPHA) { modeFlags |= SPI_CPHA; }
+    if (config & RPIHAL_SPI_CFG_CPOL) { modeFlags |= SPI_CPOL; }
+
+    if (config & RPIHAL_SPI_CFG_LSB_FIRST) { modeFlags |= SPI_LSB_FIRST; }
+
+    if (config & RPIHAL_SPI_CFG_CS_HIGH) { modeFlags |= SPI_CS_HIGH; }
+    if (config & RPIHAL_SPI_CFG_HALFDUPLEX) { modeFlags |= SPI_3WIRE; }
+
+    if (config & RPIHAL_SPI_CFG_NO_CS) { modeFlags |= SPI_NO_CS; }
+
+    return modeFlags;
+}
+
+//! FNV-1a
+uint64_t hashName(const char* name)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    while (*name)
+    {
+        hash ^= (uint8_t)(*name);
+        hash *= 0x00000100000001B3ull;
+        ++name;
+    }
+
+    return hash;
+}
+
+size_t readBufsiz()
+{
+    size_t bufsiz = RPIHAL_SPI_BUFSIZ_DEFAULT;
+    unsigned long value = 0;
+
+    FILE* fp = fopen(BUFSIZ_PARAM_FILE, "r");
+
+    if (fp)
+    {
+        if ((fscanf(fp, "%lu", &value) == 1) && (value > 0)) { bufsiz = (size_t)value; }
+        fclose(fp);
+    }
+    else { LOG_WRN("failed to read \"" BUFSIZ_PARAM_FILE "\", using bufsiz %zu", bufsiz); }
+
+    return bufsiz;
+}
+
+/**
+ * @brief Submits the transfers as one message.
+ *
+ * @return Number of transferred bytes, negative on failure (like the ioctl)
+ */
+int message(const RPIHAL_SPI_instance_t* inst, struct spi_ioc_transfer* transfers, size_t count)
+{
+    int ret;
+
+    if ((inst->device < 0) || (inst->device >= DEVICES_MAX))
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    pthread_mutex_lock(&devices[inst->device].mutex);
+
+    if (applyMode(inst) != 0) { ret = -1; }
+    else if (inst->backend == RPIHAL_SPI_BACKEND_LOOPBACK) { ret = loopbackMessage(transfers, count); }
+    else { ret = ioctl(inst->fd, SPI_IOC_MESSAGE(count), transfers); }
+
+    pthread_mutex_unlock(&devices[inst->device].mutex);
+
+    return ret;
+}
+
+int loopbackMessage(const struct spi_ioc_transfer* transfers, size_t count)
+{
+    int n = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint8_t* const tx = (const uint8_t*)(uintptr_t)(transfers[i].tx_buf);
+        uint8_t* const rx = (uint8_t*)(uintptr_t)(transfers[i].rx_buf);
+        const size_t len = transfers[i].len;
+
+        if (rx)
+        {
+            if (tx) { memmove(rx, tx, len); }
+            else { memset(rx, 0, len); }
+        }
+
+        n += (int)len;
+    }
+
+    return n;
+}
+
+
+
+#define iSPI_DEFINE_FUNCTIONS
+#include "internal/spi.h"
@@ -0,0 +1,365 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#define _GNU_SOURCE // pthread_setaffinity_np()
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal/platform_check.h"
+#include "internal/ring.h"
+#include "internal/util.h"
+#include "rpihal/spi.h"
+#include "rpihal/spiadc.h"
+
+#include <pthread.h>
+#include <time.h>
+
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INF
+#define LOG_MODULE_NAME  SPIADC
+#include "internal/log.h"
+
+
+
+#define FRAME_SIZE (3) // bytes per conversion, the same for all supported devices
+
+#define SPIN_RATE_MIN (10000) // [Hz] busy wait the whole period at and above this message rate
+#define SPIN_TIME     (60000) // [ns] busy wait time at lower rates
+
+
+
+typedef struct
+{
+    iRING_t ring;
+    pthread_t thread;
+    RPIHAL_SPIADC_config_t config;
+    int running;
+
+    // precomputed message, `nChannels * scansPerMessage` segments
+    RPIHAL_SPI_segment_t segments[RPIHAL_SPI_SEGMENTS_MAX];
+    uint8_t tx[RPIHAL_SPI_SEGMENTS_MAX * FRAME_SIZE];
+    uint8_t rx[RPIHAL_SPI_SEGMENTS_MAX * FRAME_SIZE];
+
+    // statistics, written by the sampling thread only
+    uint64_t scans;
+    uint64_t messages;
+    uint64_t late;
+    uint64_t maxLateness;
+    int error;
+} sampler_t;
+
+static void buildFrame(int device, uint8_t channel, uint8_t* frame);
+static uint16_t decodeFrame(int device, const uint8_t* frame);
+static void* samplerThread(void* arg);
+
+
+
+void RPIHAL_SPIADC_defaultConfig(RPIHAL_SPIADC_config_t* config)
+{
+    config->spi = NULL;
+    config->device = RPIHAL_SPIADC_DEVICE_MCP3208;
+    for (size_t i = 0; i < RPIHAL_SPIADC_CHANNELS_MAX; ++i) { config->channels[i] = (uint8_t)i; }
+    config->nChannels = RPIHAL_SPIADC_CHANNELS_MAX;
+    config->scansPerMessage = RPIHAL_SPI_SEGMENTS_MAX / RPIHAL_SPIADC_CHANNELS_MAX;
+    config->rate = 1000;
+    config->nScans = 0;
+    config->capacity = 4096;
+    config->cpu = -1;
+    config->priority = 0;
+}
+
+int RPIHAL_SPIADC_start(RPIHAL_SPIADC_instance_t* inst, const RPIHAL_SPIADC_config_t* config)
+{
+    inst->config = *config;
+    inst->sampler = NULL;
+
+    if (!config->spi)
+    {
+        LOG_ERR("no SPI instance");
+        return -(__LINE__);
+    }
+
+    if ((config->device != RPIHAL_SPIADC_DEVICE_MCP3208) && (config->device != RPIHAL_SPIADC_DEVICE_MCP3008))
+    {
+        LOG_ERR("invalid device: %i", config->device);
+        return -(__LINE__);
+    }
+
+    if ((config->nChannels == 0) || (config->nChannels > RPIHAL_SPIADC_CHANNELS_MAX) || (config->scansPerMessage == 0) ||
+        ((config->nChannels * config->scansPerMessage) > RPIHAL_SPI_SEGMENTS_MAX))
+    {
+        LOG_ERR("invalid number of channels (%zu) or scans per message (%zu)", config->nChannels, config->scansPerMessage);
+        return -(__LINE__);
+    }
+
+    // the message period is integer nanoseconds, the ring capacity is rounded up to a power of two
+    if ((config->rate > (1000000000ull * config->scansPerMessage)) || (config->capacity > ((SIZE_MAX / 2) / sizeof(RPIHAL_SPIADC_scan_t))))
+    {
+        LOG_ERR("invalid rate (%u) or capacity (%zu)", config->rate, config->capacity);
+        return -(__LINE__);
+    }
+
+    for (size_t i = 0; i < config->nChannels; ++i)
+    {
+        if (config->channels[i] >= RPIHAL_SPIADC_CHANNELS_MAX)
+        {
+            LOG_ERR("invalid channel: %i", (int)(config->channels[i]));
+            return -(__LINE__);
+        }
+    }
+
+    sampler_t* sampler = NULL;
+
+    // the ring needs cache line alignment
+    if (posix_memalign((void**)(&sampler), iRING_CACHE_LINE, sizeof(sampler_t)) != 0) { return -(__LINE__); }
+    memset(sampler, 0, sizeof(sampler_t));
+
+    sampler->config = *config;
+
+    const size_t nSegments = config->nChannels * config->scansPerMessage;
+
+    for (size_t i = 0; i < nSegments; ++i)
+    {
+        RPIHAL_SPI_segment_t* const seg = sampler->segments + i;
+
+        buildFrame(config->device, config->channels[i % config->nChannels], sampler->tx + (i * FRAME_SIZE));
+
+        // the conversion starts on the falling edge of chip select, so every frame needs its own
+        seg->txData = sampler->tx + (i * FRAME_SIZE);
+        seg->rxBuffer = sampler->rx + (i * FRAME_SIZE);
+        seg->count = FRAME_SIZE;
+        seg->csChange = ((i + 1) < nSegments ? 1 : 0);
+    }
+
+    if (iRING_init(&sampler->ring, sizeof(RPIHAL_SPIADC_scan_t), config->capacity) != 0)
+    {
+        free(sampler);
+        LOG_ERR("failed to allocate buffer of %zu scans", config->capacity);
+        return -(__LINE__);
+    }
+
+    // touch the buffer to have it faulted in before sampling
+    memset(sampler->ring.buffer, 0, sampler->ring.capacity * sampler->ring.elementSize);
+
+    sampler->running = 1;
+
+    const int err = pthread_create(&sampler->thread, NULL, samplerThread, sampler);
+    if (err)
+    {
+        LOG_ERR("failed to create sampling thread (%s)", strerror(err));
+        iRING_destroy(&sampler->ring);
+        free(sampler);
+        return -(__LINE__);
+    }
+
+    inst->sampler = sampler;
+
+    LOG_INF("started sampling of %zu channels at %uHz, %zu scans per message", config->nChannels, config->rate, config->scansPerMessage);
+
+    return 0;
+}
+
+size_t RPIHAL_SPIADC_read(RPIHAL_SPIADC_instance_t* inst, RPIHAL_SPIADC_scan_t* scans, size_t count)
+{
+    sampler_t* sampler = (sampler_t*)(inst->sampler);
+
+    if (!sampler) { return 0; }
+
+    return iRING_pop(&sampler->ring, scans, count);
+}
+
+int RPIHAL_SPIADC_getStats(const RPIHAL_SPIADC_instance_t* inst, RPIHAL_SPIADC_stats_t* stats)
+{
+    const sampler_t* sampler = (const sampler_t*)(inst->sampler);
+
+    if (!sampler) { return -(__LINE__); }
+
+    stats->scans = __atomic_load_n(&sampler->scans, __ATOMIC_RELAXED);
+    stats->messages = __atomic_load_n(&sampler->messages, __ATOMIC_RELAXED);
+    stats->overflows = __atomic_load_n(&sampler->ring.overflows, __ATOMIC_RELAXED);
+    stats->late = __atomic_load_n(&sampler->late, __ATOMIC_RELAXED);
+    stats->maxLateness = __atomic_load_n(&sampler->maxLateness, __ATOMIC_RELAXED);
+    stats->error = __atomic_load_n(&sampler->error, __ATOMIC_RELAXED);
+    stats->running = __atomic_load_n(&sampler->running, __ATOMIC_ACQUIRE);
+
+    return 0;
+}
+
+int RPIHAL_SPIADC_stop(RPIHAL_SPIADC_instance_t* inst)
+{
+    int r = 0;
+    sampler_t* sampler = (sampler_t*)(inst->sampler);
+
+    if (!sampler) { return -(__LINE__); }
+
+    __atomic_store_n(&sampler->running, 0, __ATOMIC_RELEASE);
+
+    const int err = pthread_join(sampler->thread, NULL);
+    if (err)
+    {
+        LOG_ERR("failed to join the sampling thread (%s)", strerror(err));
+        r = -(__LINE__);
+    }
+
+    LOG_INF("stopped sampling, %llu scans, %llu messages", (unsigned long long)sampler->scans, (unsigned long long)sampler->messages);
+
+    iRING_destroy(&sampler->ring);
+    free(sampler);
+    inst->sampler = NULL;
+
+    return r;
+}
+
+
+
+void buildFrame(int device, uint8_t channel, uint8_t* frame)
+{
+    if (device == RPIHAL_SPIADC_DEVICE_MCP3008)
+    {
+        // start bit, single ended, D2..D0 in the second byte
+        frame[0] = 0x01;
+        frame[1] = (uint8_t)(0x80 | ((channel & 0x07) << 4));
+        frame[2] = 0x00;
+    }
+    else
+    {
+        // start bit, single ended, D2 in the first byte, D1..D0 in the second byte (result aligned to byte 1 and 2)
+        frame[0] = (uint8_t)(0x06 | ((channel >> 2) & 0x01));
+        frame[1] = (uint8_t)((channel & 0x03) << 6);
+        frame[2] = 0x00;
+    }
+}
+
+uint16_t decodeFrame(int device, const uint8_t* frame)
+{
+    if (device == RPIHAL_SPIADC_DEVICE_MCP3008) { return (uint16_t)(((frame[1] & 0x03) << 8) | frame[2]); }
+
+    return (uint16_t)(((frame[1] & 0x0F) << 8) | frame[2]);
+}
+
+void* samplerThread(void* arg)
+{
+    sampler_t* sampler = (sampler_t*)arg;
+    const RPIHAL_SPIADC_config_t* config = &sampler->config;
+
+    const int err = UTIL_setThreadSched(config->cpu, config->priority);
+    if (err) { LOG_WRN("failed to set CPU %i and priority %i of the sampling thread (%s)", config->cpu, config->priority, strerror(err)); }
+
+    const size_t nCh = config->nChannels;
+    const size_t spm = config->scansPerMessage;
+
+    // the thread wakes up once per message
+    const uint32_t rate = config->rate;
+    const uint64_t period = (rate ? ((1000000000ull * spm) / rate) : 0);
+    const uint64_t periodRem = (rate ? ((1000000000ull * spm) % rate) : 0); // distributed over the periods to avoid drift
+    const uint64_t spin = ((rate / spm) >= SPIN_RATE_MIN ? period : SPIN_TIME);
+
+    RPIHAL_SPIADC_scan_t scans[RPIHAL_SPI_SEGMENTS_MAX];
+    uint64_t nScans = 0;
+    uint64_t messages = 0;
+    uint64_t frac = 0;
+
+    memset(scans, 0, sizeof(scans));
+
+    const uint64_t t0 = UTIL_time_ns(CLOCK_MONOTONIC);
+    uint64_t next = t0;
+
+    while (__atomic_load_n(&sampler->running, __ATOMIC_ACQUIRE) && ((config->nScans == 0) || (nScans < config->nScans)))
+    {
+        if (rate)
+        {
+            const uint64_t t = UTIL_waitUntil_ns(CLOCK_MONOTONIC, next, spin);
+
+            const uint64_t lateness = t - next;
+
+            if (lateness > period)
+            {
+                // skip the missed slots instead of sampling them in a burst
+                const uint64_t missed = lateness / period;
+
+                __atomic_store_n(&sampler->late, sampler->late + missed, __ATOMIC_RELAXED);
+                next += missed * period;
+            }
+
+            if (lateness > sampler->maxLateness) { __atomic_store_n(&sampler->maxLateness, lateness, __ATOMIC_RELAXED); }
+
+            next += period;
+            frac += periodRem;
+            if (frac >= rate)
+            {
+                frac -= rate;
+                ++next;
+            }
+        }
+
+        // the last message may be shorter
+        size_t n = spm;
+        if ((config->nScans != 0) && ((config->nScans - nScans) < n)) { n = (size_t)(config->nScans - nScans); }
+
+        // cs_change on the last segment would leave chip select asserted
+        sampler->segments[(n * nCh) - 1].csChange = 0;
+
+        const uint64_t tStart = UTIL_time_ns(CLOCK_MONOTONIC);
+        const int res = RPIHAL_SPI_transaction(config->spi, sampler->segments, n * nCh);
+        const uint64_t tEnd = UTIL_time_ns(CLOCK_MONOTONIC);
+
+        if (n < spm) { sampler->segments[(n * nCh) - 1].csChange = 1; }
+
+        if (res != 0)
+        {
+            LOG_ERR("transfer failed, stopping");
+            __atomic_store_n(&sampler->error, 1, __ATOMIC_RELAXED);
+            break;
+        }
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            scans[i].timestamp = (tStart - t0) + (((tEnd - tStart) * i) / n);
+
+            for (size_t ch = 0; ch < nCh; ++ch)
+            {
+                scans[i].value[ch] = decodeFrame(config->device, sampler->rx + (((i * nCh) + ch) * FRAME_SIZE));
+            }
+        }
+
+        iRING_push(&sampler->ring, scans, n);
+
+        nScans += n;
+        ++messages;
+        __atomic_store_n(&sampler->scans, nScans, __ATOMIC_RELAXED);
+        __atomic_store_n(&sampler->messages, messages, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&sampler->running, 0, __ATOMIC_RELEASE);
+
+    return NULL;
+}
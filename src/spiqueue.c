@@ -0,0 +1,299 @@
+/*
+author          Oliver Blaser
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+
+Copyright (c) 2026 Oliver Blaser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#define _GNU_SOURCE // pthread_setaffinity_np()
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal/platform_check.h"
+#include "internal/util.h"
+#include "rpihal/spi.h"
+#include "rpihal/spiqueue.h"
+
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INF
+#define LOG_MODULE_NAME  SPIQUEUE
+#include "internal/log.h"
+
+
+
+typedef struct
+{
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond; // signaled on submit and stop
+    pthread_cond_t idle; // signaled when the last pending request is completed
+    RPIHAL_SPIQUEUE_config_t config;
+    int running;
+    int fd; // eventfd
+
+    // bounded FIFO, protected by `mutex`
+    RPIHAL_SPIQUEUE_request_t* buffer;
+    size_t head;
+    size_t count;
+    size_t pending; // queued and in progress
+
+    // statistics, protected by `mutex`
+    RPIHAL_SPIQUEUE_stats_t stats;
+} queue_t;
+
+static void* workerThread(void* arg);
+
+
+
+void RPIHAL_SPIQUEUE_defaultConfig(RPIHAL_SPIQUEUE_config_t* config)
+{
+    config->capacity = 64;
+    config->cpu = -1;
+    config->priority = 0;
+}
+
+int RPIHAL_SPIQUEUE_create(RPIHAL_SPIQUEUE_instance_t* inst, const RPIHAL_SPIQUEUE_config_t* config)
+{
+    inst->queue = NULL;
+
+    if (config->capacity == 0)
+    {
+        LOG_ERR("invalid capacity");
+        return -(__LINE__);
+    }
+
+    queue_t* queue = (queue_t*)malloc(sizeof(queue_t));
+    if (!queue) { return -(__LINE__); }
+    memset(queue, 0, sizeof(queue_t));
+
+    queue->config = *config;
+
+    queue->buffer = (RPIHAL_SPIQUEUE_request_t*)malloc(config->capacity * sizeof(RPIHAL_SPIQUEUE_request_t));
+    if (!queue->buffer)
+    {
+        free(queue);
+        LOG_ERR("failed to allocate queue of %zu requests", config->capacity);
+        return -(__LINE__);
+    }
+
+    errno = 0;
+    queue->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (queue->fd < 0)
+    {
+        LOG_ERR("failed to create eventfd (%s)", strerror(errno));
+        free(queue->buffer);
+        free(queue);
+        return -(__LINE__);
+    }
+
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+    pthread_cond_init(&queue->idle, NULL);
+
+    queue->running = 1;
+
+    const int err = pthread_create(&queue->thread, NULL, workerThread, queue);
+    if (err)
+    {
+        LOG_ERR("failed to create worker thread (%s)", strerror(err));
+        pthread_cond_destroy(&queue->idle);
+        pthread_cond_destroy(&queue->cond);
+        pthread_mutex_destroy(&queue->mutex);
+        close(queue->fd);
+        free(queue->buffer);
+        free(queue);
+        return -(__LINE__);
+    }
+
+    inst->queue = queue;
+
+    return 0;
+}
+
+int RPIHAL_SPIQUEUE_submit(RPIHAL_SPIQUEUE_instance_t* inst, const RPIHAL_SPIQUEUE_request_t* request)
+{
+    int r = 0;
+    queue_t* queue = (queue_t*)(inst->queue);
+
+    if (!queue || !request->spi) { return -(__LINE__); }
+
+    pthread_mutex_lock(&queue->mutex);
+
+    if (!queue->running || (queue->count >= queue->config.capacity))
+    {
+        ++(queue->stats.rejected);
+        r = -(__LINE__);
+    }
+    else
+    {
+        queue->buffer[(queue->head + queue->count) % queue->config.capacity] = *request;
+        ++(queue->count);
+        ++(queue->pending);
+        ++(queue->stats.submitted);
+        if (queue->count > queue->stats.highWater) { queue->stats.highWater = queue->count; }
+
+        pthread_cond_signal(&queue->cond);
+    }
+
+    pthread_mutex_unlock(&queue->mutex);
+
+    return r;
+}
+
+int RPIHAL_SPIQUEUE_getFd(const RPIHAL_SPIQUEUE_instance_t* inst)
+{
+    const queue_t* queue = (const queue_t*)(inst->queue);
+
+    if (!queue) { return -(__LINE__); }
+
+    return queue->fd;
+}
+
+int RPIHAL_SPIQUEUE_flush(RPIHAL_SPIQUEUE_instance_t* inst)
+{
+    queue_t* queue = (queue_t*)(inst->queue);
+
+    if (!queue) { return -(__LINE__); }
+
+    // the worker would wait for its own completion
+    if (pthread_equal(pthread_self(), queue->thread))
+    {
+        LOG_ERR("flush called from a completion callback");
+        return -(__LINE__);
+    }
+
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->pending > 0) { pthread_cond_wait(&queue->idle, &queue->mutex); }
+    pthread_mutex_unlock(&queue->mutex);
+
+    return 0;
+}
+
+int RPIHAL_SPIQUEUE_getStats(const RPIHAL_SPIQUEUE_instance_t* inst, RPIHAL_SPIQUEUE_stats_t* stats)
+{
+    queue_t* queue = (queue_t*)(inst->queue);
+
+    if (!queue) { return -(__LINE__); }
+
+    pthread_mutex_lock(&queue->mutex);
+    *stats = queue->stats;
+    pthread_mutex_unlock(&queue->mutex);
+
+    return 0;
+}
+
+int RPIHAL_SPIQUEUE_destroy(RPIHAL_SPIQUEUE_instance_t* inst)
+{
+    int r = 0;
+    queue_t* queue = (queue_t*)(inst->queue);
+
+    if (!queue) { return -(__LINE__); }
+
+    // the worker can't join itself
+    if (pthread_equal(pthread_self(), queue->thread))
+    {
+        LOG_ERR("destroy called from a completion callback");
+        return -(__LINE__);
+    }
+
+    pthread_mutex_lock(&queue->mutex);
+    queue->running = 0;
+    pthread_cond_signal(&queue->cond);
+    pthread_mutex_unlock(&queue->mutex);
+
+    const int err = pthread_join(queue->thread, NULL);
+    if (err)
+    {
+        LOG_ERR("failed to join the worker thread (%s)", strerror(err));
+        r = -(__LINE__);
+    }
+
+    LOG_INF("destroyed queue, %llu requests completed, %llu failed", (unsigned long long)queue->stats.completed, (unsigned long long)queue->stats.errors);
+
+    pthread_cond_destroy(&queue->idle);
+    pthread_cond_destroy(&queue->cond);
+    pthread_mutex_destroy(&queue->mutex);
+    close(queue->fd);
+    free(queue->buffer);
+    free(queue);
+    inst->queue = NULL;
+
+    return r;
+}
+
+
+
+void* workerThread(void* arg)
+{
+    queue_t* queue = (queue_t*)arg;
+
+    const int err = UTIL_setThreadSched(queue->config.cpu, queue->config.priority);
+    if (err) { LOG_WRN("failed to set CPU %i and priority %i of the worker thread (%s)", queue->config.cpu, queue->config.priority, strerror(err)); }
+
+    pthread_mutex_lock(&queue->mutex);
+
+    while (1)
+    {
+        while ((queue->count == 0) && queue->running) { pthread_cond_wait(&queue->cond, &queue->mutex); }
+
+        // the pending requests are completed before stopping
+        if (queue->count == 0) { break; }
+
+        const RPIHAL_SPIQUEUE_request_t request = queue->buffer[queue->head];
+        queue->head = (queue->head + 1) % queue->config.capacity;
+        --(queue->count);
+
+        pthread_mutex_unlock(&queue->mutex);
+
+        int result;
+
+        if (request.segments) { result = RPIHAL_SPI_transaction(request.spi, request.segments, request.nSegments); }
+        else { result = RPIHAL_SPI_transfer(request.spi, request.txData, request.rxBuffer, request.count); }
+
+        if (request.callback) { request.callback(&request, result); }
+
+        const uint64_t one = 1;
+        if (write(queue->fd, &one, sizeof(one)) != sizeof(one)) { LOG_WRN("failed to signal the eventfd"); }
+
+        pthread_mutex_lock(&queue->mutex);
+
+        ++(queue->stats.completed);
+        if (result != 0) { ++(queue->stats.errors); }
+
+        --(queue->pending);
+        if (queue->pending == 0) { pthread_cond_broadcast(&queue->idle); }
+    }
+
+    pthread_mutex_unlock(&queue->mutex);
+
+    return NULL;
+}
@@ -0,0 +1,219 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// Compiles a 74HC595 chain refresh and a parallel bus transfer, checks the compiled steps by decoding them and
+// compares the bit rate of the compiled transfer to `RPIHAL_GPIO_writePin()` per bit.
+//
+// usage: rpihal-system-test-bitbang [anon|mmap]
+//
+// With the anon backend it runs on any Linux machine (see makefile). On hardware GPIO 8, 10, 11 and 16..24 are driven,
+// so nothing must be connected to them.
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <rpihal/bitbang.h>
+#include <rpihal/gpio.h>
+#include <rpihal/rpihal.h>
+
+
+#define PIN_SR_CLK   11
+#define PIN_SR_DATA  10
+#define PIN_SR_LATCH 8
+
+#define PIN_PAR_STROBE 24
+#define PIN_PAR_D0     16 // D0..D7 on GPIO 16..23
+
+#define N_BYTES (1024)
+#define N_RUNS  (100)
+
+
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+// Applies the steps to a virtual port and samples the data pins on each active clock edge.
+static int decode(const RPIHAL_BITBANG_program_t* program, const RPIHAL_BITBANG_bus_t* bus, uint8_t* out, size_t count)
+{
+    uint32_t level = (bus->clkIdle ? (1u << bus->clk) : 0);
+    size_t nBits = 0;
+    int nLatch = 0;
+
+    memset(out, 0, count);
+
+    for (size_t i = 0; i < program->count; ++i)
+    {
+        const uint32_t prev = level;
+        level = (level | program->steps[i].set) & ~(program->steps[i].clr);
+
+        const int clkPrev = ((prev >> bus->clk) & 0x01);
+        const int clk = ((level >> bus->clk) & 0x01);
+
+        if ((clkPrev == bus->clkIdle) && (clk != bus->clkIdle))
+        {
+            if (bus->width == 1)
+            {
+                const size_t byte = nBits / 8;
+                const int shift = (bus->msbFirst ? (7 - (nBits % 8)) : (nBits % 8));
+                if ((byte < count) && ((level >> bus->data[0]) & 0x01)) { out[byte] |= (1u << shift); }
+            }
+            else if (nBits < count)
+            {
+                for (int k = 0; k < bus->width; ++k)
+                {
+                    if ((level >> bus->data[k]) & 0x01) { out[nBits] |= (1u << k); }
+                }
+            }
+
+            ++nBits;
+        }
+
+        if ((bus->latch >= 0) && !((prev >> bus->latch) & 0x01) && ((level >> bus->latch) & 0x01)) { ++nLatch; }
+    }
+
+    if ((level & (1u << bus->clk)) != (bus->clkIdle ? (1u << bus->clk) : 0)) { return 1; }
+    if (nBits != (count * (bus->width == 1 ? 8 : 1))) { return 1; }
+    if (nLatch != (bus->latch >= 0 ? 1 : 0)) { return 1; }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int backend = RPIHAL_GPIO_BACKEND_ANON;
+    RPIHAL_model_t model = RPIHAL_model_4B;
+
+    if ((argc > 1) && (strcmp(argv[1], "mmap") == 0))
+    {
+        backend = RPIHAL_GPIO_BACKEND_MMAP;
+        model = RPIHAL_model_unknown;
+    }
+
+    if (RPIHAL_GPIO_initBackend(backend, model) != 0)
+    {
+        printf("failed to init GPIO\n");
+        return 1;
+    }
+
+    if (backend == RPIHAL_GPIO_BACKEND_ANON) { printf("anon backend\n"); }
+    else
+    {
+        const char* dtModel = RPIHAL_dt_model();
+        printf("%s\n", (dtModel ? dtModel : "unknown model"));
+    }
+
+    int err = 0;
+
+    RPIHAL_GPIO_init_t initStruct;
+    RPIHAL_GPIO_defaultInitStruct(&initStruct);
+    initStruct.mode = RPIHAL_GPIO_MODE_OUT;
+    err |= RPIHAL_GPIO_initPins(RPIHAL_GPIO_BIT(PIN_SR_CLK) | RPIHAL_GPIO_BIT(PIN_SR_DATA) | RPIHAL_GPIO_BIT(PIN_SR_LATCH) |
+                                    RPIHAL_GPIO_BIT(PIN_PAR_STROBE) | (0xFFull << PIN_PAR_D0),
+                                &initStruct);
+
+    static uint8_t data[N_BYTES];
+    static uint8_t decoded[N_BYTES];
+    for (int i = 0; i < N_BYTES; ++i) { data[i] = (uint8_t)((i * 37) ^ (i >> 3)); }
+
+    RPIHAL_BITBANG_program_t program;
+    memset(&program, 0, sizeof(program));
+
+
+
+    // 74HC595 chain
+
+    RPIHAL_BITBANG_bus_t sr;
+    RPIHAL_BITBANG_defaultBus(&sr);
+    sr.clk = PIN_SR_CLK;
+    sr.data[0] = PIN_SR_DATA;
+    sr.latch = PIN_SR_LATCH;
+
+    uint64_t t0 = now_ns();
+    err |= RPIHAL_BITBANG_compile(&program, &sr, data, N_BYTES);
+    uint64_t t1 = now_ns();
+
+    if (decode(&program, &sr, decoded, N_BYTES) || (memcmp(data, decoded, N_BYTES) != 0))
+    {
+        printf("serial: decoded data mismatch\n");
+        err |= 1;
+    }
+
+    printf("serial:   %zu steps for %i bits, compiled in %.2fus\n", program.count, N_BYTES * 8, (double)(t1 - t0) / 1e3);
+
+    t0 = now_ns();
+    for (int run = 0; run < N_RUNS; ++run) { err |= RPIHAL_BITBANG_run(&program); }
+    t1 = now_ns();
+
+    const double compiled = (double)N_BYTES * 8 * N_RUNS * 1e9 / (double)(t1 - t0);
+
+    t0 = now_ns();
+    for (int run = 0; run < N_RUNS; ++run)
+    {
+        for (int i = 0; i < N_BYTES; ++i)
+        {
+            for (int b = 7; b >= 0; --b)
+            {
+                err |= RPIHAL_GPIO_writePin(PIN_SR_DATA, (data[i] >> b) & 0x01);
+                err |= RPIHAL_GPIO_writePin(PIN_SR_CLK, 1);
+                err |= RPIHAL_GPIO_writePin(PIN_SR_CLK, 0);
+            }
+        }
+
+        err |= RPIHAL_GPIO_writePin(PIN_SR_LATCH, 1);
+        err |= RPIHAL_GPIO_writePin(PIN_SR_LATCH, 0);
+    }
+    t1 = now_ns();
+
+    const double perPin = (double)N_BYTES * 8 * N_RUNS * 1e9 / (double)(t1 - t0);
+
+    printf("serial:   compiled %8.3f Mbit/s, writePin %8.3f Mbit/s\n", compiled / 1e6, perPin / 1e6);
+
+
+
+    // 8 bit parallel bus, data taken on the falling strobe edge
+
+    RPIHAL_BITBANG_bus_t par;
+    RPIHAL_BITBANG_defaultBus(&par);
+    par.clk = PIN_PAR_STROBE;
+    par.clkIdle = 1;
+    par.width = 8;
+    for (int k = 0; k < 8; ++k) { par.data[k] = PIN_PAR_D0 + k; }
+
+    err |= RPIHAL_BITBANG_compile(&program, &par, data, N_BYTES);
+
+    if (decode(&program, &par, decoded, N_BYTES) || (memcmp(data, decoded, N_BYTES) != 0))
+    {
+        printf("parallel: decoded data mismatch\n");
+        err |= 1;
+    }
+
+    t0 = now_ns();
+    for (int run = 0; run < N_RUNS; ++run) { err |= RPIHAL_BITBANG_run(&program); }
+    t1 = now_ns();
+
+    printf("parallel: compiled %8.3f Mbit/s, %zu steps for %i words\n", (double)N_BYTES * 8 * N_RUNS * 1e3 / (double)(t1 - t0), program.count, N_BYTES);
+
+
+
+    // invalid bus
+
+    par.data[3] = 40;
+    if (RPIHAL_BITBANG_compile(&program, &par, data, N_BYTES) == 0) { err |= 1; }
+
+    RPIHAL_BITBANG_free(&program);
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}
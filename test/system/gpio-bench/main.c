@@ -0,0 +1,196 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// Benchmarks the GPIO register path. With the anon backend it runs on any Linux machine (see makefile).
+//
+// usage: rpihal-system-test-gpio-bench [anon|anon5|mmap] [trace]
+//
+// `anon5` emulates the RP1 registers of a Pi 5.
+//
+// Prints the time and rate (e.g. toggles per second) of each operation and, if `trace` is given, the number of register
+// accesses per operation. Tracing itself is slow, the timings of a traced run are not meaningful.
+//
+// At the end the checked register path is compared for each access mode (see `RPIHAL_GPIO_setAccessMode()`).
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <rpihal/gpio.h>
+#include <rpihal/rpihal.h>
+
+
+#define PIN_OUT 22
+#define PIN_IN  4
+
+#define N_ITER (1000000)
+
+
+
+static uint64_t nReads = 0;
+static uint64_t nWrites = 0;
+
+static void traceCounter(int write, uint32_t offset, uint32_t value)
+{
+    (void)offset;
+    (void)value;
+
+    if (write) { ++nWrites; }
+    else { ++nReads; }
+}
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static void printResult(const char* name, uint64_t t_ns, uint64_t n, int trace)
+{
+    printf("%-20s %8.2f ns/op %8.2f Mop/s", name, (double)t_ns / (double)n, (double)n * 1e3 / (double)t_ns);
+    if (trace) { printf("   R %5.2f  W %5.2f /op", (double)nReads / (double)n, (double)nWrites / (double)n); }
+    printf("\n");
+
+    nReads = 0;
+    nWrites = 0;
+}
+
+#define BENCH(_name, _n, _expr)                           \
+    {                                                     \
+        nReads = 0;                                       \
+        nWrites = 0;                                      \
+        const uint64_t t0 = now_ns();                     \
+        for (uint64_t i = 0; i < (_n); ++i) { _expr; }    \
+        printResult((_name), now_ns() - t0, (_n), trace); \
+    }
+
+
+
+int main(int argc, char** argv)
+{
+    int backend = RPIHAL_GPIO_BACKEND_ANON;
+    RPIHAL_model_t model = RPIHAL_model_4B;
+    int trace = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "mmap") == 0)
+        {
+            backend = RPIHAL_GPIO_BACKEND_MMAP;
+            model = RPIHAL_model_unknown;
+        }
+        else if (strcmp(argv[i], "anon") == 0)
+        {
+            backend = RPIHAL_GPIO_BACKEND_ANON;
+            model = RPIHAL_model_4B;
+        }
+        else if (strcmp(argv[i], "anon5") == 0)
+        {
+            backend = RPIHAL_GPIO_BACKEND_ANON;
+            model = RPIHAL_model_5;
+        }
+        else if (strcmp(argv[i], "trace") == 0) { trace = 1; }
+        else
+        {
+            printf("usage: %s [anon|anon5|mmap] [trace]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (trace)
+    {
+        backend |= RPIHAL_GPIO_BACKEND_TRACE;
+        RPIHAL_GPIO_setTraceCallback(traceCounter);
+    }
+
+    if (RPIHAL_GPIO_initBackend(backend, model) != 0)
+    {
+        printf("failed to init GPIO\n");
+        return 1;
+    }
+
+    printf("backend 0x%03x, model 0x%08x, access mode %i\n", backend, (unsigned)model, RPIHAL_GPIO_getAccessMode());
+
+    RPIHAL_GPIO_init_t initStruct;
+    RPIHAL_GPIO_defaultInitStruct(&initStruct);
+    initStruct.mode = RPIHAL_GPIO_MODE_OUT;
+
+    int err = 0;
+    volatile uint64_t sink = 0;
+
+    BENCH("getModel", N_ITER, sink += (uint64_t)RPIHAL_getModel());
+    BENCH("initPin", N_ITER / 100, err |= RPIHAL_GPIO_initPin(PIN_OUT, &initStruct));
+    BENCH("initPin x20", N_ITER / 1000, for (int p = 2; p < 22; ++p) { err |= RPIHAL_GPIO_initPin(p, &initStruct); });
+    BENCH("initPins x20", N_ITER / 1000, err |= RPIHAL_GPIO_initPins(0x003FFFFCull, &initStruct));
+    BENCH("writePin", N_ITER, err |= RPIHAL_GPIO_writePin(PIN_OUT, (int)(i & 1)));
+    BENCH("readPin", N_ITER, sink += (uint64_t)RPIHAL_GPIO_readPin(PIN_IN));
+    BENCH("read64", N_ITER, sink += RPIHAL_GPIO_read64());
+    BENCH("togglePin", N_ITER, err |= RPIHAL_GPIO_togglePin(PIN_OUT));
+    BENCH("readPin+writePin", N_ITER, err |= RPIHAL_GPIO_writePin(PIN_OUT, !RPIHAL_GPIO_readPin(PIN_OUT)));
+    BENCH("toggle64", N_ITER, err |= RPIHAL_GPIO_toggle64(RPIHAL_GPIO_BIT(PIN_OUT) | RPIHAL_GPIO_BIT(PIN_IN)));
+    BENCH("readOutput64", N_ITER, sink += RPIHAL_GPIO_readOutput64());
+    BENCH("set+clr", N_ITER, err |= RPIHAL_GPIO_set(RPIHAL_GPIO_BIT(PIN_OUT)) | RPIHAL_GPIO_clr(RPIHAL_GPIO_BIT(PIN_IN)));
+    BENCH("write64", N_ITER, err |= RPIHAL_GPIO_write64(RPIHAL_GPIO_BIT(PIN_OUT) | RPIHAL_GPIO_BIT(PIN_IN), RPIHAL_GPIO_BIT(PIN_OUT)));
+
+    // not on hardware, see caution at RPIHAL_GPIO_setEdgeDetect()
+    if (((backend & ~RPIHAL_GPIO_BACKEND_TRACE) == RPIHAL_GPIO_BACKEND_ANON) && !RPIHAL_model_SoC_is_bcm2712(model))
+    {
+        uint64_t nEvents = 0;
+
+        err |= RPIHAL_GPIO_writePin(PIN_OUT, 0);
+        err |= RPIHAL_GPIO_setEdgeDetect(RPIHAL_GPIO_BIT(PIN_OUT), RPIHAL_GPIO_EDGE_RISING);
+        BENCH("fetchEvents", N_ITER, sink += RPIHAL_GPIO_fetchEvents(RPIHAL_GPIO_BIT(PIN_OUT)));
+        BENCH("pulse+fetchEvents", N_ITER, {
+            err |= RPIHAL_GPIO_writePin(PIN_OUT, 1) | RPIHAL_GPIO_writePin(PIN_OUT, 0);
+            if (RPIHAL_GPIO_fetchEvents(RPIHAL_GPIO_BIT(PIN_OUT))) { ++nEvents; }
+        });
+        err |= RPIHAL_GPIO_setEdgeDetect(RPIHAL_GPIO_BIT(PIN_OUT), RPIHAL_GPIO_EDGE_NONE);
+
+        if (nEvents != N_ITER) { err |= 1; }
+    }
+
+    RPIHAL_GPIO_pin_t handle;
+    err |= RPIHAL_GPIO_getPinHandle(&handle, PIN_OUT);
+
+    BENCH("fastWrite", N_ITER, RPIHAL_GPIO_fastWrite(&handle, (int)(i & 1)));
+    // the fast path bypasses the anon emulation, the level doesn't change and the toggle always writes the same register
+    const int anon = ((backend & ~RPIHAL_GPIO_BACKEND_TRACE) == RPIHAL_GPIO_BACKEND_ANON);
+    BENCH((anon ? "fastToggle (wr only)" : "fastToggle"), N_ITER, RPIHAL_GPIO_fastToggle(&handle));
+
+    const int defaultAccessMode = RPIHAL_GPIO_getAccessMode();
+    const struct
+    {
+        int mode;
+        const char* name;
+    } accessModes[] = {
+        { RPIHAL_GPIO_ACCESS_RELAXED, "relaxed" },
+        { RPIHAL_GPIO_ACCESS_BARRIER, "barrier" },
+        { RPIHAL_GPIO_ACCESS_ERRATUM, "erratum" },
+    };
+
+    for (size_t m = 0; m < (sizeof(accessModes) / sizeof(accessModes[0])); ++m)
+    {
+        char name[32];
+
+        err |= RPIHAL_GPIO_setAccessMode(accessModes[m].mode);
+
+        snprintf(name, sizeof(name), "writePin %s", accessModes[m].name);
+        BENCH(name, N_ITER, err |= RPIHAL_GPIO_writePin(PIN_OUT, (int)(i & 1)));
+
+        snprintf(name, sizeof(name), "readPin %s", accessModes[m].name);
+        BENCH(name, N_ITER, sink += (uint64_t)RPIHAL_GPIO_readPin(PIN_IN));
+    }
+
+    err |= RPIHAL_GPIO_setAccessMode(defaultAccessMode);
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}
@@ -0,0 +1,242 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// Stresses the GPIO module from multiple threads. With the anon backend it runs on any Linux machine (see makefile).
+//
+// usage: rpihal-system-test-gpio-mt [anon|mmap]
+//
+// Each thread toggles its own pin, a pin shared by all threads and writes a group of pins with `RPIHAL_GPIO_write64()`.
+// Afterwards the output shadow is checked against the expected result, a lost toggle shows up as a wrong level. GPLEV
+// is checked for the pins written by one thread only, the writes to the shared pin are last-writer-wins.
+//
+// In parallel the config threads reconfigure pins which share the function select register with the shared pin (and
+// the pull register with the own pins). Afterwards the final configurations are applied again from one thread, the
+// registers must not change. A lost read-modify-write shows up as a changed register (or as a wrong level, if the
+// function of an output pin got clobbered).
+
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <rpihal/gpio.h>
+#include <rpihal/rpihal.h>
+
+
+#define N_THREADS (3)
+#define N_ITER    (200001) // odd, so every toggled pin ends up high
+
+#define PIN_SHARED   17
+#define PIN_OWN(_t)  (5 + (_t))
+#define PIN_GRP(_t)  (20 + (2 * (_t)))
+#define GRP_MASK(_t) (RPIHAL_GPIO_BIT(PIN_GRP(_t)) | RPIHAL_GPIO_BIT(PIN_GRP(_t) + 1))
+
+#define N_CFG_THREADS (4)
+#define N_CFG_ITER    (20000)
+#define PIN_CFG(_t)   (10 + (_t)) // GPFSEL1 as PIN_SHARED, PUP_PDN_CNTRL_REG0 as PIN_OWN
+
+#define GPFSEL0                         (0x0000)
+#define BCM2711_GPIO_PUP_PDN_CNTRL_REG0 (0x00E4)
+
+
+
+typedef struct
+{
+    int index;
+    int err;
+    uint64_t t_ns;
+} thread_arg_t;
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static void cfgInitStruct(RPIHAL_GPIO_init_t* initStruct, int t, uint32_t i)
+{
+    RPIHAL_GPIO_defaultInitStruct(initStruct);
+    initStruct->mode = (((i + t) & 1) ? RPIHAL_GPIO_MODE_OUT : RPIHAL_GPIO_MODE_IN);
+    initStruct->pull = (int)((i + t) % 3);
+}
+
+static void* cfgThread(void* p)
+{
+    thread_arg_t* arg = (thread_arg_t*)p;
+    const int t = arg->index;
+    int err = 0;
+
+    const uint64_t t0 = now_ns();
+
+    for (uint32_t i = 0; i < N_CFG_ITER; ++i)
+    {
+        RPIHAL_GPIO_init_t initStruct;
+        cfgInitStruct(&initStruct, t, i);
+        err |= RPIHAL_GPIO_initPin(PIN_CFG(t), &initStruct);
+    }
+
+    arg->t_ns = now_ns() - t0;
+    arg->err = err;
+
+    return NULL;
+}
+
+static void* thread(void* p)
+{
+    thread_arg_t* arg = (thread_arg_t*)p;
+    const int t = arg->index;
+    const uint64_t grpMask = GRP_MASK(t);
+    const uint64_t grpLo = RPIHAL_GPIO_BIT(PIN_GRP(t));
+    int err = 0;
+
+    const uint64_t t0 = now_ns();
+
+    for (uint32_t i = 0; i < N_ITER; ++i)
+    {
+        err |= RPIHAL_GPIO_togglePin(PIN_OWN(t));
+        err |= RPIHAL_GPIO_togglePin(PIN_SHARED);
+        err |= RPIHAL_GPIO_write64(grpMask, ((i & 1) ? grpMask : grpLo));
+    }
+
+    arg->t_ns = now_ns() - t0;
+    arg->err = err;
+
+    return NULL;
+}
+
+
+
+int main(int argc, char** argv)
+{
+    int backend = RPIHAL_GPIO_BACKEND_ANON;
+    RPIHAL_model_t model = RPIHAL_model_4B;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "mmap") == 0)
+        {
+            backend = RPIHAL_GPIO_BACKEND_MMAP;
+            model = RPIHAL_model_unknown;
+        }
+        else if (strcmp(argv[i], "anon") == 0)
+        {
+            backend = RPIHAL_GPIO_BACKEND_ANON;
+            model = RPIHAL_model_4B;
+        }
+        else
+        {
+            printf("usage: %s [anon|mmap]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (RPIHAL_GPIO_initBackend(backend, model) != 0)
+    {
+        printf("failed to init GPIO\n");
+        return 1;
+    }
+
+    int err = 0;
+    uint64_t mask = RPIHAL_GPIO_BIT(PIN_SHARED);
+    uint64_t expected = RPIHAL_GPIO_BIT(PIN_SHARED);
+
+    for (int t = 0; t < N_THREADS; ++t)
+    {
+        mask |= RPIHAL_GPIO_BIT(PIN_OWN(t)) | GRP_MASK(t);
+        expected |= RPIHAL_GPIO_BIT(PIN_OWN(t)) | RPIHAL_GPIO_BIT(PIN_GRP(t)); // last iteration is even
+    }
+
+    RPIHAL_GPIO_init_t initStruct;
+    RPIHAL_GPIO_defaultInitStruct(&initStruct);
+    initStruct.mode = RPIHAL_GPIO_MODE_OUT;
+
+    err |= RPIHAL_GPIO_initPins(mask, &initStruct);
+    err |= RPIHAL_GPIO_write64(mask, 0);
+
+    pthread_t threads[N_THREADS + N_CFG_THREADS];
+    thread_arg_t args[N_THREADS + N_CFG_THREADS];
+
+    for (int t = 0; t < (N_THREADS + N_CFG_THREADS); ++t)
+    {
+        args[t].index = ((t < N_THREADS) ? t : (t - N_THREADS));
+        args[t].err = 0;
+        args[t].t_ns = 0;
+
+        if (pthread_create(&threads[t], NULL, ((t < N_THREADS) ? thread : cfgThread), &args[t]) != 0)
+        {
+            printf("failed to create thread %i\n", t);
+            return 1;
+        }
+    }
+
+    for (int t = 0; t < N_THREADS; ++t)
+    {
+        pthread_join(threads[t], NULL);
+        err |= args[t].err;
+
+        // 4 register writes per iteration (2 toggles, write64 with set and clear bits)
+        printf("thread %i: %8.2f ns/iteration\n", t, (double)args[t].t_ns / (double)N_ITER);
+    }
+
+    for (int t = N_THREADS; t < (N_THREADS + N_CFG_THREADS); ++t)
+    {
+        pthread_join(threads[t], NULL);
+        err |= args[t].err;
+
+        printf("config thread %i: %8.2f ns/initPin\n", args[t].index, (double)args[t].t_ns / (double)N_CFG_ITER);
+    }
+
+    // the pull registers can only be read back on BCM2711
+    const int nPupRegs = ((backend == RPIHAL_GPIO_BACKEND_ANON) ? 2 : 0);
+    const RPIHAL_regptr_t base = RPIHAL_GPIO_getMemBasePtr();
+    uint32_t regs[5];
+
+    for (int i = 0; i < 3; ++i) { regs[i] = base[(GPFSEL0 / 4) + i]; }
+    for (int i = 0; i < nPupRegs; ++i) { regs[3 + i] = base[(BCM2711_GPIO_PUP_PDN_CNTRL_REG0 / 4) + i]; }
+
+    for (int t = 0; t < N_CFG_THREADS; ++t)
+    {
+        RPIHAL_GPIO_init_t initStruct;
+        cfgInitStruct(&initStruct, t, N_CFG_ITER - 1);
+        err |= RPIHAL_GPIO_initPin(PIN_CFG(t), &initStruct);
+    }
+
+    for (int i = 0; i < (3 + nPupRegs); ++i)
+    {
+        const uint32_t value = ((i < 3) ? base[(GPFSEL0 / 4) + i] : base[(BCM2711_GPIO_PUP_PDN_CNTRL_REG0 / 4) + i - 3]);
+
+        printf("%s%i 0x%08x", ((i < 3) ? "GPFSEL" : "PUP_PDN_CNTRL_REG"), ((i < 3) ? i : (i - 3)), regs[i]);
+
+        if (value != regs[i])
+        {
+            printf(" != 0x%08x", value);
+            err |= 1;
+        }
+
+        printf("\n");
+    }
+
+    const uint64_t level = RPIHAL_GPIO_read64() & mask;
+    const uint64_t shadow = RPIHAL_GPIO_readOutput64() & mask;
+
+    printf("expected 0x%016llx\n", (unsigned long long)expected);
+    printf("GPLEV    0x%016llx\n", (unsigned long long)level);
+    printf("shadow   0x%016llx\n", (unsigned long long)shadow);
+
+    const uint64_t sharedMask = ~RPIHAL_GPIO_BIT(PIN_SHARED);
+    if (((level & sharedMask) != (expected & sharedMask)) || (shadow != expected)) { err |= 1; }
+
+    err |= RPIHAL_GPIO_reset();
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+    else { printf("\033[92mOK\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}
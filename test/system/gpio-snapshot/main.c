@@ -0,0 +1,187 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// Checks snapshot, diff and restore of the pin configuration. With the anon backend it runs on any Linux machine (see
+// makefile).
+//
+// usage: rpihal-system-test-gpio-snapshot [anon|anon5|mmap]
+//
+// The pins are configured and a snapshot is taken. Then some pins are reconfigured and written, the diff has to report
+// exactly these pins. After the restore a new snapshot has to be equal to the first one. The register accesses of the
+// restore are counted and it's timed against configuring the pins again. An init with an invalid drive strength must not
+// write any register.
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <rpihal/gpio.h>
+#include <rpihal/rpihal.h>
+
+
+#define PINS_OUT  (0x00F00000ull) // 20..23
+#define PINS_IN   (0x000F0000ull) // 16..19
+#define PINS_CHG  (0x00300030ull) // 4, 5, 20, 21
+#define PIN_LEVEL 22
+
+#define N_ITER (10000)
+
+
+
+static uint64_t nReads = 0;
+static uint64_t nWrites = 0;
+
+static void traceCounter(int write, uint32_t offset, uint32_t value)
+{
+    (void)offset;
+    (void)value;
+
+    if (write) { ++nWrites; }
+    else { ++nReads; }
+}
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static int configure()
+{
+    int err = 0;
+    RPIHAL_GPIO_init_t initStruct;
+
+    RPIHAL_GPIO_defaultInitStruct(&initStruct);
+    initStruct.mode = RPIHAL_GPIO_MODE_OUT;
+    initStruct.pull = RPIHAL_GPIO_PULL_NONE;
+    err |= RPIHAL_GPIO_initPins(PINS_OUT, &initStruct);
+
+    initStruct.mode = RPIHAL_GPIO_MODE_IN;
+    initStruct.pull = RPIHAL_GPIO_PULL_UP;
+    err |= RPIHAL_GPIO_initPins(PINS_IN, &initStruct);
+
+    err |= RPIHAL_GPIO_write64(PINS_OUT, 0x00A00000ull);
+
+    return err;
+}
+
+
+
+int main(int argc, char** argv)
+{
+    int backend = RPIHAL_GPIO_BACKEND_ANON;
+    RPIHAL_model_t model = RPIHAL_model_4B;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "mmap") == 0)
+        {
+            backend = RPIHAL_GPIO_BACKEND_MMAP;
+            model = RPIHAL_model_unknown;
+        }
+        else if (strcmp(argv[i], "anon") == 0)
+        {
+            backend = RPIHAL_GPIO_BACKEND_ANON;
+            model = RPIHAL_model_4B;
+        }
+        else if (strcmp(argv[i], "anon5") == 0)
+        {
+            backend = RPIHAL_GPIO_BACKEND_ANON;
+            model = RPIHAL_model_5;
+        }
+        else
+        {
+            printf("usage: %s [anon|anon5|mmap]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    RPIHAL_GPIO_setTraceCallback(traceCounter);
+
+    if (RPIHAL_GPIO_initBackend(backend | RPIHAL_GPIO_BACKEND_TRACE, model) != 0)
+    {
+        printf("failed to init GPIO\n");
+        return 1;
+    }
+
+    int err = configure();
+
+    RPIHAL_GPIO_snapshot_t checkpoint;
+    RPIHAL_GPIO_snapshot_t snapshot;
+    uint64_t diff;
+
+    err |= RPIHAL_GPIO_snapshot(&checkpoint);
+    err |= RPIHAL_GPIO_snapshot(&snapshot);
+
+    diff = RPIHAL_GPIO_diffSnapshot(&checkpoint, &snapshot);
+    printf("diff unchanged  0x%016llx\n", (unsigned long long)diff);
+    if (diff != 0) { err |= 1; }
+
+
+
+    // change pins 4, 5 (function) and 20, 21 (output to input with pull down), toggle the level of 22
+
+    RPIHAL_GPIO_init_t initStruct;
+    RPIHAL_GPIO_defaultInitStruct(&initStruct);
+    initStruct.mode = RPIHAL_GPIO_MODE_OUT;
+    err |= RPIHAL_GPIO_initPins(PINS_CHG & 0x0000FFFF, &initStruct);
+    initStruct.mode = RPIHAL_GPIO_MODE_IN;
+    initStruct.pull = RPIHAL_GPIO_PULL_DOWN;
+    err |= RPIHAL_GPIO_initPins(PINS_CHG & 0xFFFF0000, &initStruct);
+    err |= RPIHAL_GPIO_togglePin(PIN_LEVEL);
+
+    err |= RPIHAL_GPIO_snapshot(&snapshot);
+    diff = RPIHAL_GPIO_diffSnapshot(&checkpoint, &snapshot);
+    printf("diff changed    0x%016llx\n", (unsigned long long)diff);
+    if (diff != (PINS_CHG | RPIHAL_GPIO_BIT(PIN_LEVEL))) { err |= 1; }
+
+
+
+    nReads = 0;
+    nWrites = 0;
+    err |= RPIHAL_GPIO_restore(&checkpoint);
+    printf("restore         R %llu  W %llu\n", (unsigned long long)nReads, (unsigned long long)nWrites);
+
+    err |= RPIHAL_GPIO_snapshot(&snapshot);
+    diff = RPIHAL_GPIO_diffSnapshot(&checkpoint, &snapshot);
+    printf("diff restored   0x%016llx\n", (unsigned long long)diff);
+    if (diff != 0) { err |= 1; }
+
+    nReads = 0;
+    nWrites = 0;
+    err |= RPIHAL_GPIO_restore(&checkpoint);
+    printf("restore again   R %llu  W %llu\n", (unsigned long long)nReads, (unsigned long long)nWrites);
+    if (nWrites != 0) { err |= 1; }
+
+    // an invalid pad configuration is rejected before anything is written
+    nWrites = 0;
+    initStruct.drive = RPIHAL_GPIO_DRIVE_16mA + 1;
+    if (RPIHAL_GPIO_initPins(PINS_CHG, &initStruct) == 0) { err |= 1; }
+    if (nWrites != 0) { err |= 1; }
+    initStruct.drive = RPIHAL_GPIO_DRIVE_KEEP;
+
+
+
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < N_ITER; ++i) { err |= RPIHAL_GPIO_restore(&checkpoint); }
+    const uint64_t tRestore = now_ns() - t0;
+
+    t0 = now_ns();
+    for (int i = 0; i < N_ITER; ++i) { err |= configure(); }
+    const uint64_t tConfigure = now_ns() - t0;
+
+    printf("restore   %8.2f us (traced)\n", (double)tRestore / (double)N_ITER / 1000.0);
+    printf("configure %8.2f us (traced)\n", (double)tConfigure / (double)N_ITER / 1000.0);
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+    else { printf("\033[92mOK\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}
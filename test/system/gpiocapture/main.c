@@ -0,0 +1,145 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// Captures a pin while toggling it and checks that every edge has been captured.
+//
+// usage: rpihal-system-test-gpiocapture [anon|mmap] [<vcd-file>]
+//
+// With the anon backend it runs on any Linux machine (see makefile). On hardware the output pin is toggled, so nothing
+// must be connected to it.
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <rpihal/gpio.h>
+#include <rpihal/gpiocapture.h>
+#include <rpihal/rpihal.h>
+
+
+#define PIN_OUT 22
+
+#define N_TOGGLES (200)
+#define RATE      (100000) // [Hz]
+#define CAPACITY  (1024)
+
+
+
+int main(int argc, char** argv)
+{
+    int backend = RPIHAL_GPIO_BACKEND_ANON;
+    RPIHAL_model_t model = RPIHAL_model_4B;
+    const char* vcdFile = NULL;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "mmap") == 0)
+        {
+            backend = RPIHAL_GPIO_BACKEND_MMAP;
+            model = RPIHAL_model_unknown;
+        }
+        else if (strcmp(argv[i], "anon") == 0)
+        {
+            backend = RPIHAL_GPIO_BACKEND_ANON;
+            model = RPIHAL_model_4B;
+        }
+        else { vcdFile = argv[i]; }
+    }
+
+    if (RPIHAL_GPIO_initBackend(backend, model) != 0)
+    {
+        printf("failed to init GPIO\n");
+        return 1;
+    }
+
+    int err = 0;
+
+    RPIHAL_GPIO_init_t initStruct;
+    RPIHAL_GPIO_defaultInitStruct(&initStruct);
+    initStruct.mode = RPIHAL_GPIO_MODE_OUT;
+    err |= RPIHAL_GPIO_initPin(PIN_OUT, &initStruct);
+    err |= RPIHAL_GPIO_writePin(PIN_OUT, 0);
+
+    RPIHAL_GPIOCAPTURE_config_t config;
+    RPIHAL_GPIOCAPTURE_defaultConfig(&config);
+    config.bits = RPIHAL_GPIO_BIT(PIN_OUT);
+    config.rate = RATE;
+    config.capacity = CAPACITY;
+
+    RPIHAL_GPIOCAPTURE_instance_t inst;
+    if (RPIHAL_GPIOCAPTURE_start(&inst, &config) != 0)
+    {
+        printf("failed to start capture\n");
+        return 1;
+    }
+
+    FILE* fp = NULL;
+    if (vcdFile)
+    {
+        fp = fopen(vcdFile, "w");
+        if (fp) { err |= RPIHAL_GPIOCAPTURE_writeVcdHeader(&inst, fp); }
+        else { err |= 1; }
+    }
+
+    RPIHAL_GPIOCAPTURE_change_t changes[64];
+    size_t nChanges = 0;
+    uint64_t lastTimestamp = 0;
+
+    for (int i = 0; i <= N_TOGGLES; ++i)
+    {
+        // a period of 1ms is 100 samples at 100kHz
+        struct timespec ts = { .tv_sec = 0, .tv_nsec = 500000 };
+        nanosleep(&ts, NULL);
+
+        if (i < N_TOGGLES) { err |= RPIHAL_GPIO_togglePin(PIN_OUT); }
+
+        // stream the capture while it's running
+        size_t n;
+        while ((n = RPIHAL_GPIOCAPTURE_read(&inst, changes, sizeof(changes) / sizeof(changes[0]))) > 0)
+        {
+            for (size_t k = 0; k < n; ++k)
+            {
+                // the level alternates, starting low
+                if (changes[k].level != ((nChanges % 2) ? RPIHAL_GPIO_BIT(PIN_OUT) : 0)) { err |= 1; }
+                if ((nChanges > 0) && (changes[k].timestamp <= lastTimestamp)) { err |= 1; }
+
+                lastTimestamp = changes[k].timestamp;
+                ++nChanges;
+            }
+
+            if (fp) { err |= RPIHAL_GPIOCAPTURE_writeVcd(&inst, fp, changes, n); }
+        }
+    }
+
+    RPIHAL_GPIOCAPTURE_stats_t stats;
+    err |= RPIHAL_GPIOCAPTURE_getStats(&inst, &stats);
+    err |= RPIHAL_GPIOCAPTURE_stop(&inst);
+
+    if (fp) { fclose(fp); }
+
+    printf("%zu/%i changes, %llu samples in %.2fms (%.1fkHz)\n", nChanges, N_TOGGLES + 1, (unsigned long long)stats.samples,
+           (double)lastTimestamp / 1e6, (double)stats.samples / ((double)lastTimestamp / 1e6));
+    printf("overflows %llu, late %llu, max lateness %.2fus\n", (unsigned long long)stats.overflows, (unsigned long long)stats.late,
+           (double)stats.maxLateness / 1000.0);
+
+    if (nChanges != (N_TOGGLES + 1)) { err |= 1; }
+    if (stats.overflows) { err |= 1; }
+
+    // a sample period below 1ns is rejected
+    config.rate = 2000000000u;
+    if (RPIHAL_GPIOCAPTURE_start(&inst, &config) == 0)
+    {
+        err |= 1;
+        RPIHAL_GPIOCAPTURE_stop(&inst);
+    }
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}
@@ -0,0 +1,197 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// Plays a waveform by DMA and checks the GPIO register writes.
+//
+// usage: rpihal-system-test-gpiodma [anon|mmap]
+//
+// With the anon backend it runs on any Linux machine (see makefile), the DMA engine is then emulated by executing the
+// generated control blocks, the written registers are recorded by the trace backend. On hardware (root needed) the
+// output pins are toggled, so nothing must be connected to them. DMA channel 10 and PWM channel 0 are used.
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rpihal/gpio.h>
+#include <rpihal/gpiodma.h>
+#include <rpihal/pwm.h>
+#include <rpihal/rpihal.h>
+
+
+#define PIN_A 22
+#define PIN_B 23
+
+#define N_ENTRIES (100)
+#define N_LOOPS   (3)
+#define DELAY     (20000) // [ns]
+
+#define GPSET0 (0x1C)
+#define GPCLR0 (0x28)
+
+
+
+static uint32_t trace[N_ENTRIES * N_LOOPS * 2];
+static size_t traceCount = 0;
+static int traceEnabled = 0;
+
+static uint64_t nPasses = 0;
+static int nDone = 0;
+
+static void traceCallback(int write, uint32_t offset, uint32_t value)
+{
+    if (traceEnabled && write && ((offset == GPSET0) || (offset == GPCLR0)) && (traceCount < (sizeof(trace) / sizeof(trace[0]))))
+    {
+        trace[traceCount++] = (offset == GPSET0 ? value : ~value);
+    }
+}
+
+static void doneCallback(void* arg, uint64_t pass, int done)
+{
+    nPasses = pass;
+    if (done) { ++nDone; }
+}
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+    int backend = RPIHAL_GPIO_BACKEND_ANON;
+    RPIHAL_model_t model = RPIHAL_model_4B;
+
+    if ((argc > 1) && (strcmp(argv[1], "mmap") == 0))
+    {
+        backend = RPIHAL_GPIO_BACKEND_MMAP;
+        model = RPIHAL_model_unknown;
+    }
+
+    const int gpioBackend = (backend == RPIHAL_GPIO_BACKEND_ANON ? (backend | RPIHAL_GPIO_BACKEND_TRACE) : backend);
+    RPIHAL_GPIO_setTraceCallback(traceCallback);
+
+    if ((RPIHAL_GPIO_initBackend(gpioBackend, model) != 0) || (RPIHAL_PWM_initBackend(backend, model) != 0))
+    {
+        printf("failed to init GPIO/PWM\n");
+        return 1;
+    }
+
+    int err = 0;
+
+    RPIHAL_GPIO_init_t initStruct;
+    RPIHAL_GPIO_defaultInitStruct(&initStruct);
+    initStruct.mode = RPIHAL_GPIO_MODE_OUT;
+    err |= RPIHAL_GPIO_initPins(RPIHAL_GPIO_BIT(PIN_A) | RPIHAL_GPIO_BIT(PIN_B), &initStruct);
+
+    // A toggles every entry, B is high every 4th entry
+    static RPIHAL_GPIOWAVE_entry_t wave[N_ENTRIES];
+
+    for (int i = 0; i < N_ENTRIES; ++i)
+    {
+        wave[i].set = (((i % 2) == 0) ? RPIHAL_GPIO_BIT(PIN_A) : 0) | (((i % 4) == 0) ? RPIHAL_GPIO_BIT(PIN_B) : 0);
+        wave[i].clr = (RPIHAL_GPIO_BIT(PIN_A) | RPIHAL_GPIO_BIT(PIN_B)) & ~wave[i].set;
+        wave[i].delay = DELAY;
+    }
+
+    RPIHAL_GPIODMA_config_t config;
+    RPIHAL_GPIODMA_defaultConfig(&config);
+    config.backend = backend;
+    config.loops = N_LOOPS;
+    config.callback = doneCallback;
+
+    RPIHAL_GPIODMA_instance_t inst;
+    RPIHAL_GPIODMA_status_t status;
+
+    traceEnabled = 1;
+    const uint64_t t0 = now_ns();
+
+    if (RPIHAL_GPIODMA_play(&inst, wave, N_ENTRIES, &config) != 0)
+    {
+        printf("failed to start DMA playback\n");
+        return 1;
+    }
+
+    err |= RPIHAL_GPIODMA_getStatus(&inst, &status);
+    err |= RPIHAL_GPIODMA_wait(&inst);
+
+    const uint64_t t1 = now_ns();
+    traceEnabled = 0;
+
+    printf("played %i entries %i times in %.2fms (%.2fms expected), tick %uns\n", N_ENTRIES, N_LOOPS, (double)(t1 - t0) / 1e6,
+           (double)N_ENTRIES * N_LOOPS * DELAY / 1e6, status.tick);
+
+    if ((nPasses != N_LOOPS) || (nDone != 1)) { err |= 1; }
+    if (RPIHAL_GPIO_read64() & (RPIHAL_GPIO_BIT(PIN_A) | RPIHAL_GPIO_BIT(PIN_B))) { err |= 1; } // last entry clears both
+
+
+
+    // the register writes (anon backend only): set word, then the inverted clear word of each entry
+
+    if (backend == RPIHAL_GPIO_BACKEND_ANON)
+    {
+        size_t k = 0;
+
+        for (int loop = 0; loop < N_LOOPS; ++loop)
+        {
+            for (int i = 0; i < N_ENTRIES; ++i)
+            {
+                if (wave[i].set && ((k >= traceCount) || (trace[k++] != (uint32_t)wave[i].set))) { err |= 1; }
+                if (wave[i].clr && ((k >= traceCount) || (trace[k++] != ~(uint32_t)wave[i].clr))) { err |= 1; }
+            }
+        }
+
+        if (k != traceCount) { err |= 1; }
+
+        printf("%zu register writes checked\n", traceCount);
+    }
+
+
+
+    // the patch control blocks of too many loops don't fit into the DMA memory
+
+    config.loops = RPIHAL_GPIODMA_MEM_MAX / 32;
+    if (RPIHAL_GPIODMA_play(&inst, wave, N_ENTRIES, &config) == 0)
+    {
+        printf("too many loops accepted\n");
+        RPIHAL_GPIODMA_stop(&inst);
+        err |= 1;
+    }
+
+
+
+    // endless, stopped
+
+    config.loops = 0;
+    nDone = 0;
+
+    if (RPIHAL_GPIODMA_play(&inst, wave, N_ENTRIES, &config) != 0)
+    {
+        printf("failed to start DMA playback\n");
+        return 1;
+    }
+
+    usleep(20000);
+    err |= RPIHAL_GPIODMA_getStatus(&inst, &status);
+    if (!status.running) { err |= 1; }
+    printf("endless: pass %llu step %zu\n", (unsigned long long)status.pass, status.step);
+
+    if (RPIHAL_GPIODMA_wait(&inst) == 0) { err |= 1; }
+    err |= RPIHAL_GPIODMA_stop(&inst);
+    if (nDone != 1) { err |= 1; }
+
+    err |= RPIHAL_PWM_deinit();
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}
@@ -0,0 +1,223 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// usage: rpihal-system-test-gpioevent <chip> <pin> [<sim-line>]
+//
+// Without `sim-line` the events of 10s are printed. With `sim-line` (a gpio-sim line directory in sysfs, see readme.md)
+// the edges are generated by switching the pull of the simulated line and checked, once read one by one and once as a
+// burst through the reader thread and ring.
+
+
+#include <poll.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rpihal/gpio.h>
+#include <rpihal/gpioevent.h>
+
+
+#define N_SIM_EDGES   (1000)
+#define BATCH_SIZE    (16)
+#define RING_CAPACITY (4096)
+
+
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static int setSimPull(const char* simLine, int up)
+{
+    char path[300];
+    snprintf(path, sizeof(path), "%s/pull", simLine);
+
+    FILE* fp = fopen(path, "w");
+    if (!fp) { return -1; }
+
+    const int r = fputs((up ? "pull-up" : "pull-down"), fp);
+
+    return ((fclose(fp) == 0) && (r >= 0)) ? 0 : -1;
+}
+
+static void printEvent(const RPIHAL_GPIOEVENT_event_t* ev)
+{
+    printf("%10llu.%06llu  pin %2i  %-7s  seqno %u/%u\n", (unsigned long long)(ev->timestamp / 1000000000ull),
+           (unsigned long long)((ev->timestamp / 1000ull) % 1000000ull), ev->pin,
+           (ev->edge == RPIHAL_GPIO_EDGE_RISING ? "rising" : "falling"), ev->seqno, ev->lineSeqno);
+}
+
+static int testPrint(RPIHAL_GPIOEVENT_instance_t* inst)
+{
+    const uint64_t tEnd = now_ns() + 10000000000ull;
+
+    while (now_ns() < tEnd)
+    {
+        const int ret = RPIHAL_GPIOEVENT_wait(inst, 100);
+        if (ret < 0) { return -1; }
+
+        if (ret > 0)
+        {
+            RPIHAL_GPIOEVENT_event_t events[BATCH_SIZE];
+
+            const int n = RPIHAL_GPIOEVENT_read(inst, events, BATCH_SIZE);
+            if (n < 0) { return -1; }
+
+            for (int i = 0; i < n; ++i) { printEvent(events + i); }
+        }
+    }
+
+    return 0;
+}
+
+static int testSim(RPIHAL_GPIOEVENT_instance_t* inst, const char* simLine)
+{
+    int err = 0;
+    int nEvents = 0;
+    uint32_t lastSeqno = 0;
+    uint64_t latencySum = 0;
+    uint64_t latencyMax = 0;
+
+    if (setSimPull(simLine, 0) != 0)
+    {
+        printf("failed to write to \"%s/pull\"\n", simLine);
+        return -1;
+    }
+
+    // discard the event of the initial state
+    while (RPIHAL_GPIOEVENT_wait(inst, 10) > 0)
+    {
+        RPIHAL_GPIOEVENT_event_t events[BATCH_SIZE];
+        const int n = RPIHAL_GPIOEVENT_read(inst, events, BATCH_SIZE);
+        if (n > 0) { lastSeqno = events[n - 1].seqno; }
+    }
+
+    const uint64_t t0 = now_ns();
+
+    for (int i = 0; (i < N_SIM_EDGES) && !err; ++i)
+    {
+        const int rising = ((i % 2) == 0);
+        const uint64_t tEdge = now_ns();
+
+        err |= setSimPull(simLine, rising);
+
+        RPIHAL_GPIOEVENT_event_t ev;
+
+        if (RPIHAL_GPIOEVENT_wait(inst, 1000) != 1) { err |= 1; }
+        else if (RPIHAL_GPIOEVENT_read(inst, &ev, 1) != 1) { err |= 1; }
+        else
+        {
+            const uint64_t latency = ev.timestamp - tEdge;
+
+            if (ev.edge != (rising ? RPIHAL_GPIO_EDGE_RISING : RPIHAL_GPIO_EDGE_FALLING)) { err |= 1; }
+            if (ev.seqno <= lastSeqno) { err |= 1; }
+            if (err) { printEvent(&ev); }
+
+            lastSeqno = ev.seqno;
+            latencySum += latency;
+            if (latencyMax < latency) { latencyMax = latency; }
+            ++nEvents;
+        }
+    }
+
+    const uint64_t t = now_ns() - t0;
+
+    printf("%i/%i edges received, %.2f us/edge\n", nEvents, N_SIM_EDGES, (double)t / 1000.0 / (double)N_SIM_EDGES);
+    if (nEvents)
+    {
+        printf("pull write to timestamp: avg %.2f us, max %.2f us\n", (double)latencySum / 1000.0 / (double)nEvents,
+               (double)latencyMax / 1000.0);
+    }
+
+    return (err ? -1 : 0);
+}
+
+static int testSimRing(RPIHAL_GPIOEVENT_instance_t* inst, const char* simLine)
+{
+    int err = 0;
+
+    if (RPIHAL_GPIOEVENT_startReader(inst, RING_CAPACITY) != 0) { return -1; }
+
+    const uint64_t t0 = now_ns();
+    for (int i = 0; i < N_SIM_EDGES; ++i) { err |= setSimPull(simLine, ((i % 2) == 0)); }
+    const uint64_t t1 = now_ns();
+
+    // the reader signals the first event
+    struct pollfd pfd = { .fd = RPIHAL_GPIOEVENT_getReaderFd(inst), .events = POLLIN, .revents = 0 };
+    if (poll(&pfd, 1, 1000) != 1) { err |= 1; }
+
+    uint64_t nWakeups = 0;
+    if (read(pfd.fd, &nWakeups, sizeof(nWakeups)) != sizeof(nWakeups)) { err |= 1; }
+
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = 100000000 };
+    nanosleep(&ts, NULL);
+
+    // a single drain without any syscall
+    static RPIHAL_GPIOEVENT_event_t events[RING_CAPACITY];
+    const size_t n = RPIHAL_GPIOEVENT_drain(inst, events, RING_CAPACITY);
+
+    for (size_t i = 1; i < n; ++i)
+    {
+        if ((events[i].seqno != (events[i - 1].seqno + 1)) || (events[i].edge == events[i - 1].edge)) { err |= 1; }
+    }
+
+    RPIHAL_GPIOEVENT_stats_t stats;
+    err |= RPIHAL_GPIOEVENT_getStats(inst, &stats);
+    err |= RPIHAL_GPIOEVENT_stopReader(inst);
+
+    printf("ring: %zu/%i events drained, %.2f us/edge generated, %llu wake-ups\n", n, N_SIM_EDGES, (double)(t1 - t0) / 1000.0 / (double)N_SIM_EDGES,
+           (unsigned long long)nWakeups);
+    printf("ring: events %llu, overflows %llu, kernel overflows %llu, high water %zu/%zu\n", (unsigned long long)stats.events,
+           (unsigned long long)stats.overflows, (unsigned long long)stats.kernelOverflows, stats.highWater, stats.capacity);
+
+    if ((n != N_SIM_EDGES) || stats.overflows || stats.kernelOverflows || stats.error) { err |= 1; }
+
+    return (err ? -1 : 0);
+}
+
+
+
+int main(int argc, char** argv)
+{
+    if ((argc < 3) || (argc > 4))
+    {
+        printf("usage: %s <chip> <pin> [<sim-line>]\n", argv[0]);
+        return 1;
+    }
+
+    const char* chip = argv[1];
+    const int pin = atoi(argv[2]);
+    const char* simLine = ((argc > 3) ? argv[3] : NULL);
+
+    RPIHAL_GPIOEVENT_instance_t inst;
+
+    if (RPIHAL_GPIOEVENT_open(&inst, chip, RPIHAL_GPIO_BIT(pin), RPIHAL_GPIO_EDGE_BOTH, RPIHAL_GPIOEVENT_CFG_DEFAULT) != 0)
+    {
+        return 1;
+    }
+
+    int err;
+
+    if (simLine)
+    {
+        err = testSim(&inst, simLine);
+        if (!err) { err = testSimRing(&inst, simLine); }
+    }
+    else { err = testPrint(&inst); }
+
+    RPIHAL_GPIOEVENT_close(&inst);
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}
@@ -0,0 +1,146 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// Plays a square wave and prints the timing error, compared to `RPIHAL_GPIO_writePin()` with `usleep()`.
+//
+// usage: rpihal-system-test-gpiowave [anon|mmap] [<cpu> <priority>]
+//
+// With the anon backend it runs on any Linux machine (see makefile). On hardware the output pin is toggled, so nothing
+// must be connected to it.
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rpihal/gpio.h>
+#include <rpihal/gpiowave.h>
+#include <rpihal/rpihal.h>
+
+
+#define PIN_OUT 22
+
+#define N_ENTRIES (1000)
+#define N_LOOPS   (5)
+#define DELAY     (50000) // [ns]
+
+
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+    int backend = RPIHAL_GPIO_BACKEND_ANON;
+    RPIHAL_model_t model = RPIHAL_model_4B;
+
+    RPIHAL_GPIOWAVE_config_t config;
+    RPIHAL_GPIOWAVE_defaultConfig(&config);
+    config.loops = N_LOOPS;
+
+    int argi = 1;
+
+    if (argc > argi)
+    {
+        if (strcmp(argv[argi], "mmap") == 0)
+        {
+            backend = RPIHAL_GPIO_BACKEND_MMAP;
+            model = RPIHAL_model_unknown;
+        }
+        ++argi;
+    }
+
+    if (argc > (argi + 1))
+    {
+        config.cpu = atoi(argv[argi]);
+        config.priority = atoi(argv[argi + 1]);
+    }
+
+    if (RPIHAL_GPIO_initBackend(backend, model) != 0)
+    {
+        printf("failed to init GPIO\n");
+        return 1;
+    }
+
+    int err = 0;
+
+    RPIHAL_GPIO_init_t initStruct;
+    RPIHAL_GPIO_defaultInitStruct(&initStruct);
+    initStruct.mode = RPIHAL_GPIO_MODE_OUT;
+    err |= RPIHAL_GPIO_initPin(PIN_OUT, &initStruct);
+
+
+
+    // reference: writePin() and usleep()
+
+    uint64_t maxError = 0;
+    double sumError = 0;
+    uint64_t deadline = now_ns();
+
+    for (int i = 0; i < N_ENTRIES; ++i)
+    {
+        const uint64_t t = now_ns();
+        err |= RPIHAL_GPIO_writePin(PIN_OUT, ((i % 2) == 0));
+
+        const uint64_t error = (t > deadline ? t - deadline : deadline - t);
+        if (maxError < error) { maxError = error; }
+        sumError += (double)error;
+
+        deadline += DELAY;
+        usleep(DELAY / 1000);
+    }
+
+    printf("writePin+usleep  mean error %8.2fus, max %8.2fus\n", sumError / N_ENTRIES / 1000.0, (double)maxError / 1000.0);
+
+
+
+    // waveform
+
+    static RPIHAL_GPIOWAVE_entry_t wave[N_ENTRIES];
+
+    for (int i = 0; i < N_ENTRIES; ++i)
+    {
+        wave[i].set = (((i % 2) == 0) ? RPIHAL_GPIO_BIT(PIN_OUT) : 0);
+        wave[i].clr = (((i % 2) == 0) ? 0 : RPIHAL_GPIO_BIT(PIN_OUT));
+        wave[i].delay = DELAY;
+    }
+
+    RPIHAL_GPIOWAVE_instance_t inst;
+    RPIHAL_GPIOWAVE_stats_t stats;
+
+    if (RPIHAL_GPIOWAVE_play(&inst, wave, N_ENTRIES, &config) != 0)
+    {
+        printf("failed to start playback\n");
+        return 1;
+    }
+
+    do
+    {
+        usleep(10000);
+        err |= RPIHAL_GPIOWAVE_getStats(&inst, &stats);
+    }
+    while (stats.running);
+
+    err |= RPIHAL_GPIOWAVE_wait(&inst);
+
+    printf("waveform         mean error %8.2fus, max %8.2fus, stddev %.2fus, late %llu/%llu\n", stats.meanError / 1000.0,
+           (double)stats.maxError / 1000.0, stats.stdDev / 1000.0, (unsigned long long)stats.late, (unsigned long long)stats.entries);
+
+    if (stats.entries != (N_ENTRIES * N_LOOPS)) { err |= 1; }
+    if (RPIHAL_GPIO_readPin(PIN_OUT) != 0) { err |= 1; } // last entry clears
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}
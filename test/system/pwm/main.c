@@ -0,0 +1,130 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// Streams a sample buffer through the PWM FIFO in serialiser mode and sets a mark-space duty cycle on the second
+// channel.
+//
+// usage: rpihal-system-test-pwm [anon|mmap]
+//
+// With the anon backend it runs on any Linux machine (see makefile). On hardware (root needed) channel 0 is output on
+// GPIO 18 and channel 1 on GPIO 19, so nothing must be connected to them.
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <rpihal/gpio.h>
+#include <rpihal/pwm.h>
+#include <rpihal/rpihal.h>
+
+
+#define PIN_CH0 18
+#define PIN_CH1 19
+
+#define N_SAMPLES (4096)
+
+
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+    int backend = RPIHAL_GPIO_BACKEND_ANON;
+    RPIHAL_model_t model = RPIHAL_model_4B;
+
+    if ((argc > 1) && (strcmp(argv[1], "mmap") == 0))
+    {
+        backend = RPIHAL_GPIO_BACKEND_MMAP;
+        model = RPIHAL_model_unknown;
+    }
+
+    if ((RPIHAL_GPIO_initBackend(backend, model) != 0) || (RPIHAL_PWM_initBackend(backend, model) != 0))
+    {
+        printf("failed to init GPIO/PWM\n");
+        return 1;
+    }
+
+    int err = 0;
+
+    RPIHAL_GPIO_init_t initStruct;
+    RPIHAL_GPIO_defaultInitStruct(&initStruct);
+    initStruct.mode = RPIHAL_GPIO_MODE_AF;
+    initStruct.altfunc = RPIHAL_GPIO_AF_5;
+    err |= RPIHAL_GPIO_initPins(RPIHAL_GPIO_BIT(PIN_CH0) | RPIHAL_GPIO_BIT(PIN_CH1), &initStruct);
+
+    uint32_t clock;
+    err |= RPIHAL_PWM_setClock(1000000, &clock);
+    printf("PWM clock %uHz\n", clock);
+
+
+
+    // invalid arguments
+
+    RPIHAL_PWM_chConfig_t config;
+    RPIHAL_PWM_defaultChConfig(&config);
+
+    if (RPIHAL_PWM_configChannel(2, &config) == 0) { err |= 1; }
+    config.mode = RPIHAL_PWM_MODE_SERIAL;
+    config.range = 33;
+    if (RPIHAL_PWM_configChannel(0, &config) == 0) { err |= 1; }
+
+
+
+    // channel 1: 25% mark-space
+
+    RPIHAL_PWM_defaultChConfig(&config);
+    config.range = 100;
+    err |= RPIHAL_PWM_configChannel(1, &config);
+    err |= RPIHAL_PWM_setData(1, 25);
+    err |= RPIHAL_PWM_enable(1, 1);
+
+
+
+    // channel 0: serialiser fed from the FIFO, 32 bits per word
+
+    static uint32_t samples[N_SAMPLES];
+    for (int i = 0; i < N_SAMPLES; ++i) { samples[i] = (((uint32_t)i * 0x9E3779B9u) ^ 0xAAAAAAAAu); }
+
+    RPIHAL_PWM_defaultChConfig(&config);
+    config.mode = RPIHAL_PWM_MODE_SERIAL;
+    config.range = 32;
+    config.useFifo = 1;
+    err |= RPIHAL_PWM_configChannel(0, &config);
+    err |= RPIHAL_PWM_clearFifo();
+
+    const int n = RPIHAL_PWM_writeFifo(samples, N_SAMPLES);
+    if ((n < 0) || (n > N_SAMPLES)) { err |= 1; }
+
+    err |= RPIHAL_PWM_enable(0, 1);
+
+    const uint64_t t0 = now_ns();
+    err |= RPIHAL_PWM_streamFifo(samples + n, N_SAMPLES - n);
+    const uint64_t t1 = now_ns();
+
+    // 4096 words at 32 bits each take about 131ms at 1MHz on hardware
+    printf("streamed %i words in %.2fms\n", N_SAMPLES, (double)(t1 - t0) / 1e6);
+
+    RPIHAL_PWM_status_t status;
+    err |= RPIHAL_PWM_getStatus(&status);
+    printf("status: full %i, empty %i, werr %i, rerr %i, gap %i/%i, berr %i, running %i/%i\n", status.fifoFull, status.fifoEmpty,
+           status.writeError, status.readError, status.gap[0], status.gap[1], status.busError, status.running[0], status.running[1]);
+
+    if (status.writeError || status.busError) { err |= 1; }
+
+    err |= RPIHAL_PWM_deinit();
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}
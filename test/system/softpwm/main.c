@@ -0,0 +1,141 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// Drives 16 software PWM channels and prints the timing error of the merged edge writes. The duty cycles and the
+// frequency are changed while running.
+//
+// usage: rpihal-system-test-softpwm [anon|mmap] [<cpu> <priority>]
+//
+// With the anon backend it runs on any Linux machine (see makefile). On hardware GPIO 4..19 are driven, so nothing must
+// be connected to them.
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rpihal/gpio.h>
+#include <rpihal/rpihal.h>
+#include <rpihal/softpwm.h>
+
+
+#define PIN_FIRST (4)
+#define N_CHANNELS (16)
+
+#define RUN_TIME (1000000) // [us] per step
+
+
+
+static void printStats(const char* name, const RPIHAL_SOFTPWM_stats_t* stats)
+{
+    printf("%-24s periods %6llu, writes %7llu, mean error %8.2fus, max %8.2fus, late %llu, skipped %llu\n", name,
+           (unsigned long long)stats->periods, (unsigned long long)stats->writes, stats->meanError / 1000.0,
+           (double)stats->maxError / 1000.0, (unsigned long long)stats->late, (unsigned long long)stats->skipped);
+}
+
+int main(int argc, char** argv)
+{
+    int backend = RPIHAL_GPIO_BACKEND_ANON;
+    RPIHAL_model_t model = RPIHAL_model_4B;
+
+    RPIHAL_SOFTPWM_config_t config;
+    RPIHAL_SOFTPWM_defaultConfig(&config);
+
+    int argi = 1;
+
+    if (argc > argi)
+    {
+        if (strcmp(argv[argi], "mmap") == 0)
+        {
+            backend = RPIHAL_GPIO_BACKEND_MMAP;
+            model = RPIHAL_model_unknown;
+        }
+        ++argi;
+    }
+
+    if (argc > (argi + 1))
+    {
+        config.cpu = atoi(argv[argi]);
+        config.priority = atoi(argv[argi + 1]);
+    }
+
+    if (RPIHAL_GPIO_initBackend(backend, model) != 0)
+    {
+        printf("failed to init GPIO\n");
+        return 1;
+    }
+
+    int err = 0;
+
+    uint64_t bits = 0;
+    for (int i = 0; i < N_CHANNELS; ++i) { bits |= RPIHAL_GPIO_BIT(PIN_FIRST + i); }
+
+    RPIHAL_GPIO_init_t initStruct;
+    RPIHAL_GPIO_defaultInitStruct(&initStruct);
+    initStruct.mode = RPIHAL_GPIO_MODE_OUT;
+    err |= RPIHAL_GPIO_initPins(bits, &initStruct);
+
+    config.bits = bits;
+
+    RPIHAL_SOFTPWM_instance_t inst;
+    RPIHAL_SOFTPWM_stats_t stats;
+
+    if (RPIHAL_SOFTPWM_start(&inst, &config) != 0)
+    {
+        printf("failed to start software PWM\n");
+        return 1;
+    }
+
+    if (RPIHAL_SOFTPWM_setDuty(&inst, RPIHAL_GPIO_BIT(0), 5000) == 0) { err |= 1; } // not a channel
+    if (RPIHAL_SOFTPWM_setDuty(&inst, bits, RPIHAL_SOFTPWM_DUTY_MAX + 1) == 0) { err |= 1; }
+
+
+
+    // 16 distinct duty cycles, 17 writes per period
+
+    for (int i = 0; i < N_CHANNELS; ++i) { err |= RPIHAL_SOFTPWM_setDuty(&inst, RPIHAL_GPIO_BIT(PIN_FIRST + i), (i + 1) * 600); }
+    usleep(RUN_TIME);
+    err |= RPIHAL_SOFTPWM_getStats(&inst, &stats);
+    printStats("16 edges @1kHz", &stats);
+
+    const uint64_t periods = stats.periods;
+    const uint64_t writes = stats.writes;
+
+
+
+    // 4 groups with the same duty cycle are merged, 5 writes per period
+
+    for (int i = 0; i < N_CHANNELS; ++i) { err |= RPIHAL_SOFTPWM_setDuty(&inst, RPIHAL_GPIO_BIT(PIN_FIRST + i), ((i % 4) + 1) * 2000); }
+    usleep(RUN_TIME);
+    err |= RPIHAL_SOFTPWM_getStats(&inst, &stats);
+    printStats("4 merged edges @1kHz", &stats);
+
+    // one write per period is expected, the number of edges changed somewhere inbetween
+    const uint64_t dp = stats.periods - periods;
+    const uint64_t dw = stats.writes - writes;
+    if ((dw < (dp * 5)) || (dw > (dp * 17))) { err |= 1; }
+
+
+
+    err |= RPIHAL_SOFTPWM_setFrequency(&inst, 200);
+    if (RPIHAL_SOFTPWM_setFrequency(&inst, 2000000) == 0) { err |= 1; } // period below resolution
+    usleep(RUN_TIME);
+    err |= RPIHAL_SOFTPWM_getStats(&inst, &stats);
+    printStats("4 merged edges @200Hz", &stats);
+
+    if (!stats.running) { err |= 1; }
+
+    err |= RPIHAL_SOFTPWM_stop(&inst);
+
+    if (RPIHAL_GPIO_read64() & bits) { err |= 1; }
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}
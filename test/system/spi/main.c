@@ -0,0 +1,256 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// Checks SPI transactions. With the loopback backend it runs on any Linux machine (see makefile).
+//
+// usage: rpihal-system-test-spi [loopback|/dev/spidevX.Y]
+//
+// On a spidev device MOSI has to be connected to MISO. A transaction of a command, a payload and a dummy read segment
+// is transferred and the received data is checked. Then the time of a transaction is compared to transferring the same
+// segments one by one.
+//
+// A transfer larger than bufsiz has to be split and a transaction larger than bufsiz has to fail. The buffers of a pool
+// have to be page aligned and distinct, and each buffer is handed out only once.
+//
+// A second instance with a different mode is opened on the same device, the mode may only be re-applied when the
+// transferring instance changes (loopback only, on hardware the second instance would change the wiring).
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rpihal/rpihal.h>
+#include <rpihal/spi.h>
+
+
+#define SPEED (1000000)
+
+#define N_ITER (1000)
+
+#define N_POOL_BUFFERS (8)
+
+
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static int checkBuffer(const char* name, const uint8_t* data, const uint8_t* expected, size_t count)
+{
+    if (memcmp(data, expected, count) != 0)
+    {
+        printf("%s mismatch\n", name);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+int main(int argc, char** argv)
+{
+    int backend = RPIHAL_SPI_BACKEND_LOOPBACK;
+    const char* dev = "loopback";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "loopback") == 0)
+        {
+            backend = RPIHAL_SPI_BACKEND_LOOPBACK;
+            dev = "loopback";
+        }
+        else if (strncmp(argv[i], "/dev/", 5) == 0)
+        {
+            backend = RPIHAL_SPI_BACKEND_SPIDEV;
+            dev = argv[i];
+        }
+        else
+        {
+            printf("usage: %s [loopback|/dev/spidevX.Y]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    RPIHAL_SPI_instance_t spi;
+
+    if (RPIHAL_SPI_openBackend(&spi, dev, SPEED, 0, backend) != 0)
+    {
+        printf("failed to open SPI\n");
+        return 1;
+    }
+
+    int err = 0;
+
+    const uint8_t cmd[4] = { 0x03, 0x12, 0x34, 0x56 };
+    uint8_t payload[64];
+    uint8_t cmdRx[sizeof(cmd)];
+    uint8_t payloadRx[sizeof(payload)];
+    uint8_t dummyRx[16];
+    uint8_t zeros[sizeof(dummyRx)];
+
+    for (size_t i = 0; i < sizeof(payload); ++i) { payload[i] = (uint8_t)(i * 7 + 1); }
+    memset(cmdRx, 0xA5, sizeof(cmdRx));
+    memset(payloadRx, 0xA5, sizeof(payloadRx));
+    memset(dummyRx, 0xA5, sizeof(dummyRx));
+    memset(zeros, 0, sizeof(zeros));
+
+    RPIHAL_SPI_segment_t segments[3];
+    memset(segments, 0, sizeof(segments));
+
+    segments[0].txData = cmd;
+    segments[0].rxBuffer = cmdRx;
+    segments[0].count = sizeof(cmd);
+    segments[0].delay = 10;
+
+    segments[1].txData = payload;
+    segments[1].rxBuffer = payloadRx;
+    segments[1].count = sizeof(payload);
+    segments[1].speed = SPEED / 2;
+
+    segments[2].txData = NULL; // transmits zeros
+    segments[2].rxBuffer = dummyRx;
+    segments[2].count = sizeof(dummyRx);
+
+    err |= (RPIHAL_SPI_transaction(&spi, segments, 3) != 0);
+    err |= checkBuffer("command", cmdRx, cmd, sizeof(cmd));
+    err |= checkBuffer("payload", payloadRx, payload, sizeof(payload));
+    err |= checkBuffer("dummy", dummyRx, zeros, sizeof(dummyRx));
+
+    // invalid number of segments
+    if (RPIHAL_SPI_transaction(&spi, segments, 0) == 0) { err |= 1; }
+    if (RPIHAL_SPI_transaction(&spi, segments, RPIHAL_SPI_SEGMENTS_MAX + 1) == 0) { err |= 1; }
+
+
+
+    segments[0].delay = 0;
+    segments[1].speed = 0;
+
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < N_ITER; ++i) { err |= (RPIHAL_SPI_transaction(&spi, segments, 3) != 0); }
+    const uint64_t tTransaction = now_ns() - t0;
+
+    t0 = now_ns();
+    for (int i = 0; i < N_ITER; ++i)
+    {
+        for (int j = 0; j < 3; ++j) { err |= (RPIHAL_SPI_transfer(&spi, segments[j].txData, segments[j].rxBuffer, segments[j].count) != 0); }
+    }
+    const uint64_t tTransfers = now_ns() - t0;
+
+    printf("transaction   %8.2f us\n", (double)tTransaction / (double)N_ITER / 1000.0);
+    printf("3x transfer   %8.2f us\n", (double)tTransfers / (double)N_ITER / 1000.0);
+
+
+
+    // larger than bufsiz
+
+    const size_t largeSize = (3 * spi.bufsiz) + 100;
+    uint8_t* largeTx = (uint8_t*)malloc(largeSize);
+    uint8_t* largeRx = (uint8_t*)malloc(largeSize);
+
+    if (largeTx && largeRx)
+    {
+        for (size_t i = 0; i < largeSize; ++i) { largeTx[i] = (uint8_t)(i ^ (i >> 8)); }
+        memset(largeRx, 0, largeSize);
+
+        err |= (RPIHAL_SPI_transfer(&spi, largeTx, largeRx, largeSize) != 0);
+        err |= checkBuffer("large transfer", largeRx, largeTx, largeSize);
+
+        segments[0].txData = largeTx;
+        segments[0].rxBuffer = largeRx;
+        segments[0].count = spi.bufsiz + 1;
+        if (RPIHAL_SPI_transaction(&spi, segments, 1) == 0) { err |= 1; }
+
+        printf("bufsiz %zu, transferred %zu bytes\n", spi.bufsiz, largeSize);
+    }
+    else { err |= 1; }
+
+    free(largeTx);
+    free(largeRx);
+
+
+
+    // pool
+
+    RPIHAL_SPI_pool_t pool;
+    uint8_t* buffers[N_POOL_BUFFERS];
+    const uintptr_t pageMask = (uintptr_t)sysconf(_SC_PAGESIZE) - 1;
+
+    err |= (RPIHAL_SPI_poolCreate(&pool, &spi, N_POOL_BUFFERS) != 0);
+
+    for (int i = 0; i < N_POOL_BUFFERS; ++i)
+    {
+        buffers[i] = RPIHAL_SPI_poolGet(&pool);
+
+        if (!buffers[i] || ((uintptr_t)(buffers[i]) & pageMask))
+        {
+            printf("invalid pool buffer %i: %p\n", i, (void*)buffers[i]);
+            err |= 1;
+        }
+
+        for (int j = 0; j < i; ++j)
+        {
+            if (buffers[i] == buffers[j]) { err |= 1; }
+        }
+    }
+
+    if (RPIHAL_SPI_poolGet(&pool) != NULL) { err |= 1; } // exhausted
+
+    if (!err)
+    {
+        memset(buffers[0], 0x5A, pool.bufferSize);
+        err |= (RPIHAL_SPI_transfer(&spi, buffers[0], buffers[1], pool.bufferSize) != 0);
+        err |= checkBuffer("pool transfer", buffers[1], buffers[0], pool.bufferSize);
+    }
+
+    RPIHAL_SPI_poolPut(&pool, buffers[3]);
+    if (RPIHAL_SPI_poolGet(&pool) != buffers[3]) { err |= 1; }
+
+    for (int i = 0; i < N_POOL_BUFFERS; ++i) { RPIHAL_SPI_poolPut(&pool, buffers[i]); }
+    RPIHAL_SPI_poolDestroy(&pool);
+
+
+
+    // mode switches
+
+    if (backend == RPIHAL_SPI_BACKEND_LOOPBACK)
+    {
+        RPIHAL_SPI_instance_t spi2, spiOther;
+
+        err |= (RPIHAL_SPI_openBackend(&spi2, dev, SPEED, RPIHAL_SPI_CFG_MODE_2, backend) != 0);
+        err |= (RPIHAL_SPI_openBackend(&spiOther, "other", SPEED, RPIHAL_SPI_CFG_MODE_3, backend) != 0);
+
+        // the mode of spi2 is applied by its open
+        const RPIHAL_SPI_instance_t* const order[] = { &spi, &spi, &spiOther, &spi2, &spi2, &spi, &spiOther, &spi2 };
+        const uint64_t expected = 4;
+
+        for (size_t i = 0; i < (sizeof(order) / sizeof(order[0])); ++i) { err |= (RPIHAL_SPI_transfer(order[i], cmd, cmdRx, sizeof(cmd)) != 0); }
+
+        const uint64_t switches = RPIHAL_SPI_getModeSwitches(&spi);
+        printf("mode switches %llu (%llu), other device %llu\n", (unsigned long long)switches, (unsigned long long)expected,
+               (unsigned long long)RPIHAL_SPI_getModeSwitches(&spiOther));
+
+        if ((switches != expected) || (RPIHAL_SPI_getModeSwitches(&spi2) != expected) || (RPIHAL_SPI_getModeSwitches(&spiOther) != 0)) { err |= 1; }
+
+        err |= (RPIHAL_SPI_close(&spi2) != 0);
+        err |= (RPIHAL_SPI_close(&spiOther) != 0);
+    }
+
+    err |= (RPIHAL_SPI_close(&spi) != 0);
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+    else { printf("\033[92mOK\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}
@@ -0,0 +1,214 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// Checks the SPI ADC sampling engine. With the loopback backend it runs on any Linux machine (see makefile).
+//
+// usage: rpihal-system-test-spiadc [loopback|/dev/spidevX.Y]
+//
+// A paced run checks the number of scans, the timestamps and the rate. Then the throughput of a free running sampling
+// is compared to converting the channels by one `RPIHAL_SPI_transfer()` each. On hardware a MCP3208 has to be
+// connected, the values are printed. With the loopback backend the values are 0 (the command frames are echoed).
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rpihal/rpihal.h>
+#include <rpihal/spi.h>
+#include <rpihal/spiadc.h>
+
+
+#define SPEED (1000000)
+
+#define PACED_RATE   (2000)
+#define PACED_SCANS  (1001) // not a multiple of the scans per message
+#define N_FREE_SCANS (20000)
+
+
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+// reads the scans until the sampling has stopped, checks the timestamps and returns the number of scans
+static uint64_t drain(RPIHAL_SPIADC_instance_t* adc, int* err, RPIHAL_SPIADC_scan_t* last)
+{
+    RPIHAL_SPIADC_scan_t scans[256];
+    RPIHAL_SPIADC_stats_t stats;
+    uint64_t count = 0;
+    uint64_t ts = 0;
+
+    do
+    {
+        usleep(1000);
+
+        *err |= (RPIHAL_SPIADC_getStats(adc, &stats) != 0);
+
+        size_t n;
+        while ((n = RPIHAL_SPIADC_read(adc, scans, sizeof(scans) / sizeof(scans[0]))) > 0)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                if ((count > 0) && (scans[i].timestamp < ts))
+                {
+                    printf("timestamp of scan %llu is decreasing\n", (unsigned long long)count);
+                    *err |= 1;
+                }
+
+                ts = scans[i].timestamp;
+                *last = scans[i];
+                ++count;
+            }
+        }
+    }
+    while (stats.running);
+
+    // scans pushed between the last read and the end of the thread
+    size_t n;
+    while ((n = RPIHAL_SPIADC_read(adc, scans, sizeof(scans) / sizeof(scans[0]))) > 0)
+    {
+        count += n;
+        *last = scans[n - 1];
+    }
+
+    if (stats.error || (stats.overflows != 0))
+    {
+        printf("error: %i, overflows: %llu\n", stats.error, (unsigned long long)stats.overflows);
+        *err |= 1;
+    }
+
+    printf("%llu scans in %llu messages, late: %llu, max lateness: %llu us\n", (unsigned long long)stats.scans, (unsigned long long)stats.messages,
+           (unsigned long long)stats.late, (unsigned long long)(stats.maxLateness / 1000));
+
+    return count;
+}
+
+
+
+int main(int argc, char** argv)
+{
+    int backend = RPIHAL_SPI_BACKEND_LOOPBACK;
+    const char* dev = "loopback";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "loopback") == 0)
+        {
+            backend = RPIHAL_SPI_BACKEND_LOOPBACK;
+            dev = "loopback";
+        }
+        else if (strncmp(argv[i], "/dev/", 5) == 0)
+        {
+            backend = RPIHAL_SPI_BACKEND_SPIDEV;
+            dev = argv[i];
+        }
+        else
+        {
+            printf("usage: %s [loopback|/dev/spidevX.Y]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    RPIHAL_SPI_instance_t spi;
+
+    if (RPIHAL_SPI_openBackend(&spi, dev, SPEED, 0, backend) != 0)
+    {
+        printf("failed to open SPI\n");
+        return 1;
+    }
+
+    int err = 0;
+    RPIHAL_SPIADC_instance_t adc;
+    RPIHAL_SPIADC_config_t config;
+    RPIHAL_SPIADC_scan_t last;
+
+    RPIHAL_SPIADC_defaultConfig(&config);
+    config.spi = &spi;
+
+
+
+    // paced
+
+    config.rate = PACED_RATE;
+    config.nScans = PACED_SCANS;
+
+    uint64_t t0 = now_ns();
+    err |= (RPIHAL_SPIADC_start(&adc, &config) != 0);
+    uint64_t count = drain(&adc, &err, &last);
+    const uint64_t tPaced = now_ns() - t0;
+    err |= (RPIHAL_SPIADC_stop(&adc) != 0);
+
+    // the rate is checked by the timestamp of the last scan, the duration contains the polling of `drain()`
+    const double rate = (double)(PACED_SCANS - 1) * 1e9 / (double)last.timestamp;
+    printf("paced: %llu scans, %.1f scans/s (%u), %.3f s\n", (unsigned long long)count, rate, PACED_RATE, (double)tPaced / 1e9);
+
+    if (count != PACED_SCANS) { err |= 1; }
+    if ((rate < (PACED_RATE * 0.9)) || (rate > (PACED_RATE * 1.1))) { err |= 1; }
+
+    printf("values:");
+    for (size_t ch = 0; ch < config.nChannels; ++ch) { printf(" %4u", last.value[ch]); }
+    printf("\n");
+
+
+
+    // free running
+
+    config.rate = 0;
+    config.nScans = N_FREE_SCANS;
+    config.capacity = N_FREE_SCANS;
+
+    t0 = now_ns();
+    err |= (RPIHAL_SPIADC_start(&adc, &config) != 0);
+    count = drain(&adc, &err, &last);
+    const uint64_t tFree = now_ns() - t0;
+    err |= (RPIHAL_SPIADC_stop(&adc) != 0);
+
+    if (count != N_FREE_SCANS) { err |= 1; }
+
+    // a message period below 1ns is rejected
+    const size_t spm = config.scansPerMessage;
+    config.scansPerMessage = 1;
+    config.rate = 2000000000u;
+    if (RPIHAL_SPIADC_start(&adc, &config) == 0)
+    {
+        err |= 1;
+        RPIHAL_SPIADC_stop(&adc);
+    }
+    config.scansPerMessage = spm;
+    config.rate = 0;
+
+    uint8_t tx[3] = { 0x06, 0x00, 0x00 };
+    uint8_t rx[3];
+
+    t0 = now_ns();
+    for (int i = 0; i < N_FREE_SCANS; ++i)
+    {
+        for (size_t ch = 0; ch < config.nChannels; ++ch)
+        {
+            tx[0] = (uint8_t)(0x06 | ((config.channels[ch] >> 2) & 0x01));
+            tx[1] = (uint8_t)((config.channels[ch] & 0x03) << 6);
+            err |= (RPIHAL_SPI_transfer(&spi, tx, rx, sizeof(tx)) != 0);
+        }
+    }
+    const uint64_t tTransfer = now_ns() - t0;
+
+    printf("spiadc      %10.0f scans/s\n", (double)N_FREE_SCANS * 1e9 / (double)tFree);
+    printf("transfer    %10.0f scans/s\n", (double)N_FREE_SCANS * 1e9 / (double)tTransfer);
+
+    err |= (RPIHAL_SPI_close(&spi) != 0);
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+    else { printf("\033[92mOK\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}
@@ -0,0 +1,255 @@
+/*
+author          Oliver Blaser
+date            17.10.2026
+copyright       MIT - Copyright (c) 2026 Oliver Blaser
+*/
+
+// Checks the asynchronous SPI request queue. With the loopback backend it runs on any Linux machine (see makefile).
+//
+// usage: rpihal-system-test-spiqueue [loopback|/dev/spidevX.Y /dev/spidevX.Z]
+//
+// Flushing and destroying the queue from a callback has to fail. While the worker is blocked in a callback the queue
+// is filled, the next submit has to be rejected. Then requests of two instances on the same bus are submitted from the
+// main loop, which polls the eventfd and counts its iterations. The callbacks check the received data (MOSI has to be
+// connected to MISO on hardware) and the order of completion.
+
+
+#include <poll.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rpihal/rpihal.h>
+#include <rpihal/spi.h>
+#include <rpihal/spiqueue.h>
+
+
+#define SPEED (1000000)
+
+#define CAPACITY   (16)
+#define N_SLOTS    (2 * CAPACITY) // more than can be in flight
+#define SLOT_SIZE  (256)
+#define N_REQUESTS (5000)
+
+
+
+static uint8_t txSlots[N_SLOTS][SLOT_SIZE];
+static uint8_t rxSlots[N_SLOTS][SLOT_SIZE];
+
+static int blocked = 0; // the blocking callback has been entered
+static int release = 0; // releases the blocking callback
+static int cbErr = 0;
+static uintptr_t lastIndex = 0;
+static uint64_t nCallbacks = 0;
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static void blockingCallback(const RPIHAL_SPIQUEUE_request_t* request, int result)
+{
+    RPIHAL_SPIQUEUE_instance_t* queue = (RPIHAL_SPIQUEUE_instance_t*)(request->user);
+
+    if (result != 0) { cbErr |= 1; }
+
+    // would deadlock
+    if ((RPIHAL_SPIQUEUE_flush(queue) == 0) || (RPIHAL_SPIQUEUE_destroy(queue) == 0)) { cbErr |= 1; }
+
+    __atomic_store_n(&blocked, 1, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&release, __ATOMIC_ACQUIRE)) { usleep(100); }
+}
+
+static void checkCallback(const RPIHAL_SPIQUEUE_request_t* request, int result)
+{
+    const uintptr_t index = (uintptr_t)(request->user);
+
+    if (result != 0) { cbErr |= 1; }
+
+    if ((nCallbacks > 0) && (index != (lastIndex + 1)))
+    {
+        printf("request %lu completed after %lu\n", (unsigned long)index, (unsigned long)lastIndex);
+        cbErr |= 1;
+    }
+
+    const size_t slot = index % N_SLOTS;
+    const size_t count = (request->segments ? (request->segments[0].count + request->segments[1].count) : request->count);
+
+    if (memcmp(rxSlots[slot], txSlots[slot], count) != 0)
+    {
+        printf("request %lu data mismatch\n", (unsigned long)index);
+        cbErr |= 1;
+    }
+
+    lastIndex = index;
+    ++nCallbacks;
+}
+
+
+
+int main(int argc, char** argv)
+{
+    int backend = RPIHAL_SPI_BACKEND_LOOPBACK;
+    const char* devA = "loopback.0";
+    const char* devB = "loopback.1";
+
+    if ((argc == 3) && (strncmp(argv[1], "/dev/", 5) == 0) && (strncmp(argv[2], "/dev/", 5) == 0))
+    {
+        backend = RPIHAL_SPI_BACKEND_SPIDEV;
+        devA = argv[1];
+        devB = argv[2];
+    }
+    else if ((argc > 2) || ((argc == 2) && (strcmp(argv[1], "loopback") != 0)))
+    {
+        printf("usage: %s [loopback|/dev/spidevX.Y /dev/spidevX.Z]\n", argv[0]);
+        return 1;
+    }
+
+    RPIHAL_SPI_instance_t spiA, spiB;
+
+    if ((RPIHAL_SPI_openBackend(&spiA, devA, SPEED, RPIHAL_SPI_CFG_MODE_0, backend) != 0) ||
+        (RPIHAL_SPI_openBackend(&spiB, devB, SPEED / 2, RPIHAL_SPI_CFG_MODE_0, backend) != 0))
+    {
+        printf("failed to open SPI\n");
+        return 1;
+    }
+
+    int err = 0;
+    RPIHAL_SPIQUEUE_instance_t queue;
+    RPIHAL_SPIQUEUE_config_t config;
+    RPIHAL_SPIQUEUE_request_t request;
+    RPIHAL_SPIQUEUE_stats_t stats;
+
+    RPIHAL_SPIQUEUE_defaultConfig(&config);
+    config.capacity = CAPACITY;
+
+    if (RPIHAL_SPIQUEUE_create(&queue, &config) != 0)
+    {
+        printf("failed to create queue\n");
+        return 1;
+    }
+
+    const int fd = RPIHAL_SPIQUEUE_getFd(&queue);
+    uint64_t value;
+
+
+
+    // full queue
+
+    memset(&request, 0, sizeof(request));
+    request.spi = &spiA;
+    request.txData = txSlots[0];
+    request.rxBuffer = rxSlots[0];
+    request.count = 1;
+    request.callback = blockingCallback;
+    request.user = &queue;
+
+    err |= (RPIHAL_SPIQUEUE_submit(&queue, &request) != 0);
+    while (!__atomic_load_n(&blocked, __ATOMIC_ACQUIRE)) { usleep(100); }
+
+    request.callback = NULL;
+    request.user = NULL;
+    for (int i = 0; i < CAPACITY; ++i) { err |= (RPIHAL_SPIQUEUE_submit(&queue, &request) != 0); }
+    if (RPIHAL_SPIQUEUE_submit(&queue, &request) == 0) { err |= 1; }
+
+    __atomic_store_n(&release, 1, __ATOMIC_RELEASE);
+    err |= (RPIHAL_SPIQUEUE_flush(&queue) != 0);
+
+    err |= (RPIHAL_SPIQUEUE_getStats(&queue, &stats) != 0);
+    printf("full queue: submitted %llu, completed %llu, rejected %llu, high water %zu\n", (unsigned long long)stats.submitted,
+           (unsigned long long)stats.completed, (unsigned long long)stats.rejected, stats.highWater);
+    if ((stats.completed != (CAPACITY + 1)) || (stats.rejected != 1) || (stats.highWater != CAPACITY)) { err |= 1; }
+
+    while (read(fd, &value, sizeof(value)) == sizeof(value)) {} // consume the completions
+
+
+
+    // main loop
+
+    RPIHAL_SPI_segment_t segments[N_SLOTS][2];
+    uint64_t nSubmitted = 0;
+    uint64_t nCompleted = 0;
+    uint64_t nLoops = 0;
+    uint64_t nBytes = 0;
+
+    memset(segments, 0, sizeof(segments));
+
+    const uint64_t t0 = now_ns();
+
+    while (nCompleted < N_REQUESTS)
+    {
+        // submit until the queue is full
+        while (nSubmitted < N_REQUESTS)
+        {
+            const size_t slot = nSubmitted % N_SLOTS;
+            const size_t count = 1 + ((nSubmitted * 37) % SLOT_SIZE);
+
+            for (size_t i = 0; i < count; ++i) { txSlots[slot][i] = (uint8_t)(nSubmitted + i); }
+            memset(rxSlots[slot], 0, count);
+
+            memset(&request, 0, sizeof(request));
+            request.spi = ((nSubmitted & 1) ? &spiB : &spiA);
+            request.callback = checkCallback;
+            request.user = (void*)(uintptr_t)nSubmitted;
+
+            if ((nSubmitted % 5) == 0)
+            {
+                // command and payload as one transaction
+                segments[slot][0].txData = txSlots[slot];
+                segments[slot][0].rxBuffer = rxSlots[slot];
+                segments[slot][0].count = (count + 1) / 2;
+                segments[slot][1].txData = txSlots[slot] + segments[slot][0].count;
+                segments[slot][1].rxBuffer = rxSlots[slot] + segments[slot][0].count;
+                segments[slot][1].count = count - segments[slot][0].count;
+
+                request.segments = segments[slot];
+                request.nSegments = 2;
+            }
+            else
+            {
+                request.txData = txSlots[slot];
+                request.rxBuffer = rxSlots[slot];
+                request.count = count;
+            }
+
+            if (RPIHAL_SPIQUEUE_submit(&queue, &request) != 0) { break; }
+
+            ++nSubmitted;
+            nBytes += count;
+        }
+
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        if ((poll(&pfd, 1, 1000) == 1) && (read(fd, &value, sizeof(value)) == sizeof(value))) { nCompleted += value; }
+
+        ++nLoops;
+    }
+
+    const uint64_t t = now_ns() - t0;
+
+    err |= (RPIHAL_SPIQUEUE_getStats(&queue, &stats) != 0);
+    err |= cbErr;
+
+    printf("%llu requests, %llu bytes in %.3f ms, %llu main loop iterations\n", (unsigned long long)nCompleted, (unsigned long long)nBytes, (double)t / 1e6,
+           (unsigned long long)nLoops);
+    printf("errors %llu, high water %zu\n", (unsigned long long)stats.errors, stats.highWater);
+
+    if ((nCallbacks != N_REQUESTS) || (stats.errors != 0)) { err |= 1; }
+
+    err |= (RPIHAL_SPIQUEUE_destroy(&queue) != 0);
+    err |= (RPIHAL_SPI_close(&spiA) != 0);
+    err |= (RPIHAL_SPI_close(&spiB) != 0);
+
+    if (err) { printf("\033[91man error occurred\033[39m\n"); }
+    else { printf("\033[92mOK\033[39m\n"); }
+
+    return (err ? 1 : 0);
+}